@@ -8,6 +8,7 @@
 
 #include <nlohmann/json.hpp>
 #include <thallium.hpp>
+#include <chrono>
 #include <string>
 #include <memory>
 #include <mobject/Exception.hpp>
@@ -80,6 +81,16 @@ class Admin {
      * @brief Check if the Admin instance is valid.
      */
     operator bool() const;
+
+    /**
+     * @brief Sets the deadline of the calls made by this Admin (0, the
+     * default, for no deadline). A call that does not complete in time
+     * throws an Exception; it is not retried, since administrative
+     * operations are not idempotent.
+     *
+     * @param timeout Deadline of each call, relative to its start.
+     */
+    void setTimeout(std::chrono::milliseconds timeout);
     
     /**
      * @brief Creates a sequencer on the target provider.
@@ -191,6 +202,68 @@ class Admin {
                          const UUID& sequencer_id,
                          const std::string& token="") const;
 
+    /**
+     * @brief Moves a sequencer from a provider to another while it
+     * keeps serving requests. The objects are copied in the background;
+     * requests are then held briefly while the last modifications are
+     * copied, after which the source provider redirects clients to the
+     * destination. Existing SequencerHandles follow the redirection
+     * transparently. The replicas of a replicated sequencer are taken
+     * over by the destination, which replicates to them from then on,
+     * and so are the results of the recent appends, WriteOps and
+     * timestamp requests, so that a retry that follows the redirection
+     * is not executed a second time.
+     *
+     * @param address Address of the provider holding the sequencer.
+     * @param provider_id Provider id.
+     * @param sequencer_id UUID of the sequencer to migrate.
+     * @param dest_address Address of the destination provider.
+     * @param dest_provider_id Id of the destination provider.
+     */
+    void migrateSequencer(const std::string& address,
+                          uint16_t provider_id,
+                          const UUID& sequencer_id,
+                          const std::string& dest_address,
+                          uint16_t dest_provider_id,
+                          const std::string& token="") const;
+
+    /**
+     * @brief Promotes the replica of a sequencer held by a backup
+     * provider to a primary, typically after the provider holding the
+     * primary failed. Replicas are created when a sequencer's
+     * configuration has a "replication" section, e.g.
+     * { "replication" : { "backups" : [ { "address" : "...", "provider_id" : 1 } ],
+     *                     "timeout_ms" : 10000 } },
+     * where a backup that does not apply a batch of mutations within
+     * timeout_ms is dropped.
+     * The promoted sequencer has no backup; the remaining replicas of
+     * the old primary should be destroyed with destroySequencer.
+     *
+     * @param address Address of the backup provider.
+     * @param provider_id Provider id.
+     * @param sequencer_id UUID of the sequencer.
+     */
+    void promoteSequencer(const std::string& address,
+                          uint16_t provider_id,
+                          const UUID& sequencer_id,
+                          const std::string& token="") const;
+
+    /**
+     * @brief Returns a JSON-formatted set of statistics about a
+     * provider (see Provider::getStatistics), e.g. the number of
+     * requests of each tenant that were admitted, throttled by their
+     * quota, or rejected because the provider was busy.
+     *
+     * @param address Address of the provider.
+     * @param provider_id Provider id.
+     * @param token Security token.
+     *
+     * @return JSON formatted string.
+     */
+    std::string getStatistics(const std::string& address,
+                              uint16_t provider_id,
+                              const std::string& token="") const;
+
     /**
      * @brief Shuts down the target server. The Thallium engine
      * used by the server must have remote shutdown enabled.
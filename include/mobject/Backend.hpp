@@ -7,6 +7,10 @@
 #define __MOBJECT_BACKEND_HPP
 
 #include <mobject/RequestResult.hpp>
+#include <mobject/WriteOp.hpp>
+#include <string>
+#include <utility>
+#include <vector>
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
@@ -21,6 +25,16 @@ class __MobjectBackendRegistration;
 
 namespace mobject {
 
+/**
+ * @brief Completion of an asynchronous backend operation (see
+ * Backend::writeAsync), to be called exactly once with the result of
+ * the operation. It may be called from any thread, including threads
+ * that are not Argobots ULTs (e.g. those of an I/O library), and
+ * before the asynchronous function returns.
+ */
+template<typename T>
+using Completion = std::function<void(RequestResult<T>)>;
+
 /**
  * @brief Interface for sequencer backends. To build a new backend,
  * implement a class MyBackend that inherits from Backend, and put
@@ -32,6 +46,15 @@ namespace mobject {
  *
  * std::unique_ptr<Backend> create(const json& config)
  * std::unique_ptr<Backend> attach(const json& config)
+ *
+ * The provider calls the asynchronous variants of the operations that
+ * may wait on I/O (writeAsync, readAsync, executeAsync, flushAsync),
+ * which by default call the synchronous ones and complete right away.
+ * Backends that wait on a disk or on remote servers can override them
+ * to start the operation and complete it later, so that waiting
+ * operations do not each hold a handler ULT. The synchronous operations
+ * must still be implemented; they are used by the generic layers (e.g.
+ * "write_back", "gapped"), by the object cache and by migrations.
  */
 class Backend {
     
@@ -82,6 +105,223 @@ class Backend {
      */
     virtual RequestResult<int32_t> computeSum(int32_t x, int32_t y) = 0;
 
+    /**
+     * @brief Computes the element-wise sum of two arrays of integers.
+     * The default implementation uses the vector instructions of the CPU.
+     *
+     * @param x first array
+     * @param y second array
+     * @param result array in which to place the sums
+     * @param count number of elements of each array
+     *
+     * @return a RequestResult<bool> indicating success, which fails
+     * if a sum overflows.
+     */
+    virtual RequestResult<bool> computeSumArray(const int32_t* x,
+                                                const int32_t* y,
+                                                int32_t* result,
+                                                size_t count);
+
+    /**
+     * @brief Writes data into an object, creating the object
+     * if it does not exist. Writing past the end of the object
+     * extends it, filling any hole with zeros.
+     *
+     * @param object Name of the object.
+     * @param offset Offset at which to write.
+     * @param data Data to write.
+     * @param size Size of the data.
+     *
+     * @return a RequestResult<bool> indicating success.
+     */
+    virtual RequestResult<bool> write(const std::string& object,
+                                      uint64_t offset,
+                                      const char* data,
+                                      size_t size) = 0;
+
+    /**
+     * @brief Atomically reserves a range of size bytes at the end of
+     * an object for an append, creating the object if it does not exist.
+     * Successive reservations return contiguous, non-overlapping ranges
+     * even if the data of earlier ones has not been written yet, so that
+     * appenders only serialize on the reservation. The caller is then
+     * responsible for writing the data at the returned offset; a range
+     * that is never written reads as zeros. A range is never handed out
+     * twice, even if the object is truncated below it in the meantime.
+     *
+     * @param object Name of the object.
+     * @param size Number of bytes to reserve.
+     *
+     * @return a RequestResult containing the offset of the reserved range.
+     */
+    virtual RequestResult<uint64_t> reserve(const std::string& object,
+                                            size_t size) = 0;
+
+    /**
+     * @brief Reads data from an object. Reading past the end
+     * of the object results in a short read.
+     *
+     * @param object Name of the object.
+     * @param offset Offset at which to read.
+     * @param data Buffer in which to place the data.
+     * @param size Size of the buffer.
+     *
+     * @return a RequestResult containing the number of bytes read.
+     */
+    virtual RequestResult<size_t> read(const std::string& object,
+                                       uint64_t offset,
+                                       char* data,
+                                       size_t size) = 0;
+
+    /**
+     * @brief Removes an object.
+     *
+     * @param object Name of the object.
+     *
+     * @return a RequestResult<bool> indicating success.
+     */
+    virtual RequestResult<bool> remove(const std::string& object) = 0;
+
+    /**
+     * @brief Lists the names of the objects starting with a given
+     * prefix, in lexicographical order. Backends should only hold
+     * locks while collecting the requested page, so that listing
+     * large namespaces does not stall writers.
+     *
+     * @param prefix Prefix of the names to list.
+     * @param start_after Only list names strictly greater than this one.
+     * @param max Maximum number of names to return.
+     *
+     * @return a RequestResult containing the names.
+     */
+    virtual RequestResult<std::vector<std::string>> listObjects(
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) = 0;
+
+    /**
+     * @brief Sets key/value pairs in the omap (sorted key/value
+     * attributes) of an object, creating the object if it does not
+     * exist. Existing keys are overwritten. If a key appears several
+     * times, the last value wins.
+     *
+     * @param object Name of the object.
+     * @param entries Key/value pairs to set.
+     *
+     * @return a RequestResult<bool> indicating success.
+     */
+    virtual RequestResult<bool> omapSet(const std::string& object,
+                                        const std::vector<std::pair<std::string, std::string>>& entries) = 0;
+
+    /**
+     * @brief Gets the values associated with a set of keys in the
+     * omap of an object. Keys that are not present are ignored.
+     *
+     * @param object Name of the object.
+     * @param keys Keys to look up.
+     *
+     * @return a RequestResult containing the key/value pairs found,
+     * sorted by key.
+     */
+    virtual RequestResult<std::vector<std::pair<std::string, std::string>>> omapGet(
+            const std::string& object,
+            const std::vector<std::string>& keys) = 0;
+
+    /**
+     * @brief Removes a set of keys from the omap of an object.
+     * Keys that are not present are ignored.
+     *
+     * @param object Name of the object.
+     * @param keys Keys to remove.
+     *
+     * @return a RequestResult<bool> indicating success.
+     */
+    virtual RequestResult<bool> omapRemove(const std::string& object,
+                                           const std::vector<std::string>& keys) = 0;
+
+    /**
+     * @brief Lists the key/value pairs of the omap of an object whose
+     * key starts with a given prefix, in key order.
+     *
+     * @param object Name of the object.
+     * @param prefix Prefix of the keys to list.
+     * @param start_after Only list keys strictly greater than this one.
+     * @param max Maximum number of pairs to return.
+     *
+     * @return a RequestResult containing the key/value pairs.
+     */
+    virtual RequestResult<std::vector<std::pair<std::string, std::string>>> omapScan(
+            const std::string& object,
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) = 0;
+
+    /**
+     * @brief Applies a WriteOp to an object atomically: either the
+     * preconditions hold and all the steps are applied, or the
+     * object is left unchanged and an error is returned.
+     *
+     * @param object Name of the object.
+     * @param op Operation to apply.
+     *
+     * @return a RequestResult containing the version of the object
+     * after the operation.
+     */
+    virtual RequestResult<uint64_t> execute(const std::string& object,
+                                            const WriteOp& op) = 0;
+
+    /**
+     * @brief Makes sure all the writes issued so far are persisted.
+     * The default implementation does nothing, which is correct for
+     * backends that do not buffer writes.
+     *
+     * @return a RequestResult<bool> indicating success.
+     */
+    virtual RequestResult<bool> flush() {
+        return RequestResult<bool>();
+    }
+
+    /**
+     * @brief Asynchronous variant of write. The data remains valid
+     * until done is called.
+     */
+    virtual void writeAsync(const std::string& object,
+                            uint64_t offset,
+                            const char* data,
+                            size_t size,
+                            Completion<bool> done) {
+        done(write(object, offset, data, size));
+    }
+
+    /**
+     * @brief Asynchronous variant of read. The buffer remains valid
+     * until done is called.
+     */
+    virtual void readAsync(const std::string& object,
+                           uint64_t offset,
+                           char* data,
+                           size_t size,
+                           Completion<size_t> done) {
+        done(read(object, offset, data, size));
+    }
+
+    /**
+     * @brief Asynchronous variant of execute. The WriteOp remains
+     * valid until done is called.
+     */
+    virtual void executeAsync(const std::string& object,
+                              const WriteOp& op,
+                              Completion<uint64_t> done) {
+        done(execute(object, op));
+    }
+
+    /**
+     * @brief Asynchronous variant of flush.
+     */
+    virtual void flushAsync(Completion<bool> done) {
+        done(flush());
+    }
+
     /**
      * @brief Destroys the underlying sequencer.
      *
@@ -136,6 +376,15 @@ class SequencerFactory {
 
     private:
 
+    /**
+     * @brief Wraps a newly created or opened backend into the
+     * generic layers requested by its configuration (e.g. "write_back",
+     * "gapped").
+     */
+    static std::unique_ptr<Backend> wrap(std::unique_ptr<Backend>&& backend,
+                                         const thallium::engine& engine,
+                                         const json& config);
+
     static std::unordered_map<std::string,
                 std::function<std::unique_ptr<Backend>(const thallium::engine&, const json&)>> create_fn;
     
@@ -9,6 +9,7 @@
 #include <mobject/SequencerHandle.hpp>
 #include <mobject/UUID.hpp>
 #include <thallium.hpp>
+#include <chrono>
 #include <memory>
 
 namespace mobject {
@@ -92,6 +93,72 @@ class Client {
                                       const UUID& sequencer_id,
                                       bool check = true) const;
 
+    /**
+     * @brief Sets the default deadline of the calls made through the
+     * SequencerHandles of this client (0, the default, for no deadline).
+     * A call that does not complete in time throws an Exception. The
+     * remaining time is sent with each request, so that providers do not
+     * execute requests the client stopped waiting for.
+     *
+     * @param timeout Deadline of each call, relative to its start.
+     */
+    void setTimeout(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Sets how calls are retried when they time out. Each attempt
+     * is limited to attempt_timeout (0 for the call's deadline only). When
+     * an attempt times out, the request is sent again after a random
+     * delay between 0 and backoff, doubled after each retry, at most
+     * max_retries times and within the call's deadline. Only idempotent
+     * requests and requests that providers de-duplicate (appends,
+     * WriteOps, timestamps) are retried. By default, calls are not retried.
+     *
+     * @param max_retries Maximum number of retries of a call.
+     * @param attempt_timeout Timeout of each attempt.
+     * @param backoff Maximum delay before the first retry.
+     */
+    void setRetryPolicy(unsigned max_retries,
+                        std::chrono::milliseconds attempt_timeout,
+                        std::chrono::milliseconds backoff = std::chrono::milliseconds(10));
+
+    /**
+     * @brief Enables hedged reads on the handles that know the replicas
+     * of their sequencer (see SequencerHandle::withReplicas). A blocking
+     * read that has not completed after the given percentile of the
+     * latencies of recent reads (and at least min_delay) is sent again
+     * to a replica; the first response is used and the other discarded.
+     * A percentile of 0 disables hedging, which is the default.
+     *
+     * @param percentile Percentile of read latencies after which reads are hedged.
+     * @param min_delay Minimum delay before a read is hedged.
+     */
+    void setHedgingPolicy(double percentile,
+                          std::chrono::milliseconds min_delay = std::chrono::milliseconds(1));
+
+    /**
+     * @brief Sets the tenant the requests of this client are made for.
+     * Providers configured with tenants (see the "admission" section of
+     * their configuration) share their capacity among tenants according
+     * to their weights and enforce their quotas. Requests without a
+     * tenant, or of a tenant the provider does not know, are accounted
+     * to the "default" tenant.
+     *
+     * @param tenant Name of the tenant.
+     * @param token Token of the tenant, if the providers require one.
+     */
+    void setTenant(const std::string& tenant, const std::string& token = "");
+
+    /**
+     * @brief Sets the number of posted operations (see
+     * SequencerHandle::withPosting) that may be outstanding on each
+     * sequencer, which bounds the memory holding the copies of their
+     * data. Posting an operation when this many are outstanding first
+     * waits for the provider to apply them. The default is 256.
+     *
+     * @param window Maximum number of outstanding posted operations.
+     */
+    void setPostedWindow(size_t window);
+
     /**
      * @brief Checks that the Client instance is valid.
      */
@@ -24,7 +24,22 @@ class Provider {
     public:
 
     /**
-     * @brief Constructor.
+     * @brief Constructor. The configuration may contain a "cache"
+     * object enabling a provider-wide cache of object data, e.g.
+     * { "cache" : { "capacity" : 67108864, "block_size" : 65536,
+     *               "shards" : 16, "policy" : "arc" } }
+     * where capacity is in bytes and policy is "arc" or "lru".
+     * It may also contain a "lanes" object running admin, control
+     * and data RPCs in separate pools with their own xstreams, e.g.
+     * { "lanes" : { "admin" : { "xstreams" : 1, "priority" : 0 },
+     *               "data"  : { "xstreams" : 4, "priority" : 2 } } }
+     * so that slow sequencer lifecycle operations do not delay data operations.
+     * A "limits" object bounds what a single request may ask the provider
+     * for, e.g. { "limits" : { "max_list_page" : 1024, "max_request_size" : 1073741824 } },
+     * where max_list_page is the number of names a listObjects RPC returns
+     * at most (clients fetch longer listings with several RPCs) and
+     * max_request_size the number of bytes a single read, write or append
+     * may transfer (1 GiB by default); larger requests are rejected.
      *
      * @param engine Thallium engine to use to receive RPCs.
      * @param provider_id Provider id.
@@ -89,6 +104,16 @@ class Provider {
      */
     std::string getConfig() const;
 
+    /**
+     * @brief Return a JSON-formatted set of statistics
+     * (e.g. object cache hits and misses, requests admitted,
+     * throttled and rejected per tenant, backups of each replicated
+     * sequencer and backups dropped after failing) about the provider.
+     *
+     * @return JSON formatted string.
+     */
+    std::string getStatistics() const;
+
     /**
      * @brief Checks whether the Provider instance is valid.
      */
@@ -6,6 +6,7 @@
 #ifndef __MOBJECT_REQUEST_RESULT_HPP
 #define __MOBJECT_REQUEST_RESULT_HPP
 
+#include <cstdint>
 #include <string>
 
 namespace mobject {
@@ -18,6 +19,15 @@ namespace mobject {
  * - error must be set to an error string if an error occured
  * - value must be set to the result of the request if it succeeded
  *
+ * If the request was addressed to a sequencer that has migrated
+ * to another provider, success is false and the redirect fields
+ * (redirectAddress, redirectProviderId) indicate where the sequencer
+ * now lives, so that clients can follow it transparently.
+ *
+ * If the provider was too busy to accept the request, success is false
+ * and retryAfter is the number of milliseconds after which the client
+ * may send the request again. The request had no effect.
+ *
  * This class is specialized for two types: bool and std::string.
  * If bool is used, both the value and the success fields will be
  * managed by the same underlying variable. If std::string is used,
@@ -79,6 +89,66 @@ class RequestResult {
         return m_value;
     }
 
+    /**
+     * @brief Address of the provider to retry the request on, if the
+     * sequencer has moved (empty otherwise).
+     */
+    std::string& redirectAddress() {
+        return m_redirect_address;
+    }
+
+    /**
+     * @brief Address of the provider to retry the request on, if the
+     * sequencer has moved (empty otherwise).
+     */
+    const std::string& redirectAddress() const {
+        return m_redirect_address;
+    }
+
+    /**
+     * @brief Id of the provider to retry the request on, if the sequencer has moved.
+     */
+    uint16_t& redirectProviderId() {
+        return m_redirect_provider_id;
+    }
+
+    /**
+     * @brief Id of the provider to retry the request on, if the sequencer has moved.
+     */
+    const uint16_t& redirectProviderId() const {
+        return m_redirect_provider_id;
+    }
+
+    /**
+     * @brief Whether the request should be retried on another provider.
+     */
+    bool redirected() const {
+        return !m_redirect_address.empty();
+    }
+
+    /**
+     * @brief Delay (in milliseconds) after which the request may be sent
+     * again, if the provider rejected it because it was busy (0 otherwise).
+     */
+    uint32_t& retryAfter() {
+        return m_retry_after;
+    }
+
+    /**
+     * @brief Delay (in milliseconds) after which the request may be sent
+     * again, if the provider rejected it because it was busy (0 otherwise).
+     */
+    const uint32_t& retryAfter() const {
+        return m_retry_after;
+    }
+
+    /**
+     * @brief Whether the provider rejected the request because it was busy.
+     */
+    bool busy() const {
+        return m_retry_after != 0;
+    }
+
     /**
      * @brief Serialization function for Thallium.
      *
@@ -90,6 +160,9 @@ class RequestResult {
         a & m_success;
         a & m_error;
         a & m_value;
+        a & m_redirect_address;
+        a & m_redirect_provider_id;
+        a & m_retry_after;
     }
 
     private:
@@ -97,6 +170,9 @@ class RequestResult {
     bool        m_success = true;
     std::string m_error   = "";
     T           m_value;
+    std::string m_redirect_address;
+    uint16_t    m_redirect_provider_id = 0;
+    uint32_t    m_retry_after = 0;
 };
 
 template<>
@@ -134,16 +210,54 @@ class RequestResult<std::string> {
         return m_content;
     }
 
+    std::string& redirectAddress() {
+        return m_redirect_address;
+    }
+
+    const std::string& redirectAddress() const {
+        return m_redirect_address;
+    }
+
+    uint16_t& redirectProviderId() {
+        return m_redirect_provider_id;
+    }
+
+    const uint16_t& redirectProviderId() const {
+        return m_redirect_provider_id;
+    }
+
+    bool redirected() const {
+        return !m_redirect_address.empty();
+    }
+
+    uint32_t& retryAfter() {
+        return m_retry_after;
+    }
+
+    const uint32_t& retryAfter() const {
+        return m_retry_after;
+    }
+
+    bool busy() const {
+        return m_retry_after != 0;
+    }
+
     template<typename Archive>
     void serialize(Archive& a) {
         a & m_success;
         a & m_content;
+        a & m_redirect_address;
+        a & m_redirect_provider_id;
+        a & m_retry_after;
     }
 
     private:
 
     bool        m_success = true;
     std::string m_content = "";
+    std::string m_redirect_address;
+    uint16_t    m_redirect_provider_id = 0;
+    uint32_t    m_retry_after = 0;
 };
 
 template<>
@@ -181,16 +295,54 @@ class RequestResult<bool> {
         return m_success;
     }
 
+    std::string& redirectAddress() {
+        return m_redirect_address;
+    }
+
+    const std::string& redirectAddress() const {
+        return m_redirect_address;
+    }
+
+    uint16_t& redirectProviderId() {
+        return m_redirect_provider_id;
+    }
+
+    const uint16_t& redirectProviderId() const {
+        return m_redirect_provider_id;
+    }
+
+    bool redirected() const {
+        return !m_redirect_address.empty();
+    }
+
+    uint32_t& retryAfter() {
+        return m_retry_after;
+    }
+
+    const uint32_t& retryAfter() const {
+        return m_retry_after;
+    }
+
+    bool busy() const {
+        return m_retry_after != 0;
+    }
+
     template<typename Archive>
     void serialize(Archive& a) {
         a & m_success;
         a & m_error;
+        a & m_redirect_address;
+        a & m_redirect_provider_id;
+        a & m_retry_after;
     }
 
     private:
 
     bool        m_success = true;
     std::string m_error   = "";
+    std::string m_redirect_address;
+    uint16_t    m_redirect_provider_id = 0;
+    uint32_t    m_retry_after = 0;
 };
 
 }
@@ -0,0 +1,151 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_ROUTER_HPP
+#define __MOBJECT_ROUTER_HPP
+
+#include <mobject/Client.hpp>
+#include <mobject/SequencerHandle.hpp>
+#include <mobject/UUID.hpp>
+#include <memory>
+#include <string>
+
+namespace mobject {
+
+class RouterImpl;
+
+/**
+ * @brief A Router places objects on a set of sequencers (its members),
+ * possibly spread across many providers, so that applications do not
+ * have to pick an address, provider id and sequencer UUID themselves.
+ *
+ * Placement uses consistent hashing: each member is assigned
+ * "virtual_nodes" points on a hash ring, and an object belongs to the
+ * member owning the first point following the hash of its name. This
+ * spreads objects evenly, and adding or removing a member only moves
+ * the objects that belong (or belonged) to that member.
+ *
+ * The configuration is a JSON object, e.g.
+ * {
+ *   "virtual_nodes" : 128,
+ *   "members" : [
+ *     { "address" : "na+sm://123-0", "provider_id" : 0,
+ *       "sequencer_id" : "5f3c52a8-5de4-4a7b-a6f6-3b3e4c9b0d21" },
+ *     ...
+ *   ]
+ * }
+ * All the clients must use the same members and the same number of
+ * virtual nodes to agree on placement.
+ *
+ * Membership changes (addMember, removeMember) must not be issued
+ * concurrently with other calls on the same Router.
+ */
+class Router {
+
+    public:
+
+    /**
+     * @brief Constructor. The resulting Router will be invalid.
+     */
+    Router();
+
+    /**
+     * @brief Constructor. Throws an Exception if the configuration is
+     * invalid or if a member's sequencer cannot be reached.
+     *
+     * @param client Client used to create the SequencerHandles.
+     * @param config JSON configuration.
+     */
+    Router(const Client& client, const std::string& config);
+
+    /**
+     * @brief Copy-constructor.
+     */
+    Router(const Router&);
+
+    /**
+     * @brief Move-constructor.
+     */
+    Router(Router&&);
+
+    /**
+     * @brief Copy-assignment operator.
+     */
+    Router& operator=(const Router&);
+
+    /**
+     * @brief Move-assignment operator.
+     */
+    Router& operator=(Router&&);
+
+    /**
+     * @brief Destructor.
+     */
+    ~Router();
+
+    /**
+     * @brief Checks if the Router instance is valid.
+     */
+    operator bool() const;
+
+    /**
+     * @brief Returns the configuration of the Router,
+     * including its current members.
+     */
+    std::string getConfig() const;
+
+    /**
+     * @brief Adds a sequencer to the members.
+     *
+     * @param address Address of the provider holding the sequencer.
+     * @param provider_id Provider id.
+     * @param sequencer_id Sequencer UUID.
+     * @param check Checks if the sequencer exists by issuing an RPC.
+     */
+    void addMember(const std::string& address,
+                   uint16_t provider_id,
+                   const UUID& sequencer_id,
+                   bool check = true);
+
+    /**
+     * @brief Removes a sequencer from the members.
+     *
+     * @param sequencer_id Sequencer UUID.
+     */
+    void removeMember(const UUID& sequencer_id);
+
+    /**
+     * @brief Returns the number of members.
+     */
+    size_t numMembers() const;
+
+    /**
+     * @brief Returns the handle of the sequencer an object is placed on.
+     * Throws an Exception if the Router has no members.
+     *
+     * @param object Name of the object.
+     *
+     * @return the SequencerHandle to use for this object.
+     */
+    SequencerHandle route(const std::string& object) const;
+
+    /**
+     * @brief Returns the UUID of the sequencer an object is placed on.
+     * Throws an Exception if the Router has no members.
+     *
+     * @param object Name of the object.
+     *
+     * @return the UUID of the sequencer.
+     */
+    UUID locate(const std::string& object) const;
+
+    private:
+
+    std::shared_ptr<RouterImpl> self;
+};
+
+}
+
+#endif
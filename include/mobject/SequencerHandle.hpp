@@ -7,12 +7,17 @@
 #define __MOBJECT_SEQUENCER_HANDLE_HPP
 
 #include <thallium.hpp>
+#include <chrono>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 #include <unordered_set>
 #include <nlohmann/json.hpp>
 #include <mobject/Client.hpp>
 #include <mobject/Exception.hpp>
 #include <mobject/AsyncRequest.hpp>
+#include <mobject/WriteOp.hpp>
 
 namespace mobject {
 
@@ -21,6 +26,19 @@ namespace tl = thallium;
 class Client;
 class SequencerHandleImpl;
 
+/**
+ * @brief Priority class of the requests made through a SequencerHandle.
+ * Providers that schedule requests by deadline (see the "admission"
+ * section of the provider configuration) run waiting INTERACTIVE
+ * requests before NORMAL ones, and NORMAL ones before BATCH ones,
+ * unless the latter have been waiting for long or have an earlier deadline.
+ */
+enum class Priority : uint8_t {
+    INTERACTIVE = 0,
+    NORMAL      = 1,
+    BATCH       = 2
+};
+
 /**
  * @brief A SequencerHandle object is a handle for a remote sequencer
  * on a server. It enables invoking the sequencer's functionalities.
@@ -72,6 +90,52 @@ class SequencerHandle {
      */
     operator bool() const;
 
+    /**
+     * @brief Returns a handle to the same sequencer whose calls have
+     * the provided deadline instead of the client's default (see
+     * Client::setTimeout), e.g. h.withTimeout(std::chrono::milliseconds(50)).read(...).
+     *
+     * @param timeout Deadline of each call, relative to its start (0 for none).
+     */
+    SequencerHandle withTimeout(std::chrono::milliseconds timeout) const;
+
+    /**
+     * @brief Returns a handle to the same sequencer that knows the
+     * providers holding replicas of it (the "backups" of its
+     * "replication" configuration). If hedging is enabled on the client
+     * (see Client::setHedgingPolicy), slow blocking reads made through
+     * this handle are sent again to one of the replicas.
+     *
+     * @param replicas Address and provider id of each replica.
+     */
+    SequencerHandle withReplicas(
+            const std::vector<std::pair<std::string, uint16_t>>& replicas) const;
+
+    /**
+     * @brief Returns a handle to the same sequencer whose requests have
+     * the given priority class (NORMAL by default).
+     *
+     * @param priority Priority class of the requests.
+     */
+    SequencerHandle withPriority(Priority priority) const;
+
+    /**
+     * @brief Returns a handle to the same sequencer whose writes and
+     * appends are posted: the data is copied, and the request is sent
+     * without waiting for a response, so the call returns as soon as the
+     * request is on its way and the data buffer can be reused. The
+     * provider pulls the copy when it applies the operation; the client
+     * keeps it until the next flush() or until the window is drained.
+     * The provider applies the posted operations of a client in the
+     * order they were posted. Their errors are reported by the next
+     * call to flush() on any handle to the sequencer, which returns once
+     * all the operations posted before it have been applied. Posted
+     * appends do not return their offset, and posted operations cannot
+     * be made non-blocking with an AsyncRequest (see Client::setPostedWindow
+     * for the number of operations that may be outstanding).
+     */
+    SequencerHandle withPosting() const;
+
     /**
      * @brief Sends an RPC to the sequencer to make it print a hello message.
      */
@@ -92,6 +156,209 @@ class SequencerHandle {
                     int32_t* result = nullptr,
                     AsyncRequest* req = nullptr) const;
 
+    /**
+     * @brief Requests the target sequencer to compute the element-wise
+     * sum of two arrays, result[i] = x[i] + y[i], in a single RPC. The
+     * arrays are transferred with RDMA. Throws if a sum overflows. If req
+     * is not null, this call will be non-blocking and the arrays must
+     * remain valid until the request completes.
+     *
+     * @param[in] x first array
+     * @param[in] y second array
+     * @param[out] result array in which to place the sums
+     * @param[in] count number of elements of each array
+     * @param[out] req request for a non-blocking operation
+     */
+    void computeSumArray(const int32_t* x, const int32_t* y,
+                         int32_t* result, size_t count,
+                         AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Writes data into an object, creating the object if it
+     * does not exist. If req is not null, this call will be non-blocking
+     * and the data buffer must remain valid until the request completes.
+     *
+     * @param[in] object Name of the object.
+     * @param[in] offset Offset at which to write.
+     * @param[in] data Data to write.
+     * @param[in] size Size of the data.
+     * @param[out] req request for a non-blocking operation
+     */
+    void write(const std::string& object,
+               uint64_t offset,
+               const char* data,
+               size_t size,
+               AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Appends data to an object, creating the object if it does
+     * not exist. The offset at which the data is placed is chosen by the
+     * sequencer, so that concurrent appenders never overwrite each other.
+     * If offset is null, it will be ignored. If req is not null, this call
+     * will be non-blocking and the data buffer must remain valid until
+     * the request completes.
+     *
+     * @param[in] object Name of the object.
+     * @param[in] data Data to append.
+     * @param[in] size Size of the data.
+     * @param[out] offset Offset at which the data was appended.
+     * @param[out] req request for a non-blocking operation
+     */
+    void append(const std::string& object,
+                const char* data,
+                size_t size,
+                uint64_t* offset = nullptr,
+                AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Reads data from an object. Reading past the end of the
+     * object results in a short read. If bytes_read is null, it will be
+     * ignored. If req is not null, this call will be non-blocking and
+     * the caller is responsible for waiting on the request.
+     *
+     * @param[in] object Name of the object.
+     * @param[in] offset Offset at which to read.
+     * @param[out] data Buffer in which to place the data.
+     * @param[in] size Size of the buffer.
+     * @param[out] bytes_read Number of bytes actually read.
+     * @param[out] req request for a non-blocking operation
+     */
+    void read(const std::string& object,
+              uint64_t offset,
+              char* data,
+              size_t size,
+              size_t* bytes_read = nullptr,
+              AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Removes an object.
+     *
+     * @param[in] object Name of the object.
+     */
+    void remove(const std::string& object) const;
+
+    /**
+     * @brief Forces the sequencer to write any buffered data
+     * (e.g. from its write-back buffer) to its storage, after waiting
+     * for the operations posted to it (see withPosting) to be applied.
+     * Throws if any of these posted operations failed.
+     */
+    void flush() const;
+
+    /**
+     * @brief Lists the names of the objects starting with a given prefix,
+     * in lexicographical order. At most max names are returned; to get
+     * the next page, call listObjects again with start_after set to the
+     * last name returned. An empty result indicates the end of the listing.
+     *
+     * @param[in] prefix Prefix of the names to list.
+     * @param[in] start_after Only list names strictly greater than this one.
+     * @param[in] max Maximum number of names to return.
+     *
+     * @return the names of the objects.
+     */
+    std::vector<std::string> listObjects(const std::string& prefix = "",
+                                         const std::string& start_after = "",
+                                         size_t max = 1024) const;
+
+    /**
+     * @brief Sets key/value pairs in the omap (sorted key/value attributes)
+     * of an object, creating the object if it does not exist. All the pairs
+     * are sent in a single RPC.
+     *
+     * @param[in] object Name of the object.
+     * @param[in] entries Key/value pairs to set.
+     */
+    void omapSet(const std::string& object,
+                 const std::vector<std::pair<std::string, std::string>>& entries) const;
+
+    /**
+     * @brief Gets the values associated with a set of keys in the omap
+     * of an object. Keys that are not present are omitted from the result.
+     *
+     * @param[in] object Name of the object.
+     * @param[in] keys Keys to look up.
+     *
+     * @return the key/value pairs found, sorted by key.
+     */
+    std::vector<std::pair<std::string, std::string>> omapGet(
+            const std::string& object,
+            const std::vector<std::string>& keys) const;
+
+    /**
+     * @brief Removes a set of keys from the omap of an object.
+     *
+     * @param[in] object Name of the object.
+     * @param[in] keys Keys to remove.
+     */
+    void omapRemove(const std::string& object,
+                    const std::vector<std::string>& keys) const;
+
+    /**
+     * @brief Lists the key/value pairs of the omap of an object whose key
+     * starts with a given prefix, in key order. Paging works as in listObjects.
+     *
+     * @param[in] object Name of the object.
+     * @param[in] prefix Prefix of the keys to list.
+     * @param[in] start_after Only list keys strictly greater than this one.
+     * @param[in] max Maximum number of pairs to return.
+     *
+     * @return the key/value pairs.
+     */
+    std::vector<std::pair<std::string, std::string>> omapScan(
+            const std::string& object,
+            const std::string& prefix = "",
+            const std::string& start_after = "",
+            size_t max = 1024) const;
+
+    /**
+     * @brief Sends a WriteOp to the sequencer, which applies all its
+     * steps to the object atomically, in a single RPC. Throws an
+     * Exception if a precondition of the operation does not hold,
+     * in which case the object is left unchanged.
+     *
+     * @param[in] object Name of the object.
+     * @param[in] op Operation to apply.
+     *
+     * @return the version of the object after the operation.
+     */
+    uint64_t execute(const std::string& object,
+                     const WriteOp& op) const;
+
+    /**
+     * @brief Waits until one of the provided objects changes. Each object
+     * is given with the version the caller knows (as returned by execute,
+     * 0 for an object that does not exist). The call returns as soon as
+     * the version of one of them is different, with the objects that
+     * changed and their new version, or with an empty vector after
+     * timeout_ms milliseconds. Modifications made in a short burst are
+     * reported by a single call. Throws an Exception if more objects are
+     * listed than the provider accepts ("max_objects" in the "watch"
+     * section of its configuration, 1024 by default).
+     *
+     * @param[in] objects Objects to watch, with their known version.
+     * @param[in] timeout_ms Maximum time to wait, in milliseconds.
+     *
+     * @return the objects whose version changed, with their new version.
+     */
+    std::vector<std::pair<std::string, uint64_t>> watch(
+            const std::vector<std::pair<std::string, uint64_t>>& objects,
+            uint32_t timeout_ms = 30000) const;
+
+    /**
+     * @brief Gets timestamps from a sequencer configured as a timestamp
+     * oracle (with a "timestamps" section in its configuration). The
+     * count timestamps returned are consecutive and greater than any
+     * timestamp previously issued by the sequencer, even across
+     * restarts. Asking for many timestamps in one call is much cheaper
+     * than issuing many calls.
+     *
+     * @param[in] count Number of timestamps to get.
+     *
+     * @return the first timestamp; the others follow it.
+     */
+    uint64_t timestamps(size_t count = 1) const;
+
     private:
 
     /**
@@ -0,0 +1,136 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_STRIPED_HANDLE_HPP
+#define __MOBJECT_STRIPED_HANDLE_HPP
+
+#include <mobject/SequencerHandle.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mobject {
+
+class StripedHandleImpl;
+
+/**
+ * @brief A StripedHandle spreads objects across the sequencers of
+ * several SequencerHandles (typically on different providers) so
+ * that I/O on a single large object benefits from the aggregate
+ * bandwidth of many servers.
+ *
+ * Objects are split into stripe units that are assigned round-robin
+ * to "stripe_width" sequencers, starting at a sequencer chosen by
+ * hashing the object's name so that different objects start on
+ * different servers. The part of an object stored on each sequencer
+ * is an object of the same name, which only exists once a write has
+ * touched one of the stripe units of that sequencer. Reads and writes issue the transfers
+ * of all the stripe units they touch in parallel, with at most
+ * "max_in_flight" transfers outstanding at any time.
+ *
+ * The configuration is a JSON object, e.g.
+ * { "stripe_unit" : 1048576, "stripe_width" : 4, "max_in_flight" : 64 }
+ * stripe_width defaults to the number of sequencers. All the clients
+ * accessing an object must use the same sequencers, in the same order,
+ * and the same configuration.
+ */
+class StripedHandle {
+
+    public:
+
+    /**
+     * @brief Constructor. The resulting StripedHandle will be invalid.
+     */
+    StripedHandle();
+
+    /**
+     * @brief Constructor. Throws an Exception if the configuration is invalid.
+     *
+     * @param sequencers Handles of distinct sequencers across which to stripe.
+     * @param config JSON configuration.
+     */
+    StripedHandle(const std::vector<SequencerHandle>& sequencers,
+                  const std::string& config = "{}");
+
+    /**
+     * @brief Copy-constructor.
+     */
+    StripedHandle(const StripedHandle&);
+
+    /**
+     * @brief Move-constructor.
+     */
+    StripedHandle(StripedHandle&&);
+
+    /**
+     * @brief Copy-assignment operator.
+     */
+    StripedHandle& operator=(const StripedHandle&);
+
+    /**
+     * @brief Move-assignment operator.
+     */
+    StripedHandle& operator=(StripedHandle&&);
+
+    /**
+     * @brief Destructor.
+     */
+    ~StripedHandle();
+
+    /**
+     * @brief Checks if the StripedHandle instance is valid.
+     */
+    operator bool() const;
+
+    /**
+     * @brief Returns the configuration of the StripedHandle,
+     * with default values filled in.
+     */
+    std::string getConfig() const;
+
+    /**
+     * @brief Writes data into a striped object, creating it if needed.
+     *
+     * @param[in] object Name of the object.
+     * @param[in] offset Offset at which to write.
+     * @param[in] data Data to write.
+     * @param[in] size Size of the data.
+     */
+    void write(const std::string& object,
+               uint64_t offset,
+               const char* data,
+               size_t size) const;
+
+    /**
+     * @brief Reads data from a striped object. Reading past the end
+     * of the object results in a short read, and holes read as zeros.
+     *
+     * @param[in] object Name of the object.
+     * @param[in] offset Offset at which to read.
+     * @param[out] data Buffer in which to place the data.
+     * @param[in] size Size of the buffer.
+     * @param[out] bytes_read Number of bytes actually read.
+     */
+    void read(const std::string& object,
+              uint64_t offset,
+              char* data,
+              size_t size,
+              size_t* bytes_read = nullptr) const;
+
+    /**
+     * @brief Removes a striped object from all the sequencers holding it.
+     *
+     * @param[in] object Name of the object.
+     */
+    void remove(const std::string& object) const;
+
+    private:
+
+    std::shared_ptr<StripedHandleImpl> self;
+};
+
+}
+
+#endif
@@ -9,6 +9,7 @@
 #include <uuid/uuid.h>
 #include <string>
 #include <cstring>
+#include <stdexcept>
 
 namespace mobject {
 
@@ -0,0 +1,239 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_WRITE_OP_HPP
+#define __MOBJECT_WRITE_OP_HPP
+
+#include <thallium/serialization/stl/string.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+#include <thallium/serialization/stl/pair.hpp>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mobject {
+
+/**
+ * @brief A WriteOp groups several modifications of a single object
+ * that are sent in one RPC and applied atomically by the backend:
+ * either all of them are applied, or none is.
+ *
+ * Preconditions (create, assertVersion) are checked first, then the
+ * steps (write, truncate, omapSet, omapRemove) are applied in the order
+ * in which they were added. Every object has a version number, which
+ * is 0 for objects that do not exist and is incremented by each
+ * operation that modifies the object, so assertVersion can be used to
+ * implement compare-and-set.
+ *
+ * Data written by a WriteOp is sent inline in the RPC, so WriteOps are
+ * meant for small updates; large data should be sent with
+ * SequencerHandle::write.
+ *
+ * Example:
+ * @code
+ * mobject::WriteOp op;
+ * op.create()
+ *   .assertVersion(3)
+ *   .write(0, "header")
+ *   .omapSet({{"state", "ready"}});
+ * uint64_t version = sequencer.execute("myobject", op);
+ * @endcode
+ */
+class WriteOp {
+
+    public:
+
+    /**
+     * @brief Type of a step.
+     */
+    enum StepType : uint8_t {
+        WRITE       = 0,
+        TRUNCATE    = 1,
+        OMAP_SET    = 2,
+        OMAP_REMOVE = 3
+    };
+
+    /**
+     * @brief A modification to apply to the object. Only the fields
+     * relevant to the step's type are used.
+     */
+    struct Step {
+        uint8_t                                          type = WRITE;
+        uint64_t                                         offset = 0; // offset for WRITE, size for TRUNCATE
+        std::string                                      data;
+        std::vector<std::pair<std::string, std::string>> entries;
+        std::vector<std::string>                         keys;
+
+        template<typename Archive>
+        void serialize(Archive& a) {
+            a & type;
+            a & offset;
+            a & data;
+            a & entries;
+            a & keys;
+        }
+    };
+
+    /**
+     * @brief Creates the object if it does not exist. If exclusive
+     * is true, the operation fails if the object already exists.
+     */
+    WriteOp& create(bool exclusive = false) {
+        m_create = true;
+        m_exclusive = m_exclusive || exclusive;
+        return *this;
+    }
+
+    /**
+     * @brief Makes the operation fail unless the version of the
+     * object is the provided one (0 for an object that does not exist).
+     */
+    WriteOp& assertVersion(uint64_t version) {
+        m_assert_version = true;
+        m_version = version;
+        return *this;
+    }
+
+    /**
+     * @brief Sets the version of the object after the operation to
+     * the provided value instead of incrementing it. This is meant for
+     * copying objects between sequencers (e.g. when migrating) without
+     * breaking the compare-and-set of clients holding a version.
+     */
+    WriteOp& setVersion(uint64_t version) {
+        m_set_version = true;
+        m_new_version = version;
+        return *this;
+    }
+
+    /**
+     * @brief Writes data at a given offset, extending the object
+     * with zeros if needed.
+     */
+    WriteOp& write(uint64_t offset, const char* data, size_t size) {
+        Step step;
+        step.type = WRITE;
+        step.offset = offset;
+        step.data.assign(data, size);
+        m_steps.push_back(std::move(step));
+        return *this;
+    }
+
+    /**
+     * @brief Writes data at a given offset, extending the object
+     * with zeros if needed.
+     */
+    WriteOp& write(uint64_t offset, const std::string& data) {
+        return write(offset, data.data(), data.size());
+    }
+
+    /**
+     * @brief Truncates (or extends with zeros) the object to the given size.
+     */
+    WriteOp& truncate(uint64_t size) {
+        Step step;
+        step.type = TRUNCATE;
+        step.offset = size;
+        m_steps.push_back(std::move(step));
+        return *this;
+    }
+
+    /**
+     * @brief Sets key/value pairs in the omap of the object.
+     */
+    WriteOp& omapSet(const std::vector<std::pair<std::string, std::string>>& entries) {
+        Step step;
+        step.type = OMAP_SET;
+        step.entries = entries;
+        m_steps.push_back(std::move(step));
+        return *this;
+    }
+
+    /**
+     * @brief Removes keys from the omap of the object.
+     */
+    WriteOp& omapRemove(const std::vector<std::string>& keys) {
+        Step step;
+        step.type = OMAP_REMOVE;
+        step.keys = keys;
+        m_steps.push_back(std::move(step));
+        return *this;
+    }
+
+    /**
+     * @brief Whether the operation creates the object if it does not exist.
+     */
+    bool creates() const {
+        return m_create;
+    }
+
+    /**
+     * @brief Whether the operation requires the object not to exist.
+     */
+    bool exclusive() const {
+        return m_exclusive;
+    }
+
+    /**
+     * @brief Whether the operation checks the version of the object.
+     */
+    bool assertsVersion() const {
+        return m_assert_version;
+    }
+
+    /**
+     * @brief Version expected by the operation, if assertsVersion() is true.
+     */
+    uint64_t version() const {
+        return m_version;
+    }
+
+    /**
+     * @brief Whether the operation sets the version of the object.
+     */
+    bool setsVersion() const {
+        return m_set_version;
+    }
+
+    /**
+     * @brief Version set by the operation, if setsVersion() is true.
+     */
+    uint64_t newVersion() const {
+        return m_new_version;
+    }
+
+    /**
+     * @brief Steps of the operation, in order.
+     */
+    const std::vector<Step>& steps() const {
+        return m_steps;
+    }
+
+    template<typename Archive>
+    void serialize(Archive& a) {
+        a & m_create;
+        a & m_exclusive;
+        a & m_assert_version;
+        a & m_version;
+        a & m_set_version;
+        a & m_new_version;
+        a & m_steps;
+    }
+
+    private:
+
+    bool              m_create = false;
+    bool              m_exclusive = false;
+    bool              m_assert_version = false;
+    uint64_t          m_version = 0;
+    bool              m_set_version = false;
+    uint64_t          m_new_version = 0;
+    std::vector<Step> m_steps;
+};
+
+}
+
+#endif
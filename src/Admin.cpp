@@ -15,6 +15,23 @@ namespace tl = thallium;
 
 namespace mobject {
 
+/**
+ * @brief Sends an RPC, with the Admin's timeout if it has one.
+ */
+template<typename Result, typename ... Args>
+static Result send(const AdminImpl& impl,
+                   const tl::remote_procedure& rpc,
+                   const tl::provider_handle& ph,
+                   const Args& ... args) {
+    if(impl.m_timeout.count() == 0)
+        return rpc.on(ph)(args...);
+    try {
+        return rpc.on(ph).timed(impl.m_timeout, args...);
+    } catch(const tl::timeout&) {
+        throw Exception("Request timed out");
+    }
+}
+
 Admin::Admin() = default;
 
 Admin::Admin(const tl::engine& engine)
@@ -38,6 +55,10 @@ Admin::operator bool() const {
     return static_cast<bool>(self);
 }
 
+void Admin::setTimeout(std::chrono::milliseconds timeout) {
+    self->m_timeout = timeout;
+}
+
 UUID Admin::createSequencer(const std::string& address,
                            uint16_t provider_id,
                            const std::string& sequencer_type,
@@ -45,7 +66,7 @@ UUID Admin::createSequencer(const std::string& address,
                            const std::string& token) const {
     auto endpoint  = self->m_engine.lookup(address);
     auto ph        = tl::provider_handle(endpoint, provider_id);
-    RequestResult<UUID> result = self->m_create_sequencer.on(ph)(token, sequencer_type, sequencer_config);
+    RequestResult<UUID> result = send<RequestResult<UUID>>(*self, self->m_create_sequencer, ph, token, sequencer_type, sequencer_config);
     if(not result.success()) {
         throw Exception(result.error());
     }
@@ -59,7 +80,7 @@ UUID Admin::openSequencer(const std::string& address,
                          const std::string& token) const {
     auto endpoint  = self->m_engine.lookup(address);
     auto ph        = tl::provider_handle(endpoint, provider_id);
-    RequestResult<UUID> result = self->m_open_sequencer.on(ph)(token, sequencer_type, sequencer_config);
+    RequestResult<UUID> result = send<RequestResult<UUID>>(*self, self->m_open_sequencer, ph, token, sequencer_type, sequencer_config);
     if(not result.success()) {
         throw Exception(result.error());
     }
@@ -72,7 +93,7 @@ void Admin::closeSequencer(const std::string& address,
                            const std::string& token) const {
     auto endpoint  = self->m_engine.lookup(address);
     auto ph        = tl::provider_handle(endpoint, provider_id);
-    RequestResult<bool> result = self->m_close_sequencer.on(ph)(token, sequencer_id);
+    RequestResult<bool> result = send<RequestResult<bool>>(*self, self->m_close_sequencer, ph, token, sequencer_id);
     if(not result.success()) {
         throw Exception(result.error());
     }
@@ -84,10 +105,49 @@ void Admin::destroySequencer(const std::string& address,
                             const std::string& token) const {
     auto endpoint  = self->m_engine.lookup(address);
     auto ph        = tl::provider_handle(endpoint, provider_id);
-    RequestResult<bool> result = self->m_destroy_sequencer.on(ph)(token, sequencer_id);
+    RequestResult<bool> result = send<RequestResult<bool>>(*self, self->m_destroy_sequencer, ph, token, sequencer_id);
+    if(not result.success()) {
+        throw Exception(result.error());
+    }
+}
+
+void Admin::migrateSequencer(const std::string& address,
+                             uint16_t provider_id,
+                             const UUID& sequencer_id,
+                             const std::string& dest_address,
+                             uint16_t dest_provider_id,
+                             const std::string& token) const {
+    auto endpoint  = self->m_engine.lookup(address);
+    auto ph        = tl::provider_handle(endpoint, provider_id);
+    RequestResult<bool> result = send<RequestResult<bool>>(*self, self->m_migrate_sequencer, ph,
+        token, sequencer_id, dest_address, dest_provider_id);
+    if(not result.success()) {
+        throw Exception(result.error());
+    }
+}
+
+void Admin::promoteSequencer(const std::string& address,
+                             uint16_t provider_id,
+                             const UUID& sequencer_id,
+                             const std::string& token) const {
+    auto endpoint  = self->m_engine.lookup(address);
+    auto ph        = tl::provider_handle(endpoint, provider_id);
+    RequestResult<bool> result = send<RequestResult<bool>>(*self, self->m_promote_sequencer, ph, token, sequencer_id);
+    if(not result.success()) {
+        throw Exception(result.error());
+    }
+}
+
+std::string Admin::getStatistics(const std::string& address,
+                                 uint16_t provider_id,
+                                 const std::string& token) const {
+    auto endpoint  = self->m_engine.lookup(address);
+    auto ph        = tl::provider_handle(endpoint, provider_id);
+    RequestResult<std::string> result = send<RequestResult<std::string>>(*self, self->m_get_statistics, ph, token);
     if(not result.success()) {
         throw Exception(result.error());
     }
+    return std::move(result.value());
 }
 
 void Admin::shutdownServer(const std::string& address) const {
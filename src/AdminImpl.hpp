@@ -8,6 +8,8 @@
 
 #include <thallium.hpp>
 
+#include <chrono>
+
 namespace mobject {
 
 namespace tl = thallium;
@@ -21,6 +23,11 @@ class AdminImpl {
     tl::remote_procedure m_open_sequencer;
     tl::remote_procedure m_close_sequencer;
     tl::remote_procedure m_destroy_sequencer;
+    tl::remote_procedure m_migrate_sequencer;
+    tl::remote_procedure m_promote_sequencer;
+    tl::remote_procedure m_get_statistics;
+    // deadline of calls (0 for none), see Admin::setTimeout
+    std::chrono::milliseconds m_timeout = std::chrono::milliseconds(0);
 
     AdminImpl(const tl::engine& engine)
     : m_engine(engine)
@@ -28,6 +35,9 @@ class AdminImpl {
     , m_open_sequencer(m_engine.define("mobject_open_sequencer"))
     , m_close_sequencer(m_engine.define("mobject_close_sequencer"))
     , m_destroy_sequencer(m_engine.define("mobject_destroy_sequencer"))
+    , m_migrate_sequencer(m_engine.define("mobject_migrate_sequencer"))
+    , m_promote_sequencer(m_engine.define("mobject_promote_sequencer"))
+    , m_get_statistics(m_engine.define("mobject_get_statistics"))
     {}
 
     AdminImpl(margo_instance_id mid)
@@ -0,0 +1,255 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "AdmissionControl.hpp"
+#include "Timespec.hpp"
+#include "mobject/Exception.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mobject {
+
+// each request counts for this many bytes in weighted fair queuing
+static constexpr double request_cost = 65536;
+
+std::unique_ptr<AdmissionControl> AdmissionControl::fromConfig(const json& config) {
+    std::unique_ptr<AdmissionControl> admission(new AdmissionControl());
+    if(config.is_null()) return admission;
+    if(not config.is_object())
+        throw Exception("\"admission\" entry in provider configuration should be an object");
+    admission->m_enabled                     = true;
+    admission->m_max_in_flight               = config.value("max_in_flight", (size_t)0);
+    admission->m_max_queued                  = config.value("max_queued", (size_t)0);
+    admission->m_max_in_flight_per_sequencer = config.value("max_in_flight_per_sequencer", (size_t)0);
+    admission->m_max_queued_per_sequencer    = config.value("max_queued_per_sequencer", (size_t)0);
+    admission->m_max_queue_time = std::chrono::milliseconds(config.value("max_queue_ms", 1000));
+    admission->m_retry_after    = std::chrono::milliseconds(config.value("retry_after_ms", 10));
+    if(admission->m_retry_after.count() <= 0)
+        throw Exception("\"admission.retry_after_ms\" should be strictly positive");
+    auto policy = config.value("policy", std::string("fifo"));
+    if(policy == "fifo")     admission->m_policy = Policy::FIFO;
+    else if(policy == "edf") admission->m_policy = Policy::EDF;
+    else if(policy == "wfq") admission->m_policy = Policy::WFQ;
+    else throw Exception("\"admission.policy\" should be \"fifo\", \"edf\" or \"wfq\"");
+    if(config.contains("budgets_ms")) {
+        auto& budgets = config["budgets_ms"];
+        static const char* classes[3] = { "interactive", "normal", "batch" };
+        for(int i = 0; i < 3; i++) {
+            admission->m_budgets[i] = std::chrono::milliseconds(
+                budgets.value(classes[i], (int64_t)admission->m_budgets[i].count()));
+        }
+    }
+    admission->m_tenants["default"] = Tenant();
+    if(config.contains("tenants")) {
+        auto& tenants = config["tenants"];
+        if(not tenants.is_object())
+            throw Exception("\"admission.tenants\" should be an object");
+        auto now = clock::now();
+        for(auto& item : tenants.items()) {
+            auto& tenant_config = item.value();
+            Tenant tenant;
+            tenant.weight = tenant_config.value("weight", 1.0);
+            if(not (tenant.weight > 0))
+                throw Exception("Weight of tenant \"" + item.key() + "\" should be strictly positive");
+            tenant.token      = tenant_config.value("token", std::string());
+            tenant.ops.rate   = tenant_config.value("ops_per_sec", 0.0);
+            tenant.bytes.rate = tenant_config.value("bytes_per_sec", 0.0);
+            double burst      = tenant_config.value("burst_sec", 1.0);
+            for(auto bucket : { &tenant.ops, &tenant.bytes }) {
+                bucket->capacity = std::max(1.0, bucket->rate * burst);
+                bucket->tokens   = bucket->capacity;
+                bucket->refilled = now;
+            }
+            admission->m_tenants[item.key()] = tenant;
+        }
+    }
+    return admission;
+}
+
+uint32_t AdmissionControl::TokenBucket::delay(clock::time_point now) {
+    if(rate == 0) return 0;
+    double elapsed = std::chrono::duration<double>(now - refilled).count();
+    tokens   = std::min(capacity, tokens + elapsed * rate);
+    refilled = now;
+    if(tokens > 0) return 0;
+    return static_cast<uint32_t>(std::ceil((1 - tokens) / rate * 1000));
+}
+
+bool AdmissionControl::canRun(const Counts& sequencer) const {
+    return (m_max_in_flight == 0 || m_total.in_flight < m_max_in_flight)
+        && (m_max_in_flight_per_sequencer == 0 || sequencer.in_flight < m_max_in_flight_per_sequencer);
+}
+
+AdmissionControl::Tenant& AdmissionControl::findTenant(const std::string& name) {
+    auto it = m_tenants.find(name);
+    if(it == m_tenants.end()) return m_tenants["default"];
+    return it->second;
+}
+
+int64_t AdmissionControl::order(const RequestContext& ctx, Tenant& tenant, size_t bytes) {
+    switch(m_policy) {
+    case Policy::FIFO:
+        return ctx.received.time_since_epoch().count();
+    case Policy::EDF: {
+        auto budget = m_budgets[std::min<uint8_t>(ctx.priority, 2)];
+        return std::min(ctx.deadline(), ctx.received + budget).time_since_epoch().count();
+    }
+    case Policy::WFQ:
+    default: {
+        // start-time fair queuing: requests are ordered by their virtual
+        // start time, which advances by cost/weight for each request of
+        // the tenant, and never lags behind the virtual time
+        int64_t start = std::max(m_virtual_time, tenant.last_finish);
+        tenant.last_finish = start + static_cast<int64_t>((request_cost + bytes) / tenant.weight);
+        return start;
+    }
+    }
+}
+
+uint32_t AdmissionControl::retryAfter(const Counts& sequencer) const {
+    // roughly the time it takes for the requests ahead to drain,
+    // assuming each of them takes retry_after_ms
+    size_t ahead = std::max(
+        m_max_in_flight ? m_total.queued / m_max_in_flight : 0,
+        m_max_in_flight_per_sequencer ? sequencer.queued / m_max_in_flight_per_sequencer : 0);
+    return static_cast<uint32_t>(m_retry_after.count() * (1 + ahead));
+}
+
+void AdmissionControl::admitWaiting() {
+    // called with m_mtx locked, when slots may have become available
+    bool admitted = false;
+    for(auto it = m_waiting.begin(); it != m_waiting.end();) {
+        if(m_max_in_flight != 0 && m_total.in_flight >= m_max_in_flight) break;
+        auto waiter = it->second;
+        if(not canRun(*waiter->sequencer)) {
+            // limited by its sequencer; requests of other sequencers may run
+            ++it;
+            continue;
+        }
+        m_total.queued    -= 1;
+        m_total.in_flight += 1;
+        waiter->sequencer->queued    -= 1;
+        waiter->sequencer->in_flight += 1;
+        waiter->admitted = true;
+        if(m_policy == Policy::WFQ)
+            m_virtual_time = std::max(m_virtual_time, it->first);
+        admitted = true;
+        it = m_waiting.erase(it);
+    }
+    if(admitted) m_cv.notify_all();
+}
+
+AdmissionControl::Ticket AdmissionControl::admit(const UUID& sequencer_id,
+                                                 const RequestContext& ctx,
+                                                 size_t bytes) {
+    Ticket ticket;
+    if(not m_enabled) return ticket;
+    std::unique_lock<thallium::mutex> lock(m_mtx);
+    auto& tenant = findTenant(ctx.tenant);
+    if(not tenant.token.empty() && tenant.token != ctx.tenant_token) {
+        ticket.m_admitted = false;
+        ticket.m_error    = "Invalid token for tenant " + ctx.tenant;
+        return ticket;
+    }
+    auto now = clock::now();
+    auto throttle = std::max(tenant.ops.delay(now), tenant.bytes.delay(now));
+    if(throttle != 0) {
+        tenant.throttled    += 1;
+        ticket.m_admitted    = false;
+        ticket.m_retry_after = throttle;
+        ticket.m_error       = "Quota of tenant " + (ctx.tenant.empty() ? std::string("default") : ctx.tenant) + " exceeded";
+        return ticket;
+    }
+    // references to the entries of an unordered_map remain valid,
+    // and the entry is not erased while this request is counted in it
+    auto& sequencer = m_sequencers[sequencer_id];
+    // queued requests are admitted as soon as they can run, so a request
+    // that can run does not overtake a queued request that could
+    if(canRun(sequencer)) {
+        auto position = order(ctx, tenant, bytes);
+        if(m_policy == Policy::WFQ)
+            m_virtual_time = std::max(m_virtual_time, position);
+        m_total.in_flight  += 1;
+        sequencer.in_flight += 1;
+    } else {
+        bool queue_full = (m_max_queued != 0 && m_total.queued >= m_max_queued)
+                       || (m_max_queued_per_sequencer != 0 && sequencer.queued >= m_max_queued_per_sequencer);
+        if(queue_full) {
+            tenant.rejected     += 1;
+            ticket.m_admitted    = false;
+            ticket.m_retry_after = retryAfter(sequencer);
+            ticket.m_error       = "Provider is busy";
+            if(sequencer.in_flight == 0 && sequencer.queued == 0)
+                m_sequencers.erase(sequencer_id);
+            return ticket;
+        }
+        m_total.queued  += 1;
+        sequencer.queued += 1;
+        Waiter waiter;
+        waiter.sequencer = &sequencer;
+        auto position = m_waiting.emplace(order(ctx, tenant, bytes), &waiter);
+        auto deadline = std::min(now + m_max_queue_time, ctx.deadline());
+        while(not waiter.admitted) {
+            auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - clock::now()).count();
+            if(wait <= 0) break;
+            auto ts = timespecIn(std::chrono::nanoseconds(wait));
+            m_cv.wait_until(lock, &ts);
+        }
+        if(not waiter.admitted) {
+            // waited until the deadline or max_queue_ms
+            m_waiting.erase(position);
+            m_total.queued  -= 1;
+            sequencer.queued -= 1;
+            tenant.rejected     += 1;
+            ticket.m_admitted    = false;
+            ticket.m_retry_after = retryAfter(sequencer);
+            ticket.m_error       = "Provider is busy";
+            if(sequencer.in_flight == 0 && sequencer.queued == 0)
+                m_sequencers.erase(sequencer_id);
+            return ticket;
+        }
+    }
+    tenant.ops.take(1);
+    tenant.bytes.take(bytes);
+    tenant.admitted       += 1;
+    tenant.bytes_admitted += bytes;
+    ticket.m_owner        = this;
+    ticket.m_sequencer_id = sequencer_id;
+    return ticket;
+}
+
+void AdmissionControl::release(const UUID& sequencer_id) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    m_total.in_flight -= 1;
+    auto it = m_sequencers.find(sequencer_id);
+    if(it != m_sequencers.end()) {
+        it->second.in_flight -= 1;
+        if(it->second.in_flight == 0 && it->second.queued == 0)
+            m_sequencers.erase(it);
+    }
+    admitWaiting();
+}
+
+AdmissionControl::json AdmissionControl::getStatistics() {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    json stats = json::object();
+    stats["in_flight"] = m_total.in_flight;
+    stats["queued"]    = m_total.queued;
+    json tenants = json::object();
+    for(auto& t : m_tenants) {
+        json tenant = json::object();
+        tenant["weight"]    = t.second.weight;
+        tenant["admitted"]  = t.second.admitted;
+        tenant["throttled"] = t.second.throttled;
+        tenant["rejected"]  = t.second.rejected;
+        tenant["bytes"]     = t.second.bytes_admitted;
+        tenants[t.first]    = tenant;
+    }
+    stats["tenants"] = tenants;
+    return stats;
+}
+
+}
@@ -0,0 +1,243 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_ADMISSION_CONTROL_HPP
+#define __MOBJECT_ADMISSION_CONTROL_HPP
+
+#include "mobject/UUID.hpp"
+#include "RequestContext.hpp"
+
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace mobject {
+
+/**
+ * @brief AdmissionControl bounds the number of requests a provider
+ * executes concurrently (in flight) and the number of requests waiting
+ * for their turn (queued), both for the whole provider and for each
+ * sequencer. A request that arrives when the queue is full is rejected
+ * immediately with a "busy" error and a hint of when to retry (see
+ * RequestResult::retryAfter), instead of adding to a queueing delay
+ * that would make every request time out. Queued requests give up when
+ * their deadline expires or after "max_queue_ms".
+ *
+ * The provider configures its admission control from the "admission"
+ * section of its configuration, e.g.
+ * { "admission" : { "max_in_flight" : 64, "max_queued" : 256,
+ *                   "max_in_flight_per_sequencer" : 16, "max_queued_per_sequencer" : 64,
+ *                   "max_queue_ms" : 1000, "retry_after_ms" : 10 } }
+ * Limits that are absent (or 0) are not enforced. Without this section,
+ * every request is admitted.
+ *
+ * Queued requests are admitted in the order set by "policy". With
+ * "fifo" (the default) they are admitted in the order they arrived.
+ * With "edf" (earliest deadline first), they are admitted in the order
+ * of their deadline (see RequestContext), capped by a budget that
+ * depends on their priority class: a request is due at the earliest of
+ * its deadline and its arrival time plus the budget of its class, e.g.
+ * { "policy" : "edf", "budgets_ms" : { "interactive" : 10, "normal" : 100, "batch" : 1000 } }
+ * (the default budgets). Since every request is due at most a budget
+ * after its arrival, batch requests are delayed by interactive traffic
+ * but never starved by it.
+ *
+ * Argobots pools cannot order handler ULTs by deadline, since the
+ * deadline is only known once the handler has deserialized its
+ * arguments; ordering the admission queue instead achieves the same
+ * once the provider is saturated, which is the only time order matters.
+ *
+ * Requests carry the name of their tenant (see Client::setTenant).
+ * The "tenants" section lists the tenants with their weight, their
+ * quotas of operations and bytes per second, and optionally a token
+ * their requests must present, e.g.
+ * { "tenants" : { "analytics" : { "weight" : 1, "ops_per_sec" : 1000,
+ *                                 "bytes_per_sec" : 104857600, "token" : "..." },
+ *                 "default"   : { "weight" : 4 } } }
+ * Requests of tenants that are not listed are accounted to "default".
+ * Quotas are enforced with token buckets holding one second of quota
+ * (or "burst_sec" seconds): a request of a tenant whose bucket is empty
+ * is rejected with a hint of when it will have been refilled. With
+ * "policy" : "wfq" (weighted fair queuing), queued requests are admitted
+ * so that, while they are backlogged, tenants get a share of the
+ * provider proportional to their weight, each request counting for
+ * 64 KiB plus the bytes it transfers.
+ */
+class AdmissionControl {
+
+    using json  = nlohmann::json;
+    using clock = std::chrono::steady_clock;
+
+    struct Counts {
+        size_t in_flight = 0;
+        size_t queued    = 0;
+    };
+
+    struct Waiter {
+        Counts* sequencer;
+        bool    admitted = false;
+    };
+
+    struct TokenBucket {
+        double            rate = 0; // tokens per second, 0 for unlimited
+        double            capacity = 0;
+        double            tokens = 0;
+        clock::time_point refilled;
+
+        /**
+         * @brief Refills the bucket and returns 0 if tokens are available,
+         * otherwise the number of milliseconds until they are.
+         */
+        uint32_t delay(clock::time_point now);
+
+        /**
+         * @brief Takes n tokens; the bucket may go into debt for a
+         * request larger than what it holds.
+         */
+        void take(double n) {
+            if(rate != 0) tokens -= n;
+        }
+    };
+
+    struct Tenant {
+        double      weight = 1;
+        std::string token;
+        TokenBucket ops;
+        TokenBucket bytes;
+        int64_t     last_finish = 0; // virtual finish time of its last request
+        // statistics
+        uint64_t    admitted = 0;
+        uint64_t    throttled = 0;
+        uint64_t    rejected = 0;
+        uint64_t    bytes_admitted = 0;
+    };
+
+    enum class Policy { FIFO, EDF, WFQ };
+
+    public:
+
+    /**
+     * @brief A Ticket holds the slot of an admitted request, which is
+     * released when the Ticket is destroyed. An invalid Ticket, with an
+     * error message, is returned for rejected requests.
+     */
+    class Ticket {
+
+        friend class AdmissionControl;
+
+        public:
+
+        Ticket() = default;
+        Ticket(const Ticket&) = delete;
+        Ticket(Ticket&& other)
+        : m_owner(other.m_owner)
+        , m_sequencer_id(other.m_sequencer_id)
+        , m_admitted(other.m_admitted)
+        , m_retry_after(other.m_retry_after)
+        , m_error(std::move(other.m_error)) {
+            other.m_owner = nullptr;
+        }
+        Ticket& operator=(const Ticket&) = delete;
+        Ticket& operator=(Ticket&&) = delete;
+
+        ~Ticket() {
+            if(m_owner) m_owner->release(m_sequencer_id);
+        }
+
+        /**
+         * @brief Whether the request was admitted.
+         */
+        explicit operator bool() const {
+            return m_admitted;
+        }
+
+        /**
+         * @brief Delay after which a rejected request may be sent
+         * again (0 if it should not be).
+         */
+        uint32_t retryAfter() const {
+            return m_retry_after;
+        }
+
+        /**
+         * @brief Reason why the request was rejected.
+         */
+        const std::string& error() const {
+            return m_error;
+        }
+
+        private:
+
+        AdmissionControl* m_owner = nullptr; // null if no slot is held
+        UUID              m_sequencer_id;
+        bool              m_admitted = true;
+        uint32_t          m_retry_after = 0;
+        std::string       m_error;
+    };
+
+    /**
+     * @brief Builds an AdmissionControl from the "admission" section of
+     * a provider's configuration (which may be null).
+     */
+    static std::unique_ptr<AdmissionControl> fromConfig(const json& config);
+
+    /**
+     * @brief Admits a request on the given sequencer, transferring the
+     * given number of bytes, possibly after waiting for a slot, or
+     * rejects it.
+     */
+    Ticket admit(const UUID& sequencer_id, const RequestContext& ctx, size_t bytes);
+
+    /**
+     * @brief Returns the number of requests in flight and queued, and
+     * the statistics of each tenant.
+     */
+    json getStatistics();
+
+    private:
+
+    bool                      m_enabled = false;
+    size_t                    m_max_in_flight = 0;
+    size_t                    m_max_queued = 0;
+    size_t                    m_max_in_flight_per_sequencer = 0;
+    size_t                    m_max_queued_per_sequencer = 0;
+    std::chrono::milliseconds m_max_queue_time = std::chrono::milliseconds(1000);
+    std::chrono::milliseconds m_retry_after = std::chrono::milliseconds(10);
+    Policy                    m_policy = Policy::FIFO;
+    std::chrono::milliseconds m_budgets[3] = { // by priority class
+        std::chrono::milliseconds(10),
+        std::chrono::milliseconds(100),
+        std::chrono::milliseconds(1000)
+    };
+
+    Counts                                  m_total;
+    std::unordered_map<UUID, Counts>        m_sequencers; // only sequencers with requests
+    std::unordered_map<std::string, Tenant> m_tenants; // configured ones and "default"
+    int64_t                                 m_virtual_time = 0; // of weighted fair queuing
+    std::multimap<int64_t, Waiter*>         m_waiting; // queued requests, in admission order
+    thallium::mutex                         m_mtx;
+    thallium::condition_variable            m_cv;
+
+    bool canRun(const Counts& sequencer) const;
+
+    Tenant& findTenant(const std::string& name);
+
+    int64_t order(const RequestContext& ctx, Tenant& tenant, size_t bytes);
+
+    void admitWaiting();
+
+    uint32_t retryAfter(const Counts& sequencer) const;
+
+    void release(const UUID& sequencer_id);
+};
+
+}
+
+#endif
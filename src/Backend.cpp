@@ -4,6 +4,9 @@
  * See COPYRIGHT in top-level directory.
  */
 #include "mobject/Backend.hpp"
+#include "WriteBackBackend.hpp"
+#include "GappedBackend.hpp"
+#include "VectorSum.hpp"
 
 namespace tl = thallium;
 
@@ -11,19 +14,46 @@ namespace mobject {
 
 using json = nlohmann::json;
 
+RequestResult<bool> Backend::computeSumArray(const int32_t* x,
+                                             const int32_t* y,
+                                             int32_t* result,
+                                             size_t count) {
+    RequestResult<bool> r;
+    size_t i = addInt32(x, y, result, count);
+    if(i != count) {
+        r.success() = false;
+        r.error() = "Integer overflow in computeSumArray at index " + std::to_string(i);
+    }
+    return r;
+}
+
 std::unordered_map<std::string,
                 std::function<std::unique_ptr<Backend>(const tl::engine&, const json&)>> SequencerFactory::create_fn;
 
 std::unordered_map<std::string,
                 std::function<std::unique_ptr<Backend>(const tl::engine&, const json&)>> SequencerFactory::open_fn;
 
+std::unique_ptr<Backend> SequencerFactory::wrap(std::unique_ptr<Backend>&& backend,
+                                              const tl::engine& engine,
+                                              const json& config) {
+    if(backend && config.contains("write_back")) {
+        backend = std::unique_ptr<Backend>(
+            new WriteBackBackend(std::move(backend), engine, config["write_back"]));
+    }
+    if(backend && config.contains("gapped")) {
+        backend = std::unique_ptr<Backend>(
+            new GappedBackend(std::move(backend), config["gapped"]));
+    }
+    return std::move(backend);
+}
+
 std::unique_ptr<Backend> SequencerFactory::createSequencer(const std::string& backend_name,
                                                          const tl::engine& engine,
                                                          const json& config) {
     auto it = create_fn.find(backend_name);
     if(it == create_fn.end()) return nullptr;
     auto& f = it->second;
-    return f(engine, config);
+    return wrap(f(engine, config), engine, config);
 }
 
 std::unique_ptr<Backend> SequencerFactory::openSequencer(const std::string& backend_name,
@@ -32,7 +62,7 @@ std::unique_ptr<Backend> SequencerFactory::openSequencer(const std::string& back
     auto it = open_fn.find(backend_name);
     if(it == open_fn.end()) return nullptr;
     auto& f = it->second;
-    return f(engine, config);
+    return wrap(f(engine, config), engine, config);
 }
 
 }
@@ -0,0 +1,150 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_CHECKSUM_H
+#define __MOBJECT_CHECKSUM_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace mobject {
+
+/**
+ * CRC32C (Castagnoli) checksums used to protect object data end-to-end.
+ * The implementation uses the SSE4.2 crc32 instruction on x86-64 and the
+ * ARMv8 CRC extension on aarch64 when the CPU supports them (detected
+ * once, at runtime), and falls back to a portable slicing-by-8 table
+ * otherwise. Checksums can be computed incrementally: passing the result
+ * of crc32c(a) as the initial value of crc32c(b) gives the checksum of
+ * the concatenation of a and b, so data can be checksummed chunk by chunk
+ * as it arrives.
+ */
+namespace checksum {
+
+inline const uint32_t (&table())[8][256] {
+    static const struct Table {
+        uint32_t t[8][256];
+        Table() {
+            for(uint32_t i = 0; i < 256; i++) {
+                uint32_t crc = i;
+                for(int j = 0; j < 8; j++)
+                    crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+                t[0][i] = crc;
+            }
+            for(uint32_t i = 0; i < 256; i++)
+                for(int k = 1; k < 8; k++)
+                    t[k][i] = (t[k-1][i] >> 8) ^ t[0][t[k-1][i] & 0xFF];
+        }
+    } s_table;
+    return s_table.t;
+}
+
+inline uint32_t software(uint32_t crc, const unsigned char* p, size_t size) {
+    auto& t = table();
+    while(size >= 8) {
+        uint32_t lo, hi;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= crc; // assumes little-endian, as do all supported platforms
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF]
+            ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+            ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF]
+            ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while(size--)
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    return crc;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.2")))
+inline uint32_t hardware(uint32_t crc, const unsigned char* p, size_t size) {
+    uint64_t crc64 = crc;
+    while(size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        size -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+    while(size--)
+        crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+
+inline bool hardwareSupported() {
+    return __builtin_cpu_supports("sse4.2");
+}
+
+#elif defined(__aarch64__)
+
+__attribute__((target("+crc")))
+inline uint32_t hardware(uint32_t crc, const unsigned char* p, size_t size) {
+    while(size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        crc = __crc32cd(crc, word);
+        p += 8;
+        size -= 8;
+    }
+    while(size--)
+        crc = __crc32cb(crc, *p++);
+    return crc;
+}
+
+inline bool hardwareSupported() {
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+
+#else
+
+inline uint32_t hardware(uint32_t crc, const unsigned char* p, size_t size) {
+    return software(crc, p, size);
+}
+
+inline bool hardwareSupported() {
+    return false;
+}
+
+#endif
+
+using crc_fn = uint32_t (*)(uint32_t, const unsigned char*, size_t);
+
+inline crc_fn select() {
+    static const crc_fn s_fn = hardwareSupported() ? &hardware : &software;
+    return s_fn;
+}
+
+}
+
+/**
+ * @brief Computes the CRC32C of a buffer.
+ *
+ * @param data Data to checksum.
+ * @param size Size of the data.
+ * @param crc Checksum of the preceding data, if computing incrementally.
+ *
+ * @return the checksum.
+ */
+inline uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0) {
+    return ~checksum::select()(~crc, static_cast<const unsigned char*>(data), size);
+}
+
+}
+
+#endif
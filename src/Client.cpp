@@ -56,8 +56,23 @@ SequencerHandle Client::makeSequencerHandle(
     auto ph        = tl::provider_handle(endpoint, provider_id);
     RequestResult<bool> result;
     result.success() = true;
+    auto check_sequencer = [this, &ph, &sequencer_id]() -> RequestResult<bool> {
+        if(self->m_timeout.count() == 0)
+            return self->m_check_sequencer.on(ph)(sequencer_id);
+        try {
+            return self->m_check_sequencer.on(ph).timed(self->m_timeout, sequencer_id);
+        } catch(const tl::timeout&) {
+            throw Exception("Request timed out");
+        }
+    };
     if(check) {
-        result = self->m_check_sequencer.on(ph)(sequencer_id);
+        result = check_sequencer();
+        // follow the sequencer if it has migrated to another provider
+        for(unsigned i = 0; result.redirected() && i < SequencerHandleImpl::max_redirects; i++) {
+            ph = tl::provider_handle(self->m_engine.lookup(result.redirectAddress()),
+                                     result.redirectProviderId());
+            result = check_sequencer();
+        }
     }
     if(result.success()) {
         auto sequencer_impl = std::make_shared<SequencerHandleImpl>(self, std::move(ph), sequencer_id);
@@ -68,6 +83,36 @@ SequencerHandle Client::makeSequencerHandle(
     }
 }
 
+void Client::setTimeout(std::chrono::milliseconds timeout) {
+    self->m_timeout = timeout;
+}
+
+void Client::setRetryPolicy(unsigned max_retries,
+                            std::chrono::milliseconds attempt_timeout,
+                            std::chrono::milliseconds backoff) {
+    self->m_max_retries     = max_retries;
+    self->m_attempt_timeout = attempt_timeout;
+    self->m_backoff         = backoff;
+}
+
+void Client::setHedgingPolicy(double percentile,
+                              std::chrono::milliseconds min_delay) {
+    if(percentile < 0 || percentile > 100)
+        throw Exception("Hedging percentile should be between 0 and 100");
+    self->m_hedge_percentile = percentile;
+    self->m_hedge_min_delay  = min_delay;
+}
+
+void Client::setTenant(const std::string& tenant, const std::string& token) {
+    self->m_tenant       = tenant;
+    self->m_tenant_token = token;
+}
+
+void Client::setPostedWindow(size_t window) {
+    if(window == 0) throw Exception("Posted window should be strictly positive");
+    self->m_posted_window = window;
+}
+
 std::string Client::getConfig() const {
     return "{}";
 }
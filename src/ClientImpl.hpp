@@ -6,10 +6,22 @@
 #ifndef __MOBJECT_CLIENT_IMPL_H
 #define __MOBJECT_CLIENT_IMPL_H
 
+#include <mobject/UUID.hpp>
+
+#include "LatencyTracker.hpp"
+
 #include <thallium.hpp>
 #include <thallium/serialization/stl/unordered_set.hpp>
 #include <thallium/serialization/stl/unordered_map.hpp>
 #include <thallium/serialization/stl/string.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+#include <thallium/serialization/stl/pair.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 namespace mobject {
 
@@ -23,12 +35,119 @@ class ClientImpl {
     tl::remote_procedure m_check_sequencer;
     tl::remote_procedure m_say_hello;
     tl::remote_procedure m_compute_sum;
+    tl::remote_procedure m_compute_sum_array;
+    tl::remote_procedure m_write;
+    tl::remote_procedure m_append;
+    tl::remote_procedure m_posted_write;
+    tl::remote_procedure m_posted_append;
+    tl::remote_procedure m_posted_barrier;
+    tl::remote_procedure m_read;
+    tl::remote_procedure m_remove;
+    tl::remote_procedure m_flush;
+    tl::remote_procedure m_list_objects;
+    tl::remote_procedure m_omap_set;
+    tl::remote_procedure m_omap_get;
+    tl::remote_procedure m_omap_remove;
+    tl::remote_procedure m_omap_scan;
+    tl::remote_procedure m_execute;
+    tl::remote_procedure m_watch;
+    tl::remote_procedure m_timestamps;
+
+    // identifies the client's non-idempotent requests, so that
+    // providers can recognize retries (see DedupTable)
+    UUID                  m_client_id = UUID::generate();
+    std::atomic<uint64_t> m_next_request_seq = { 1 };
+
+    // default deadline of calls (0 for none) and retry policy,
+    // see Client::setTimeout and Client::setRetryPolicy
+    std::chrono::milliseconds m_timeout = std::chrono::milliseconds(0);
+    unsigned                  m_max_retries = 0;
+    std::chrono::milliseconds m_attempt_timeout = std::chrono::milliseconds(0);
+    std::chrono::milliseconds m_backoff = std::chrono::milliseconds(10);
+
+    // hedged reads (see Client::setHedgingPolicy); a percentile
+    // of 0 disables hedging
+    double                    m_hedge_percentile = 0;
+    std::chrono::milliseconds m_hedge_min_delay = std::chrono::milliseconds(1);
+    LatencyTracker            m_read_latencies;
+
+    // tenant the requests are made for (see Client::setTenant)
+    std::string               m_tenant;
+    std::string               m_tenant_token;
+
+    /**
+     * @brief Posted operations sent to a sequencer, through a given
+     * provider (see SequencerHandle::withPosting). The provider knows
+     * the stream by its UUID, which changes after each drain, and so
+     * whenever the operations start going to another provider (e.g.
+     * after the sequencer migrated).
+     */
+    struct PostedStream {
+        tl::mutex           m_mtx;
+        UUID                m_stream_id = UUID::generate();
+        tl::provider_handle m_ph;
+        std::string         m_address;
+        uint64_t            m_posted = 0;  // number of the last operation posted
+        uint64_t            m_failed = 0;  // failed operations not yet reported by a flush
+        std::string         m_first_error;
+        // copies of the data of the operations posted since the last
+        // drain, exposed until the provider is known to have pulled them
+        struct Data {
+            std::vector<char> m_buffer;
+            tl::bulk          m_bulk;
+        };
+        std::vector<Data>   m_data;
+    };
+
+    // streams of posted operations, by sequencer, and the number of
+    // operations a stream may have outstanding (see Client::setPostedWindow)
+    std::unordered_map<UUID, std::shared_ptr<PostedStream>> m_posted_streams;
+    tl::mutex                                               m_posted_mtx;
+    size_t                                                  m_posted_window = 256;
+
+    /**
+     * @brief Returns the stream of posted operations to a sequencer,
+     * creating it if create is true (null if it does not exist otherwise).
+     */
+    std::shared_ptr<PostedStream> postedStream(const UUID& sequencer_id, bool create) {
+        std::lock_guard<tl::mutex> lock(m_posted_mtx);
+        auto it = m_posted_streams.find(sequencer_id);
+        if(it != m_posted_streams.end()) return it->second;
+        if(not create) return nullptr;
+        auto stream = std::make_shared<PostedStream>();
+        m_posted_streams.emplace(sequencer_id, stream);
+        return stream;
+    }
+
+    /**
+     * @brief Returns the sequence number of a new request.
+     */
+    uint64_t nextRequestSeq() {
+        return m_next_request_seq++;
+    }
 
     ClientImpl(const tl::engine& engine)
     : m_engine(engine)
     , m_check_sequencer(m_engine.define("mobject_check_sequencer"))
     , m_say_hello(m_engine.define("mobject_say_hello").disable_response())
     , m_compute_sum(m_engine.define("mobject_compute_sum"))
+    , m_compute_sum_array(m_engine.define("mobject_compute_sum_array"))
+    , m_write(m_engine.define("mobject_write"))
+    , m_append(m_engine.define("mobject_append"))
+    , m_posted_write(m_engine.define("mobject_posted_write").disable_response())
+    , m_posted_append(m_engine.define("mobject_posted_append").disable_response())
+    , m_posted_barrier(m_engine.define("mobject_posted_barrier"))
+    , m_read(m_engine.define("mobject_read"))
+    , m_remove(m_engine.define("mobject_remove"))
+    , m_flush(m_engine.define("mobject_flush"))
+    , m_list_objects(m_engine.define("mobject_list_objects"))
+    , m_omap_set(m_engine.define("mobject_omap_set"))
+    , m_omap_get(m_engine.define("mobject_omap_get"))
+    , m_omap_remove(m_engine.define("mobject_omap_remove"))
+    , m_omap_scan(m_engine.define("mobject_omap_scan"))
+    , m_execute(m_engine.define("mobject_execute"))
+    , m_watch(m_engine.define("mobject_watch"))
+    , m_timestamps(m_engine.define("mobject_timestamps"))
     {}
 
     ClientImpl(margo_instance_id mid)
@@ -0,0 +1,156 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "DedupTable.hpp"
+#include "mobject/Exception.hpp"
+
+#include <algorithm>
+
+namespace mobject {
+
+DedupTable::DedupTable(size_t max_clients, size_t window)
+: m_max_clients(max_clients)
+, m_window(window) {}
+
+std::unique_ptr<DedupTable> DedupTable::fromConfig(const json& config) {
+    size_t max_clients = 4096;
+    size_t window      = 1024;
+    if(not config.is_null()) {
+        if(not config.is_object())
+            throw Exception("\"dedup\" entry in provider configuration should be an object");
+        max_clients = config.value("max_clients", max_clients);
+        window      = config.value("window", window);
+    }
+    if(max_clients == 0)
+        throw Exception("\"dedup.max_clients\" should be strictly positive");
+    if(window == 0)
+        throw Exception("\"dedup.window\" should be strictly positive");
+    return std::unique_ptr<DedupTable>(new DedupTable(max_clients, window));
+}
+
+DedupTable::Client& DedupTable::touch(const UUID& client_id) {
+    auto it = m_clients.find(client_id);
+    if(it == m_clients.end()) {
+        if(m_clients.size() == m_max_clients) {
+            m_clients.erase(m_lru.back());
+            m_lru.pop_back();
+            m_evicted = true;
+        }
+        m_lru.push_front(client_id);
+        it = m_clients.emplace(client_id, Client()).first;
+        it->second.lru = m_lru.begin();
+    } else {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    }
+    return it->second;
+}
+
+DedupTable::Entry& DedupTable::insert(Client& client, uint64_t request_seq) {
+    // forget the oldest requests of the client
+    while(client.entries.size() >= m_window) {
+        client.floor = std::max(client.floor, client.entries.begin()->first);
+        client.entries.erase(client.entries.begin());
+    }
+    return client.entries[request_seq];
+}
+
+bool DedupTable::begin(const UUID& client_id, const UUID& sequencer_id,
+                       uint64_t request_seq, bool retry, RequestResult<uint64_t>& result) {
+    if(request_seq == 0) return true;
+    std::unique_lock<thallium::mutex> lock(m_mtx);
+    if(retry && m_evicted && m_clients.count(client_id) == 0) {
+        // the client may have been evicted along with the result
+        result.success() = false;
+        result.error() = "Result of request " + std::to_string(request_seq)
+                       + " is no longer available";
+        return false;
+    }
+    auto& client = touch(client_id);
+    if(request_seq <= client.floor) {
+        result.success() = false;
+        result.error() = "Request " + std::to_string(request_seq)
+                       + " is too old to be retried";
+        return false;
+    }
+    if(client.entries.count(request_seq) == 0) {
+        insert(client, request_seq).sequencer_id = sequencer_id;
+        return true;
+    }
+    // duplicate: wait for the original request to complete
+    while(true) {
+        auto c = m_clients.find(client_id);
+        if(c == m_clients.end() || request_seq <= c->second.floor)
+            break; // forgotten while waiting
+        auto entry = c->second.entries.find(request_seq);
+        if(entry == c->second.entries.end()) {
+            // the original request was abandoned without having any
+            // effect, this duplicate executes it instead
+            insert(c->second, request_seq).sequencer_id = sequencer_id;
+            return true;
+        }
+        if(entry->second.done) {
+            result = entry->second.result;
+            return false;
+        }
+        m_cv.wait(lock);
+    }
+    result.success() = false;
+    result.error() = "Result of request " + std::to_string(request_seq)
+                   + " is no longer available";
+    return false;
+}
+
+void DedupTable::complete(const UUID& client_id, uint64_t request_seq,
+                          const RequestResult<uint64_t>& result) {
+    if(request_seq == 0) return;
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    auto it = m_clients.find(client_id);
+    if(it != m_clients.end()) {
+        auto entry = it->second.entries.find(request_seq);
+        if(entry != it->second.entries.end()) {
+            entry->second.done   = true;
+            entry->second.result = result;
+        }
+    }
+    m_cv.notify_all();
+}
+
+void DedupTable::abandon(const UUID& client_id, uint64_t request_seq) {
+    if(request_seq == 0) return;
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    auto it = m_clients.find(client_id);
+    if(it != m_clients.end())
+        it->second.entries.erase(request_seq);
+    m_cv.notify_all();
+}
+
+std::vector<DedupTable::Record> DedupTable::completed(const UUID& sequencer_id) {
+    std::vector<Record> records;
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    for(auto& c : m_clients) {
+        for(auto& e : c.second.entries) {
+            if(not e.second.done || not (e.second.sequencer_id == sequencer_id)) continue;
+            records.push_back(Record{c.first, e.first, e.second.result});
+        }
+    }
+    return records;
+}
+
+void DedupTable::restore(const UUID& sequencer_id, const std::vector<Record>& records) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    for(auto& record : records) {
+        if(record.request_seq == 0) continue;
+        auto& client = touch(record.client_id);
+        if(record.request_seq <= client.floor || client.entries.count(record.request_seq))
+            continue;
+        auto& entry = insert(client, record.request_seq);
+        entry.sequencer_id = sequencer_id;
+        entry.done         = true;
+        entry.result       = record.result;
+    }
+    m_cv.notify_all();
+}
+
+}
@@ -0,0 +1,157 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_DEDUP_TABLE_HPP
+#define __MOBJECT_DEDUP_TABLE_HPP
+
+#include "mobject/RequestResult.hpp"
+#include "mobject/UUID.hpp"
+
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace mobject {
+
+/**
+ * @brief The DedupTable remembers the results of the recent
+ * non-idempotent requests (appends, WriteOps, timestamps) of each
+ * client, identified by the client's UUID and a sequence number the
+ * client increments for each request and reuses when it retries one.
+ * A retry of a request that was already executed gets the result of
+ * the first execution instead of, e.g., reserving a second range; a
+ * retry of a request that is still executing waits for its result.
+ *
+ * Memory is bounded: the table keeps the results of the last "window"
+ * requests of each client, and the "max_clients" clients that sent a
+ * request most recently. A retry of a request older than the window
+ * gets an error rather than being executed twice. So does a retry
+ * from a client the table does not know once clients have been
+ * evicted, since the client's requests may have been forgotten along
+ * with it.
+ *
+ * The provider configures its table from the "dedup" section of its
+ * configuration, e.g. { "dedup" : { "max_clients" : 4096, "window" : 1024 } }
+ *
+ * Each entry also records the sequencer the request was sent to, so
+ * that when a sequencer migrates, the results of its requests can be
+ * handed over to the destination provider (see completed() and
+ * restore()), where the retries of those requests are redirected.
+ */
+class DedupTable {
+
+    using json = nlohmann::json;
+
+    public:
+
+    /**
+     * @brief Result of a completed request, as handed over to another
+     * provider when a sequencer migrates.
+     */
+    struct Record {
+        UUID                    client_id;
+        uint64_t                request_seq = 0;
+        RequestResult<uint64_t> result;
+
+        template<typename Archive>
+        void serialize(Archive& a) {
+            a & client_id;
+            a & request_seq;
+            a & result;
+        }
+    };
+
+    /**
+     * @brief Constructor.
+     *
+     * @param max_clients Maximum number of clients tracked.
+     * @param window Number of requests remembered per client.
+     */
+    DedupTable(size_t max_clients, size_t window);
+
+    /**
+     * @brief Builds a DedupTable from the "dedup" section of a
+     * provider's configuration (which may be null).
+     */
+    static std::unique_ptr<DedupTable> fromConfig(const json& config);
+
+    /**
+     * @brief Registers the start of a request. Returns true if the
+     * request has to be executed, in which case complete() must be
+     * called with its result. Returns false if it is a duplicate, in
+     * which case result is set to the result of the original request.
+     * If the original request is still executing, waits for it; if it
+     * is abandoned in the meantime, the duplicate takes its place and
+     * begin() returns true. retry tells whether an earlier attempt of
+     * the request timed out (see RequestContext). Requests with a
+     * sequence number of 0 are never de-duplicated.
+     */
+    bool begin(const UUID& client_id, const UUID& sequencer_id,
+               uint64_t request_seq, bool retry, RequestResult<uint64_t>& result);
+
+    /**
+     * @brief Records the result of a request for which begin() returned true.
+     */
+    void complete(const UUID& client_id, uint64_t request_seq,
+                  const RequestResult<uint64_t>& result);
+
+    /**
+     * @brief Forgets a request for which begin() returned true but
+     * that failed before having any effect (e.g. because its data
+     * could not be transferred), so that a retry executes it again.
+     */
+    void abandon(const UUID& client_id, uint64_t request_seq);
+
+    /**
+     * @brief Returns the results of the completed requests that were
+     * sent to the given sequencer.
+     */
+    std::vector<Record> completed(const UUID& sequencer_id);
+
+    /**
+     * @brief Records results returned by completed() on another
+     * provider, for a sequencer that migrated here. Results of requests
+     * that this table already knows or that are older than its window
+     * are ignored.
+     */
+    void restore(const UUID& sequencer_id, const std::vector<Record>& records);
+
+    private:
+
+    struct Entry {
+        UUID                    sequencer_id;
+        bool                    done = false;
+        RequestResult<uint64_t> result;
+    };
+
+    struct Client {
+        std::map<uint64_t, Entry>      entries; // by sequence number
+        uint64_t                       floor = 0; // highest sequence number forgotten
+        std::list<UUID>::iterator      lru;
+    };
+
+    // finds or creates the entry of a client, as its most recently used one
+    Client& touch(const UUID& client_id);
+
+    // creates the entry of a request, forgetting the oldest ones beyond the window
+    Entry& insert(Client& client, uint64_t request_seq);
+
+    size_t                           m_max_clients;
+    size_t                           m_window;
+    std::unordered_map<UUID, Client> m_clients;
+    std::list<UUID>                  m_lru; // most recently used first
+    bool                             m_evicted = false; // whether clients were evicted
+    thallium::mutex                  m_mtx;
+    thallium::condition_variable     m_cv;
+};
+
+}
+
+#endif
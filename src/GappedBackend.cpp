@@ -0,0 +1,142 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "GappedBackend.hpp"
+#include "mobject/Exception.hpp"
+
+#include <algorithm>
+
+namespace mobject {
+
+GappedBackend::GappedBackend(std::unique_ptr<Backend>&& backend, const json& config)
+: m_backend(std::move(backend))
+, m_range_size(config.value("range_size", (size_t)65536)) {
+    if(m_range_size == 0)
+        throw Exception("\"gapped.range_size\" should be strictly positive");
+}
+
+void GappedBackend::sayHello() {
+    m_backend->sayHello();
+}
+
+RequestResult<int32_t> GappedBackend::computeSum(int32_t x, int32_t y) {
+    return m_backend->computeSum(x, y);
+}
+
+RequestResult<bool> GappedBackend::write(const std::string& object,
+                                         uint64_t offset,
+                                         const char* data,
+                                         size_t size) {
+    return m_backend->write(object, offset, data, size);
+}
+
+RequestResult<uint64_t> GappedBackend::reserve(const std::string& object,
+                                               size_t size) {
+    if(size == 0) return m_backend->reserve(object, size);
+    auto& slot = m_slots[thallium::xstream::self().get_rank() % num_slots];
+    std::lock_guard<thallium::mutex> lock(slot.mutex);
+    auto& range = slot.ranges[object];
+    if(range.second - range.first < size) {
+        // the rest of the current range is abandoned
+        size_t range_size = std::max(m_range_size, size);
+        auto result = m_backend->reserve(object, range_size);
+        if(not result.success()) {
+            slot.ranges.erase(object);
+            return result;
+        }
+        range.first  = result.value();
+        range.second = result.value() + range_size;
+    }
+    RequestResult<uint64_t> result;
+    result.value() = range.first;
+    range.first += size;
+    return result;
+}
+
+RequestResult<size_t> GappedBackend::read(const std::string& object,
+                                          uint64_t offset,
+                                          char* data,
+                                          size_t size) {
+    return m_backend->read(object, offset, data, size);
+}
+
+RequestResult<bool> GappedBackend::remove(const std::string& object) {
+    // a reservation needs the lock of its slot, so none can get a new
+    // range from the object between the ranges being dropped and the
+    // object being removed (which would then outlive the object)
+    for(auto& slot : m_slots) {
+        slot.mutex.lock();
+        slot.ranges.erase(object);
+    }
+    auto result = m_backend->remove(object);
+    for(auto& slot : m_slots)
+        slot.mutex.unlock();
+    return result;
+}
+
+RequestResult<std::vector<std::string>> GappedBackend::listObjects(
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) {
+    return m_backend->listObjects(prefix, start_after, max);
+}
+
+RequestResult<bool> GappedBackend::omapSet(
+        const std::string& object,
+        const std::vector<std::pair<std::string, std::string>>& entries) {
+    return m_backend->omapSet(object, entries);
+}
+
+RequestResult<std::vector<std::pair<std::string, std::string>>> GappedBackend::omapGet(
+        const std::string& object,
+        const std::vector<std::string>& keys) {
+    return m_backend->omapGet(object, keys);
+}
+
+RequestResult<bool> GappedBackend::omapRemove(
+        const std::string& object,
+        const std::vector<std::string>& keys) {
+    return m_backend->omapRemove(object, keys);
+}
+
+RequestResult<std::vector<std::pair<std::string, std::string>>> GappedBackend::omapScan(
+        const std::string& object,
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) {
+    return m_backend->omapScan(object, prefix, start_after, max);
+}
+
+RequestResult<uint64_t> GappedBackend::execute(const std::string& object,
+                                               const WriteOp& op) {
+    bool truncates = std::any_of(op.steps().begin(), op.steps().end(),
+        [](const WriteOp::Step& step) { return step.type == WriteOp::TRUNCATE; });
+    if(not truncates) return m_backend->execute(object, op);
+    // the ranges held by the xstreams lie past the new end of the object,
+    // so they are dropped, as in remove, and the next appends get new
+    // ranges from the underlying backend
+    for(auto& slot : m_slots) {
+        slot.mutex.lock();
+        slot.ranges.erase(object);
+    }
+    auto result = m_backend->execute(object, op);
+    for(auto& slot : m_slots)
+        slot.mutex.unlock();
+    return result;
+}
+
+RequestResult<bool> GappedBackend::flush() {
+    return m_backend->flush();
+}
+
+RequestResult<bool> GappedBackend::destroy() {
+    for(auto& slot : m_slots) {
+        std::lock_guard<thallium::mutex> lock(slot.mutex);
+        slot.ranges.clear();
+    }
+    return m_backend->destroy();
+}
+
+}
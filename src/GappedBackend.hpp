@@ -0,0 +1,136 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_GAPPED_BACKEND_HPP
+#define __MOBJECT_GAPPED_BACKEND_HPP
+
+#include <mobject/Backend.hpp>
+
+#include <thallium.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace mobject {
+
+/**
+ * @brief GappedBackend wraps another Backend and serves reservations
+ * from ranges held by each xstream, instead of serializing every
+ * reservation on the object's counter. When the range an xstream
+ * holds for an object is exhausted, it reserves a new one of
+ * "range_size" bytes (or more for large reservations) from the
+ * underlying backend. Reservations issued by ULTs running on
+ * different xstreams therefore never touch the same lock or cache
+ * line, and throughput scales with the number of xstreams serving
+ * the provider's pool.
+ *
+ * Reserved ranges remain unique, and roughly follow the order in which
+ * they were requested, but are no longer contiguous: the unused end of
+ * the ranges held by each xstream leaves holes (read as zeros) in
+ * objects filled by appends.
+ *
+ * The SequencerFactory wraps a backend in a GappedBackend when its
+ * configuration contains a "gapped" object, e.g.
+ * { "gapped" : { "range_size" : 65536 } }
+ */
+class GappedBackend : public Backend {
+
+    using json = nlohmann::json;
+
+    /**
+     * @brief Ranges held by the xstreams of a given rank (modulo num_slots).
+     * Slots are padded to reduce false sharing between neighbouring slots.
+     */
+    struct Slot {
+        thallium::mutex mutex;
+        std::unordered_map<std::string, std::pair<uint64_t, uint64_t>> ranges; // object -> [next, end)
+        char            padding[64];
+    };
+
+    static constexpr size_t num_slots = 64;
+
+    std::unique_ptr<Backend>        m_backend;
+    size_t                          m_range_size;
+    std::array<Slot, num_slots>     m_slots;
+
+    public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param backend Underlying backend.
+     * @param config "gapped" section of the sequencer configuration.
+     */
+    GappedBackend(std::unique_ptr<Backend>&& backend, const json& config);
+
+    void sayHello() override;
+
+    RequestResult<int32_t> computeSum(int32_t x, int32_t y) override;
+
+    RequestResult<bool> write(const std::string& object,
+                              uint64_t offset,
+                              const char* data,
+                              size_t size) override;
+
+    /**
+     * @brief Reserves the range from the range held by the calling
+     * xstream for this object, getting a new range from the underlying
+     * backend if it is exhausted.
+     */
+    RequestResult<uint64_t> reserve(const std::string& object,
+                                    size_t size) override;
+
+    RequestResult<size_t> read(const std::string& object,
+                               uint64_t offset,
+                               char* data,
+                               size_t size) override;
+
+    /**
+     * @brief Drops the ranges held for the object by all the xstreams
+     * and removes it from the underlying backend, holding the locks of
+     * all the slots so that no range of the object is obtained in between.
+     */
+    RequestResult<bool> remove(const std::string& object) override;
+
+    RequestResult<std::vector<std::string>> listObjects(
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) override;
+
+    RequestResult<bool> omapSet(const std::string& object,
+                                const std::vector<std::pair<std::string, std::string>>& entries) override;
+
+    RequestResult<std::vector<std::pair<std::string, std::string>>> omapGet(
+            const std::string& object,
+            const std::vector<std::string>& keys) override;
+
+    RequestResult<bool> omapRemove(const std::string& object,
+                                   const std::vector<std::string>& keys) override;
+
+    RequestResult<std::vector<std::pair<std::string, std::string>>> omapScan(
+            const std::string& object,
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) override;
+
+    /**
+     * @brief Executes the operation on the underlying backend. If it
+     * truncates the object, the ranges held for the object are dropped
+     * first, holding the locks of all the slots, as in remove.
+     */
+    RequestResult<uint64_t> execute(const std::string& object,
+                                    const WriteOp& op) override;
+
+    RequestResult<bool> flush() override;
+
+    RequestResult<bool> destroy() override;
+
+};
+
+}
+
+#endif
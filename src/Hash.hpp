@@ -0,0 +1,49 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_HASH_H
+#define __MOBJECT_HASH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace mobject {
+
+/**
+ * @brief Stable 64-bit hash used for data placement. Unlike std::hash,
+ * its value does not depend on the platform or standard library, so all
+ * the clients of a service agree on where an object lives. This is
+ * FNV-1a followed by the splitmix64 finalizer, which spreads the bits
+ * of short, similar names (e.g. "file.0", "file.1") across the output.
+ *
+ * @param data Data to hash.
+ * @param size Size of the data.
+ * @param seed Seed, to derive independent hash functions.
+ *
+ * @return the hash.
+ */
+inline uint64_t hash64(const void* data, size_t size, uint64_t seed = 0) {
+    auto p = static_cast<const unsigned char*>(data);
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+    for(size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+inline uint64_t hash64(const std::string& str, uint64_t seed = 0) {
+    return hash64(str.data(), str.size(), seed);
+}
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "Lanes.hpp"
+#include "mobject/Exception.hpp"
+
+#include <algorithm>
+
+namespace mobject {
+
+namespace tl = thallium;
+
+std::unique_ptr<Lanes> Lanes::fromConfig(const tl::engine& engine,
+                                         const json& config,
+                                         const tl::pool& pool) {
+    static const char* names[NUM_LANES] = { "admin", "control", "data" };
+    std::unique_ptr<Lanes> lanes(new Lanes());
+    tl::pool default_pool = pool.is_null() ? engine.get_handler_pool() : pool;
+    lanes->m_pools.fill(default_pool);
+    if(config.is_null()) return lanes;
+    if(not config.is_object())
+        throw Exception("\"lanes\" entry in provider configuration should be an object");
+    for(auto& item : config.items()) {
+        auto key = item.key();
+        if(std::find_if(names, names + NUM_LANES,
+                [&key](const char* name) { return key == name; }) == names + NUM_LANES)
+            throw Exception("Unknown lane \"" + key + "\" in provider configuration");
+    }
+    // dedicated lanes with their priority
+    std::vector<std::pair<int, Lane>> dedicated;
+    std::array<size_t, NUM_LANES> num_xstreams = {};
+    for(int i = 0; i < NUM_LANES; i++) {
+        auto lane = static_cast<Lane>(i);
+        if(not config.contains(names[i])) continue;
+        auto& lane_config = config[names[i]];
+        if(not lane_config.is_object())
+            throw Exception(std::string("\"lanes.") + names[i] + "\" should be an object");
+        num_xstreams[i] = lane_config.value("xstreams", (size_t)0);
+        if(num_xstreams[i] == 0) continue;
+        lanes->m_owned_pools.push_back(tl::pool::create(tl::pool::access::mpmc, tl::pool::kind::fifo_wait));
+        lanes->m_pools[i] = *lanes->m_owned_pools.back();
+        dedicated.emplace_back(lane_config.value("priority", 0), lane);
+    }
+    // highest priority first
+    std::stable_sort(dedicated.begin(), dedicated.end(),
+        [](const std::pair<int, Lane>& a, const std::pair<int, Lane>& b) {
+            return a.first > b.first;
+        });
+    for(auto& d : dedicated) {
+        std::vector<tl::pool> pools = { lanes->m_pools[d.second] };
+        for(auto& other : dedicated) {
+            if(other.first > d.first) pools.push_back(lanes->m_pools[other.second]);
+        }
+        for(size_t j = 0; j < num_xstreams[d.second]; j++) {
+            lanes->m_xstreams.push_back(tl::xstream::create(
+                tl::scheduler::predef::basic_wait, pools.begin(), pools.end()));
+        }
+    }
+    return lanes;
+}
+
+}
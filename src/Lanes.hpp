@@ -0,0 +1,74 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_LANES_HPP
+#define __MOBJECT_LANES_HPP
+
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace mobject {
+
+/**
+ * @brief Lanes holds the Argobots pools in which a provider runs its
+ * RPC handlers. RPCs are split into three lanes:
+ * - "admin": creating, opening, closing, destroying, migrating and
+ *   promoting sequencers, which may take a long time;
+ * - "control": provider-to-provider traffic (replication, migration
+ *   transfers) and cheap control RPCs (checks, watches);
+ * - "data": the operations on the objects of the sequencers.
+ *
+ * By default all the lanes use the pool the provider was given. The
+ * "lanes" section of the provider configuration can give a lane its
+ * own pool, served by its own xstreams, e.g.
+ * { "lanes" : { "admin" : { "xstreams" : 1, "priority" : 0 },
+ *               "data"  : { "xstreams" : 4, "priority" : 2 } } }
+ * The xstreams of a lane run the lane's RPCs first, and, when there are
+ * none, those of the other dedicated lanes of higher priority (higher
+ * value, from the highest), so that a slow admin operation never runs
+ * on the xstreams of the data lane while idle admin xstreams help with
+ * data RPCs. Lanes without "xstreams" (or with 0) use the provider's pool.
+ */
+class Lanes {
+
+    using json = nlohmann::json;
+
+    public:
+
+    enum Lane { ADMIN = 0, CONTROL = 1, DATA = 2, NUM_LANES = 3 };
+
+    /**
+     * @brief Builds the lanes from the "lanes" section of a provider's
+     * configuration (which may be null). pool is the provider's pool
+     * (the engine's handler pool if null).
+     */
+    static std::unique_ptr<Lanes> fromConfig(const thallium::engine& engine,
+                                             const json& config,
+                                             const thallium::pool& pool);
+
+    /**
+     * @brief Returns the pool in which to run the RPCs of a lane.
+     */
+    const thallium::pool& pool(Lane lane) const {
+        return m_pools[lane];
+    }
+
+    private:
+
+    Lanes() = default;
+
+    std::array<thallium::pool, NUM_LANES>             m_pools;
+    std::vector<thallium::managed<thallium::pool>>    m_owned_pools;
+    // declared after the pools, so that they are joined before the pools are freed
+    std::vector<thallium::managed<thallium::xstream>> m_xstreams;
+};
+
+}
+
+#endif
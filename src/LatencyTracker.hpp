@@ -0,0 +1,81 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_LATENCY_TRACKER_HPP
+#define __MOBJECT_LATENCY_TRACKER_HPP
+
+#include <thallium.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <mutex>
+
+namespace mobject {
+
+/**
+ * @brief LatencyTracker keeps the latencies of the last num_samples
+ * requests of a given kind and estimates a percentile of them, which
+ * hedged reads use as the delay after which a request is considered
+ * slow. The percentile is recomputed every refresh_period samples
+ * rather than on every request.
+ */
+class LatencyTracker {
+
+    public:
+
+    using duration = std::chrono::microseconds;
+
+    static constexpr size_t num_samples    = 512;
+    static constexpr size_t refresh_period = 32;
+    // number of samples below which percentile() returns its default
+    static constexpr size_t min_samples    = 32;
+
+    /**
+     * @brief Records the latency of a request.
+     */
+    void record(duration latency) {
+        std::lock_guard<thallium::mutex> lock(m_mtx);
+        m_samples[m_count % num_samples] = latency;
+        m_count += 1;
+        if(m_count % refresh_period == 0) m_stale = true;
+    }
+
+    /**
+     * @brief Returns the given percentile (in [0, 100]) of the recorded
+     * latencies, or default_value if too few latencies were recorded.
+     */
+    duration percentile(double p, duration default_value) {
+        std::lock_guard<thallium::mutex> lock(m_mtx);
+        if(m_count < min_samples) return default_value;
+        if(m_stale || p != m_percentile) {
+            // local copy: std::min takes its arguments by reference, and
+            // the static member has no out-of-class definition
+            const size_t max_samples = num_samples;
+            size_t n = std::min(m_count, max_samples);
+            std::array<duration, num_samples> sorted;
+            std::copy(m_samples.begin(), m_samples.begin() + n, sorted.begin());
+            size_t k = std::min(n - 1, static_cast<size_t>(p / 100.0 * n));
+            std::nth_element(sorted.begin(), sorted.begin() + k, sorted.begin() + n);
+            m_value      = sorted[k];
+            m_percentile = p;
+            m_stale      = false;
+        }
+        return m_value;
+    }
+
+    private:
+
+    thallium::mutex                   m_mtx;
+    std::array<duration, num_samples> m_samples;
+    size_t                            m_count = 0;
+    bool                              m_stale = true;
+    double                            m_percentile = -1;
+    duration                          m_value = duration(0);
+};
+
+}
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "MigratingBackend.hpp"
+
+namespace mobject {
+
+void MigratingBackend::markDirty(const std::string& object) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    m_dirty.insert(object);
+}
+
+std::vector<std::string> MigratingBackend::takeDirty() {
+    std::unordered_set<std::string> dirty;
+    {
+        std::lock_guard<thallium::mutex> lock(m_mtx);
+        dirty.swap(m_dirty);
+    }
+    return std::vector<std::string>(dirty.begin(), dirty.end());
+}
+
+void MigratingBackend::sayHello() {
+    m_backend->sayHello();
+}
+
+RequestResult<int32_t> MigratingBackend::computeSum(int32_t x, int32_t y) {
+    return m_backend->computeSum(x, y);
+}
+
+RequestResult<bool> MigratingBackend::write(const std::string& object,
+                                            uint64_t offset,
+                                            const char* data,
+                                            size_t size) {
+    auto result = m_backend->write(object, offset, data, size);
+    markDirty(object);
+    return result;
+}
+
+RequestResult<uint64_t> MigratingBackend::reserve(const std::string& object,
+                                                  size_t size) {
+    auto result = m_backend->reserve(object, size);
+    markDirty(object);
+    return result;
+}
+
+RequestResult<size_t> MigratingBackend::read(const std::string& object,
+                                             uint64_t offset,
+                                             char* data,
+                                             size_t size) {
+    return m_backend->read(object, offset, data, size);
+}
+
+RequestResult<bool> MigratingBackend::remove(const std::string& object) {
+    auto result = m_backend->remove(object);
+    markDirty(object);
+    return result;
+}
+
+RequestResult<std::vector<std::string>> MigratingBackend::listObjects(
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) {
+    return m_backend->listObjects(prefix, start_after, max);
+}
+
+RequestResult<bool> MigratingBackend::omapSet(const std::string& object,
+                                              const KeyValues& entries) {
+    auto result = m_backend->omapSet(object, entries);
+    markDirty(object);
+    return result;
+}
+
+RequestResult<MigratingBackend::KeyValues> MigratingBackend::omapGet(
+        const std::string& object,
+        const std::vector<std::string>& keys) {
+    return m_backend->omapGet(object, keys);
+}
+
+RequestResult<bool> MigratingBackend::omapRemove(const std::string& object,
+                                                 const std::vector<std::string>& keys) {
+    auto result = m_backend->omapRemove(object, keys);
+    markDirty(object);
+    return result;
+}
+
+RequestResult<MigratingBackend::KeyValues> MigratingBackend::omapScan(
+        const std::string& object,
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) {
+    return m_backend->omapScan(object, prefix, start_after, max);
+}
+
+RequestResult<uint64_t> MigratingBackend::execute(const std::string& object,
+                                                  const WriteOp& op) {
+    auto result = m_backend->execute(object, op);
+    markDirty(object);
+    return result;
+}
+
+RequestResult<bool> MigratingBackend::flush() {
+    return m_backend->flush();
+}
+
+RequestResult<bool> MigratingBackend::destroy() {
+    return m_backend->destroy();
+}
+
+}
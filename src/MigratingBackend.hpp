@@ -0,0 +1,109 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_MIGRATING_BACKEND_HPP
+#define __MOBJECT_MIGRATING_BACKEND_HPP
+
+#include <mobject/Backend.hpp>
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace mobject {
+
+/**
+ * @brief MigratingBackend wraps the backend of a sequencer while it
+ * is being migrated to another provider. It forwards every call to the
+ * wrapped backend and records the names of the objects modified since
+ * the last call to takeDirty(), so that the migration can copy them
+ * again. Objects are recorded after the modification has been applied,
+ * so an object copied after takeDirty() returned it is never stale.
+ */
+class MigratingBackend : public Backend {
+
+    using KeyValues = std::vector<std::pair<std::string, std::string>>;
+
+    std::shared_ptr<Backend>        m_backend;
+    std::unordered_set<std::string> m_dirty;
+    thallium::mutex                 m_mtx;
+
+    void markDirty(const std::string& object);
+
+    public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param backend Backend of the sequencer being migrated.
+     */
+    MigratingBackend(const std::shared_ptr<Backend>& backend)
+    : m_backend(backend) {}
+
+    /**
+     * @brief Returns the wrapped backend.
+     */
+    const std::shared_ptr<Backend>& backend() const {
+        return m_backend;
+    }
+
+    /**
+     * @brief Returns the objects modified since the previous call, and
+     * starts recording modifications anew.
+     */
+    std::vector<std::string> takeDirty();
+
+    void sayHello() override;
+
+    RequestResult<int32_t> computeSum(int32_t x, int32_t y) override;
+
+    RequestResult<bool> write(const std::string& object,
+                              uint64_t offset,
+                              const char* data,
+                              size_t size) override;
+
+    RequestResult<uint64_t> reserve(const std::string& object,
+                                    size_t size) override;
+
+    RequestResult<size_t> read(const std::string& object,
+                               uint64_t offset,
+                               char* data,
+                               size_t size) override;
+
+    RequestResult<bool> remove(const std::string& object) override;
+
+    RequestResult<std::vector<std::string>> listObjects(
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) override;
+
+    RequestResult<bool> omapSet(const std::string& object,
+                                const KeyValues& entries) override;
+
+    RequestResult<KeyValues> omapGet(
+            const std::string& object,
+            const std::vector<std::string>& keys) override;
+
+    RequestResult<bool> omapRemove(const std::string& object,
+                                   const std::vector<std::string>& keys) override;
+
+    RequestResult<KeyValues> omapScan(
+            const std::string& object,
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) override;
+
+    RequestResult<uint64_t> execute(const std::string& object,
+                                    const WriteOp& op) override;
+
+    RequestResult<bool> flush() override;
+
+    RequestResult<bool> destroy() override;
+};
+
+}
+
+#endif
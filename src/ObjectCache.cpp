@@ -0,0 +1,351 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "mobject/Exception.hpp"
+#include "ObjectCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace mobject {
+
+ObjectCache::ObjectCache(size_t capacity, size_t block_size,
+                         size_t num_shards, Policy policy)
+: m_capacity(capacity)
+, m_block_size(block_size)
+, m_policy(policy) {
+    // each shard can hold at least one block, so a small capacity is
+    // split into fewer shards rather than into shards that cache nothing
+    size_t max_shards = block_size ? capacity / block_size : capacity;
+    num_shards = std::max<size_t>(1, std::min(num_shards, max_shards));
+    m_shards.reserve(num_shards);
+    for(size_t i = 0; i < num_shards; i++) {
+        m_shards.emplace_back(new Shard);
+        m_shards.back()->capacity = capacity / num_shards + (i < capacity % num_shards ? 1 : 0);
+    }
+}
+
+std::unique_ptr<ObjectCache> ObjectCache::fromConfig(const json& config) {
+    if(not config.is_object())
+        throw Exception("\"cache\" entry in provider configuration should be an object");
+    size_t capacity   = config.value("capacity", (size_t)0);
+    size_t block_size = config.value("block_size", (size_t)65536);
+    size_t num_shards = config.value("shards", (size_t)16);
+    auto policy_name  = config.value("policy", std::string("arc"));
+    if(capacity == 0)
+        throw Exception("\"cache.capacity\" should be a strictly positive number of bytes");
+    if(block_size == 0)
+        throw Exception("\"cache.block_size\" should be strictly positive");
+    if(num_shards == 0)
+        throw Exception("\"cache.shards\" should be strictly positive");
+    Policy policy;
+    if(policy_name == "arc") policy = Policy::ARC;
+    else if(policy_name == "lru") policy = Policy::LRU;
+    else throw Exception("Unknown cache policy \"" + policy_name + "\"");
+    return std::unique_ptr<ObjectCache>(
+        new ObjectCache(capacity, block_size, num_shards, policy));
+}
+
+RequestResult<size_t> ObjectCache::read(const UUID& sequencer_id,
+                                        Backend& backend,
+                                        const std::string& object,
+                                        uint64_t offset,
+                                        char* data,
+                                        size_t size) {
+    if(size == 0) return backend.read(object, offset, data, size);
+
+    RequestResult<size_t> result;
+
+    auto  key   = makeKey(sequencer_id, object);
+    auto& shard = shardFor(key);
+    size_t total = 0;
+    uint64_t first = offset / m_block_size;
+    uint64_t last  = (offset + size - 1) / m_block_size;
+
+    for(uint64_t b = first; b <= last; b++) {
+        std::shared_ptr<const std::string> block_data;
+        uint64_t epoch;
+        {
+            std::lock_guard<tl::mutex> lock(shard.mutex);
+            block_data = lookup(shard, key, b);
+            epoch = shard.epoch;
+        }
+        if(not block_data) {
+            std::string buffer(m_block_size, '\0');
+            auto r = backend.read(object, b*m_block_size, &buffer[0], m_block_size);
+            if(not r.success()) {
+                result.success() = false;
+                result.error() = r.error();
+                return result;
+            }
+            buffer.resize(r.value());
+            block_data = std::make_shared<const std::string>(std::move(buffer));
+            insert(shard, epoch, key, b, block_data);
+        }
+        uint64_t block_start = b*m_block_size;
+        uint64_t from = std::max(offset, block_start) - block_start;
+        if(from >= block_data->size()) break;
+        size_t n = std::min<uint64_t>(block_data->size() - from,
+                                      offset + size - (block_start + from));
+        std::memcpy(data + total, block_data->data() + from, n);
+        total += n;
+        if(block_data->size() < m_block_size) break; // end of object
+    }
+    result.value() = total;
+    return result;
+}
+
+void ObjectCache::invalidate(const UUID& sequencer_id,
+                             const std::string& object,
+                             uint64_t offset, size_t size) {
+    auto  key   = makeKey(sequencer_id, object);
+    auto& shard = shardFor(key);
+    std::lock_guard<tl::mutex> lock(shard.mutex);
+    shard.epoch += 1;
+    auto oit = shard.objects.find(key);
+    if(oit == shard.objects.end()) return;
+    auto& blocks = oit->second;
+    uint64_t first = offset / m_block_size;
+    uint64_t last  = (offset + std::max<size_t>(size, 1) - 1) / m_block_size;
+    // a write at or past the cached end of the object changes the
+    // size of its last block, even if it does not overlap with it
+    if(blocks.eof_block <= last) {
+        unlink(shard, blocks, blocks.eof_block);
+        blocks.eof_block = UINT64_MAX;
+    }
+    if(last - first + 1 < blocks.blocks.size()) {
+        for(uint64_t b = first; b <= last; b++)
+            unlink(shard, blocks, b);
+    } else {
+        std::vector<uint64_t> to_remove;
+        for(auto& p : blocks.blocks) {
+            if(p.first >= first && p.first <= last)
+                to_remove.push_back(p.first);
+        }
+        for(auto b : to_remove)
+            unlink(shard, blocks, b);
+    }
+    if(blocks.blocks.empty())
+        shard.objects.erase(oit);
+}
+
+void ObjectCache::invalidate(const UUID& sequencer_id,
+                             const std::string& object) {
+    auto  key   = makeKey(sequencer_id, object);
+    auto& shard = shardFor(key);
+    std::lock_guard<tl::mutex> lock(shard.mutex);
+    shard.epoch += 1;
+    eraseObject(shard, key);
+}
+
+void ObjectCache::invalidate(const UUID& sequencer_id) {
+    auto prefix = makeKey(sequencer_id, "");
+    for(auto& shard : m_shards) {
+        std::lock_guard<tl::mutex> lock(shard->mutex);
+        shard->epoch += 1;
+        std::vector<std::string> to_remove;
+        for(auto& p : shard->objects) {
+            if(p.first.compare(0, prefix.size(), prefix) == 0)
+                to_remove.push_back(p.first);
+        }
+        for(auto& key : to_remove)
+            eraseObject(*shard, key);
+    }
+}
+
+ObjectCache::json ObjectCache::getConfig() const {
+    json config = json::object();
+    config["capacity"]   = m_capacity;
+    config["block_size"] = m_block_size;
+    config["shards"]     = m_shards.size();
+    config["policy"]     = m_policy == Policy::ARC ? "arc" : "lru";
+    return config;
+}
+
+ObjectCache::json ObjectCache::getStatistics() const {
+    uint64_t hits = 0, misses = 0, evictions = 0;
+    size_t size = 0;
+    for(auto& shard : m_shards) {
+        std::lock_guard<tl::mutex> lock(shard->mutex);
+        hits      += shard->hits;
+        misses    += shard->misses;
+        evictions += shard->evictions;
+        size      += shard->t1_bytes + shard->t2_bytes;
+    }
+    json stats = json::object();
+    stats["hits"]      = hits;
+    stats["misses"]    = misses;
+    stats["evictions"] = evictions;
+    stats["size"]      = size;
+    stats["capacity"]  = m_capacity;
+    return stats;
+}
+
+std::string ObjectCache::makeKey(const UUID& sequencer_id, const std::string& object) {
+    std::string key(reinterpret_cast<const char*>(sequencer_id.m_data), sizeof(uuid_t));
+    key += object;
+    return key;
+}
+
+ObjectCache::Shard& ObjectCache::shardFor(const std::string& key) {
+    return *m_shards[std::hash<std::string>()(key) % m_shards.size()];
+}
+
+std::shared_ptr<const std::string> ObjectCache::lookup(Shard& shard,
+                                                       const std::string& key,
+                                                       uint64_t block) {
+    auto oit = shard.objects.find(key);
+    if(oit != shard.objects.end()) {
+        auto bit = oit->second.blocks.find(block);
+        if(bit != oit->second.blocks.end()) {
+            auto& loc = bit->second;
+            if(loc.list == ListId::T1 || loc.list == ListId::T2) {
+                shard.hits += 1;
+                moveTo(shard, loc, m_policy == Policy::ARC ? ListId::T2 : ListId::T1, false);
+                return loc.it->data;
+            }
+        }
+    }
+    shard.misses += 1;
+    return nullptr;
+}
+
+void ObjectCache::insert(Shard& shard, uint64_t epoch,
+                         const std::string& key, uint64_t block,
+                         std::shared_ptr<const std::string> data) {
+    std::lock_guard<tl::mutex> lock(shard.mutex);
+    // the object was modified while we were reading it from the backend
+    if(shard.epoch != epoch) return;
+    size_t size = data->size();
+    // empty blocks (past the end of the object) are not cached, which
+    // guarantees that at most one cached block per object is partial
+    if(size == 0 || size > shard.capacity) return;
+
+    auto oit = shard.objects.find(key);
+    if(oit != shard.objects.end()) {
+        auto bit = oit->second.blocks.find(block);
+        if(bit != oit->second.blocks.end()) {
+            auto& loc = bit->second;
+            // another ULT inserted the block concurrently
+            if(loc.list == ListId::T1 || loc.list == ListId::T2) return;
+            // ghost hit: adapt the target size of T1
+            if(loc.list == ListId::B1) {
+                size_t ratio = std::max<size_t>(shard.b2_bytes / std::max<size_t>(shard.b1_bytes, 1), 1);
+                shard.target_t1 = std::min(shard.capacity, shard.target_t1 + ratio*size);
+                replace(shard, size, false);
+            } else {
+                size_t ratio = std::max<size_t>(shard.b1_bytes / std::max<size_t>(shard.b2_bytes, 1), 1);
+                shard.target_t1 = shard.target_t1 > ratio*size ? shard.target_t1 - ratio*size : 0;
+                replace(shard, size, true);
+            }
+            bytesOf(shard, loc.list) -= loc.it->size;
+            loc.it->size = size;
+            loc.it->data = std::move(data);
+            shard.t2.splice(shard.t2.begin(), listOf(shard, loc.list), loc.it);
+            shard.t2_bytes += size;
+            loc.list = ListId::T2;
+            if(size < m_block_size) oit->second.eof_block = block;
+            trimGhosts(shard);
+            return;
+        }
+    }
+
+    // replace() may erase entries from shard.objects,
+    // so it must be called before we take a reference into it
+    replace(shard, size, false);
+    auto& blocks = shard.objects[key];
+    shard.t1.push_front(Entry{key, block, size, std::move(data)});
+    shard.t1_bytes += size;
+    blocks.blocks[block] = Location{ListId::T1, shard.t1.begin()};
+    if(size < m_block_size) blocks.eof_block = block;
+    trimGhosts(shard);
+}
+
+void ObjectCache::replace(Shard& shard, size_t incoming, bool hit_in_b2) {
+    while(shard.t1_bytes + shard.t2_bytes + incoming > shard.capacity) {
+        if(m_policy == Policy::LRU) {
+            auto& e = shard.t1.back();
+            auto key = e.object;
+            auto oit = shard.objects.find(key);
+            unlink(shard, oit->second, e.block);
+            if(oit->second.blocks.empty()) shard.objects.erase(oit);
+        } else {
+            bool from_t1 = not shard.t1.empty()
+                && (shard.t1_bytes > shard.target_t1
+                    || (hit_in_b2 && shard.t1_bytes == shard.target_t1)
+                    || shard.t2.empty());
+            auto& e = from_t1 ? shard.t1.back() : shard.t2.back();
+            auto& loc = shard.objects[e.object].blocks[e.block];
+            moveTo(shard, loc, from_t1 ? ListId::B1 : ListId::B2, true);
+        }
+        shard.evictions += 1;
+    }
+}
+
+void ObjectCache::trimGhosts(Shard& shard) {
+    auto drop_lru = [this, &shard](EntryList& list) {
+        auto& e = list.back();
+        auto key = e.object;
+        auto oit = shard.objects.find(key);
+        unlink(shard, oit->second, e.block);
+        if(oit->second.blocks.empty()) shard.objects.erase(oit);
+    };
+    while(not shard.b1.empty()
+       && shard.t1_bytes + shard.b1_bytes > shard.capacity)
+        drop_lru(shard.b1);
+    while(not shard.b2.empty()
+       && shard.t1_bytes + shard.t2_bytes + shard.b1_bytes + shard.b2_bytes > 2*shard.capacity)
+        drop_lru(shard.b2);
+}
+
+ObjectCache::EntryList& ObjectCache::listOf(Shard& shard, ListId id) {
+    switch(id) {
+    case ListId::T1: return shard.t1;
+    case ListId::T2: return shard.t2;
+    case ListId::B1: return shard.b1;
+    default:         return shard.b2;
+    }
+}
+
+size_t& ObjectCache::bytesOf(Shard& shard, ListId id) {
+    switch(id) {
+    case ListId::T1: return shard.t1_bytes;
+    case ListId::T2: return shard.t2_bytes;
+    case ListId::B1: return shard.b1_bytes;
+    default:         return shard.b2_bytes;
+    }
+}
+
+void ObjectCache::unlink(Shard& shard, ObjectBlocks& blocks, uint64_t block) {
+    auto bit = blocks.blocks.find(block);
+    if(bit == blocks.blocks.end()) return;
+    auto& loc = bit->second;
+    bytesOf(shard, loc.list) -= loc.it->size;
+    listOf(shard, loc.list).erase(loc.it);
+    blocks.blocks.erase(bit);
+}
+
+void ObjectCache::moveTo(Shard& shard, Location& loc, ListId to, bool drop_data) {
+    auto& from_list = listOf(shard, loc.list);
+    auto& to_list   = listOf(shard, to);
+    bytesOf(shard, loc.list) -= loc.it->size;
+    to_list.splice(to_list.begin(), from_list, loc.it);
+    bytesOf(shard, to) += loc.it->size;
+    if(drop_data) loc.it->data.reset();
+    loc.list = to;
+}
+
+void ObjectCache::eraseObject(Shard& shard, const std::string& key) {
+    auto oit = shard.objects.find(key);
+    if(oit == shard.objects.end()) return;
+    for(auto& p : oit->second.blocks) {
+        bytesOf(shard, p.second.list) -= p.second.it->size;
+        listOf(shard, p.second.list).erase(p.second.it);
+    }
+    shard.objects.erase(oit);
+}
+
+}
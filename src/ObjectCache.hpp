@@ -0,0 +1,189 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_OBJECT_CACHE_H
+#define __MOBJECT_OBJECT_CACHE_H
+
+#include "mobject/Backend.hpp"
+#include "mobject/UUID.hpp"
+
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace mobject {
+
+namespace tl = thallium;
+
+/**
+ * @brief The ObjectCache keeps blocks of object data in memory
+ * so that repeated reads of hot objects do not go to the backend.
+ * It is shared by all the sequencers of a provider. Object data
+ * is cached in fixed-size blocks, and the total amount of cached
+ * data never exceeds the configured capacity.
+ *
+ * The cache is split into shards, each protected by its own mutex,
+ * so that ULTs running on different xstreams rarely contend. All
+ * the blocks of a given object live in the same shard. Each shard
+ * uses either an adaptive replacement (ARC) or an LRU policy.
+ */
+class ObjectCache {
+
+    using json = nlohmann::json;
+
+    public:
+
+    enum class Policy { ARC, LRU };
+
+    /**
+     * @brief Constructor.
+     *
+     * @param capacity Maximum number of bytes of data to cache.
+     * @param block_size Size of the blocks in which objects are cached.
+     * @param num_shards Number of independently-locked shards, reduced
+     * if needed so that each shard can hold at least one block.
+     * @param policy Replacement policy.
+     */
+    ObjectCache(size_t capacity, size_t block_size,
+                size_t num_shards, Policy policy);
+
+    /**
+     * @brief Builds an ObjectCache from the "cache" section
+     * of a provider's configuration. Throws an Exception if
+     * the configuration is invalid.
+     *
+     * @param config JSON configuration of the cache.
+     *
+     * @return a unique_ptr to the created ObjectCache.
+     */
+    static std::unique_ptr<ObjectCache> fromConfig(const json& config);
+
+    /**
+     * @brief Reads data from an object, serving it from the cache
+     * when possible and populating the cache from the backend otherwise.
+     *
+     * @param sequencer_id UUID of the sequencer holding the object.
+     * @param backend Backend of that sequencer.
+     * @param object Name of the object.
+     * @param offset Offset at which to read.
+     * @param data Buffer in which to place the data.
+     * @param size Size of the buffer.
+     *
+     * @return a RequestResult containing the number of bytes read.
+     */
+    RequestResult<size_t> read(const UUID& sequencer_id,
+                               Backend& backend,
+                               const std::string& object,
+                               uint64_t offset,
+                               char* data,
+                               size_t size);
+
+    /**
+     * @brief Invalidates the blocks covering a range of an object.
+     * Must be called after the range has been modified in the backend.
+     */
+    void invalidate(const UUID& sequencer_id,
+                    const std::string& object,
+                    uint64_t offset, size_t size);
+
+    /**
+     * @brief Invalidates all the blocks of an object.
+     */
+    void invalidate(const UUID& sequencer_id,
+                    const std::string& object);
+
+    /**
+     * @brief Invalidates all the blocks of all the objects of a sequencer.
+     */
+    void invalidate(const UUID& sequencer_id);
+
+    /**
+     * @brief Returns the configuration of the cache.
+     */
+    json getConfig() const;
+
+    /**
+     * @brief Returns hit/miss counters and current usage.
+     */
+    json getStatistics() const;
+
+    private:
+
+    enum class ListId { NONE, T1, T2, B1, B2 };
+
+    struct Entry {
+        std::string                        object;
+        uint64_t                           block;
+        size_t                             size;
+        std::shared_ptr<const std::string> data; // null for ghost entries
+    };
+
+    using EntryList = std::list<Entry>;
+
+    struct Location {
+        ListId              list;
+        EntryList::iterator it;
+    };
+
+    struct ObjectBlocks {
+        std::unordered_map<uint64_t, Location> blocks;
+        uint64_t                               eof_block = UINT64_MAX;
+    };
+
+    struct Shard {
+        mutable tl::mutex mutex;
+        uint64_t          epoch = 0;
+        size_t            capacity = 0;
+        size_t            target_t1 = 0; // "p" in the ARC paper, in bytes
+        EntryList         t1, t2, b1, b2;
+        size_t            t1_bytes = 0, t2_bytes = 0, b1_bytes = 0, b2_bytes = 0;
+        std::unordered_map<std::string, ObjectBlocks> objects;
+        uint64_t          hits = 0;
+        uint64_t          misses = 0;
+        uint64_t          evictions = 0;
+    };
+
+    size_t                              m_capacity;
+    size_t                              m_block_size;
+    Policy                              m_policy;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+
+    static std::string makeKey(const UUID& sequencer_id, const std::string& object);
+
+    Shard& shardFor(const std::string& key);
+
+    std::shared_ptr<const std::string> lookup(Shard& shard,
+                                              const std::string& key,
+                                              uint64_t block);
+
+    void insert(Shard& shard, uint64_t epoch,
+                const std::string& key, uint64_t block,
+                std::shared_ptr<const std::string> data);
+
+    void replace(Shard& shard, size_t incoming, bool hit_in_b2);
+
+    void trimGhosts(Shard& shard);
+
+    EntryList& listOf(Shard& shard, ListId id);
+
+    size_t& bytesOf(Shard& shard, ListId id);
+
+    void unlink(Shard& shard, ObjectBlocks& blocks, uint64_t block);
+
+    void moveTo(Shard& shard, Location& loc, ListId to, bool drop_data);
+
+    void eraseObject(Shard& shard, const std::string& key);
+};
+
+}
+
+#endif
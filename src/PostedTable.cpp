@@ -0,0 +1,118 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "PostedTable.hpp"
+#include "Timespec.hpp"
+
+#include <algorithm>
+
+namespace mobject {
+
+using namespace std::string_literals;
+
+PostedTable::PostedTable(std::chrono::milliseconds turn_timeout,
+                         std::chrono::milliseconds idle_timeout)
+: m_turn_timeout(turn_timeout)
+, m_idle_timeout(idle_timeout) {}
+
+PostedTable::Stream& PostedTable::findStream(const UUID& client_id, const UUID& sequencer_id) {
+    auto now = clock::now();
+    if(now - m_last_sweep > m_idle_timeout) {
+        for(auto client = m_streams.begin(); client != m_streams.end();) {
+            auto& streams = client->second;
+            for(auto it = streams.begin(); it != streams.end();) {
+                auto& stream = it->second;
+                bool idle = stream.waiting == 0 && stream.started == stream.applied
+                         && now - stream.used > m_idle_timeout;
+                if(idle) it = streams.erase(it);
+                else ++it;
+            }
+            if(streams.empty()) client = m_streams.erase(client);
+            else ++client;
+        }
+        m_last_sweep = now;
+    }
+    auto& stream = m_streams[client_id][sequencer_id];
+    stream.used = now;
+    return stream;
+}
+
+bool PostedTable::waitTurn(const UUID& client_id, const UUID& sequencer_id, uint64_t posted_seq) {
+    auto deadline = clock::now() + m_turn_timeout;
+    std::unique_lock<thallium::mutex> lock(m_mtx);
+    findStream(client_id, sequencer_id).waiting += 1;
+    // the stream may be rehashed while waiting, so it is looked up again
+    while(findStream(client_id, sequencer_id).applied + 1 < posted_seq) {
+        auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - clock::now()).count();
+        if(wait <= 0) {
+            auto& stream = findStream(client_id, sequencer_id);
+            if(stream.started > stream.applied) {
+                // the previous operation arrived and is still being applied
+                deadline = clock::now() + m_turn_timeout;
+                continue;
+            }
+            if(stream.failed == 0)
+                stream.first_error = "Posted operations "s + std::to_string(stream.applied + 1)
+                                   + " to " + std::to_string(posted_seq - 1) + " never arrived";
+            stream.failed += posted_seq - 1 - stream.applied;
+            stream.applied = posted_seq - 1;
+            m_cv.notify_all();
+            break;
+        }
+        auto ts = timespecIn(std::chrono::nanoseconds(wait));
+        m_cv.wait_until(lock, &ts);
+    }
+    auto& stream = findStream(client_id, sequencer_id);
+    stream.waiting -= 1;
+    // an operation that arrives after having been given up on was
+    // already recorded as failed
+    if(stream.applied >= posted_seq) return false;
+    stream.started = posted_seq;
+    return true;
+}
+
+void PostedTable::complete(const UUID& client_id, const UUID& sequencer_id, uint64_t posted_seq,
+                           const std::string& error, bool success) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    auto& stream = findStream(client_id, sequencer_id);
+    stream.applied = std::max(stream.applied, posted_seq);
+    if(not success) {
+        if(stream.failed == 0) stream.first_error = error;
+        stream.failed += 1;
+    }
+    m_cv.notify_all();
+}
+
+RequestResult<uint64_t> PostedTable::barrier(const UUID& client_id, const UUID& sequencer_id,
+                                             uint64_t posted_seq, clock::time_point deadline) {
+    RequestResult<uint64_t> result;
+    std::unique_lock<thallium::mutex> lock(m_mtx);
+    findStream(client_id, sequencer_id).waiting += 1;
+    // the stream may be rehashed while waiting, so it is looked up again
+    while(findStream(client_id, sequencer_id).applied < posted_seq) {
+        if(deadline == clock::time_point::max()) {
+            m_cv.wait(lock);
+            continue;
+        }
+        auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - clock::now()).count();
+        if(wait <= 0) {
+            findStream(client_id, sequencer_id).waiting -= 1;
+            result.success() = false;
+            result.error() = "Request timed out waiting for posted operations";
+            return result;
+        }
+        auto ts = timespecIn(std::chrono::nanoseconds(wait));
+        m_cv.wait_until(lock, &ts);
+    }
+    auto& stream = findStream(client_id, sequencer_id);
+    stream.waiting -= 1;
+    result.value() = stream.failed;
+    result.error() = std::move(stream.first_error);
+    stream.failed = 0;
+    stream.first_error.clear();
+    return result;
+}
+
+}
@@ -0,0 +1,113 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_POSTED_TABLE_HPP
+#define __MOBJECT_POSTED_TABLE_HPP
+
+#include "mobject/RequestResult.hpp"
+#include "mobject/UUID.hpp"
+
+#include <thallium.hpp>
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+namespace mobject {
+
+/**
+ * @brief The PostedTable keeps track of the posted operations (see
+ * SequencerHandle::withPosting) that each client sends to each
+ * sequencer. The client sends no response for them and numbers them
+ * 1, 2, 3... in each such stream; the provider applies them in this
+ * order, whatever the order in which their handlers run, and records
+ * the errors of those that failed. A barrier request for number n
+ * waits until the operations up to n have been applied and returns
+ * the errors recorded since the previous barrier.
+ *
+ * An operation does not wait forever for the ones before it, which may
+ * never arrive (e.g. if the client failed): after the table's turn
+ * timeout, the missing operations are recorded as failed and skipped,
+ * and are ignored if they arrive later.
+ *
+ * The client starts a new stream (with a new UUID) after each barrier,
+ * so a stream that has no operation in progress and has not been used
+ * for the table's idle timeout is forgotten. Only a client that left
+ * operations without a barrier for that long loses anything: its next
+ * barrier reports them as missing.
+ *
+ * The provider configures the table from the "posted" section of its
+ * configuration, e.g.
+ * { "posted" : { "turn_timeout_ms" : 30000, "idle_timeout_ms" : 600000 } }
+ */
+class PostedTable {
+
+    using clock = std::chrono::steady_clock;
+
+    public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param turn_timeout How long an operation waits for the ones
+     * posted before it.
+     * @param idle_timeout How long an unused stream is remembered.
+     */
+    PostedTable(std::chrono::milliseconds turn_timeout,
+                std::chrono::milliseconds idle_timeout);
+
+    /**
+     * @brief Waits until the posted operations preceding posted_seq in
+     * the stream of the client on the sequencer have been applied, or
+     * until the turn timeout, after which those still missing are
+     * recorded as failed. Returns true if the operation must then be
+     * applied, in which case complete() must be called with its result,
+     * and false if it was itself recorded as missing, in which case it
+     * must be ignored.
+     */
+    bool waitTurn(const UUID& client_id, const UUID& sequencer_id, uint64_t posted_seq);
+
+    /**
+     * @brief Records that a posted operation was applied, with its result.
+     */
+    void complete(const UUID& client_id, const UUID& sequencer_id, uint64_t posted_seq,
+                  const std::string& error, bool success);
+
+    /**
+     * @brief Waits until the posted operations up to posted_seq have
+     * been applied, or until the deadline. The value of the result is
+     * the number of operations that failed since the previous barrier,
+     * and its error the error of the first of them.
+     */
+    RequestResult<uint64_t> barrier(const UUID& client_id, const UUID& sequencer_id,
+                                    uint64_t posted_seq, clock::time_point deadline);
+
+    private:
+
+    struct Stream {
+        uint64_t    started = 0; // number of the last operation whose turn came
+        uint64_t    applied = 0; // number of the last operation applied
+        uint64_t    failed = 0;  // operations failed since the last barrier
+        std::string first_error;
+        unsigned    waiting = 0; // operations and barriers waiting on the stream
+        clock::time_point used;
+    };
+
+    // finds or creates a stream, marking it as used, after forgetting
+    // the idle streams if they were not looked for in a while
+    Stream& findStream(const UUID& client_id, const UUID& sequencer_id);
+
+    std::chrono::milliseconds m_turn_timeout;
+    std::chrono::milliseconds m_idle_timeout;
+    clock::time_point         m_last_sweep = clock::now();
+    // streams of each client, by sequencer
+    std::unordered_map<UUID, std::unordered_map<UUID, Stream>> m_streams;
+    thallium::mutex                                            m_mtx;
+    thallium::condition_variable                               m_cv;
+};
+
+}
+
+#endif
@@ -4,6 +4,7 @@
  * See COPYRIGHT in top-level directory.
  */
 #include "mobject/Provider.hpp"
+#include "mobject/Exception.hpp"
 
 #include "ProviderImpl.hpp"
 
@@ -13,16 +14,29 @@ namespace tl = thallium;
 
 namespace mobject {
 
+using json = nlohmann::json;
+
+static json parseConfig(const std::string& config) {
+    if(config.empty()) return json::object();
+    json result;
+    try {
+        result = json::parse(config);
+    } catch(json::parse_error& e) {
+        throw Exception("Could not parse provider configuration: "s + e.what());
+    }
+    if(not result.is_object())
+        throw Exception("Provider configuration should be a JSON object");
+    return result;
+}
+
 Provider::Provider(const tl::engine& engine, uint16_t provider_id, const std::string& config, const tl::pool& p)
-: self(std::make_shared<ProviderImpl>(engine, provider_id, p)) {
+: self(std::make_shared<ProviderImpl>(engine, provider_id, parseConfig(config), p)) {
     self->get_engine().push_finalize_callback(this, [p=this]() { p->self.reset(); });
-    (void)config;
 }
 
 Provider::Provider(margo_instance_id mid, uint16_t provider_id, const std::string& config, const tl::pool& p)
-: self(std::make_shared<ProviderImpl>(mid, provider_id, p)) {
+: self(std::make_shared<ProviderImpl>(mid, provider_id, parseConfig(config), p)) {
     self->get_engine().push_finalize_callback(this, [p=this]() { p->self.reset(); });
-    (void)config;
 }
 
 Provider::Provider(Provider&& other) {
@@ -38,7 +52,13 @@ Provider::~Provider() {
 }
 
 std::string Provider::getConfig() const {
-    return "{}";
+    if(not self) return "{}";
+    return self->m_config.dump();
+}
+
+std::string Provider::getStatistics() const {
+    if(not self) return "{}";
+    return self->statistics().dump();
 }
 
 Provider::operator bool() const {
@@ -8,29 +8,105 @@
 
 #include "mobject/Backend.hpp"
 #include "mobject/UUID.hpp"
+#include "mobject/Exception.hpp"
+#include "ObjectCache.hpp"
+#include "MigratingBackend.hpp"
+#include "ReplicatedBackend.hpp"
+#include "WatchRegistry.hpp"
+#include "TimestampOracle.hpp"
+#include "DedupTable.hpp"
+#include "PostedTable.hpp"
+#include "AdmissionControl.hpp"
+#include "Lanes.hpp"
+#include "RequestContext.hpp"
+#include "Checksum.hpp"
 
 #include <thallium.hpp>
 #include <thallium/serialization/stl/string.hpp>
 #include <thallium/serialization/stl/vector.hpp>
+#include <thallium/serialization/stl/pair.hpp>
 
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <exception>
 #include <tuple>
+#include <unordered_set>
 
 #define FIND_SEQUENCER(__var__) \
         std::shared_ptr<Backend> __var__;\
         do {\
-            std::lock_guard<tl::mutex> lock(m_backends_mtx);\
+            std::unique_lock<tl::mutex> lock(m_backends_mtx);\
+            while(!m_frozen.empty() && m_frozen.count(sequencer_id))\
+                m_backends_cv.wait(lock);\
             auto it = m_backends.find(sequencer_id);\
             if(it == m_backends.end()) {\
                 result.success() = false;\
+                auto r = m_redirects.find(sequencer_id);\
+                if(r != m_redirects.end()) {\
+                    result.error() = "Sequencer with UUID "s + sequencer_id.to_string() + " has moved";\
+                    result.redirectAddress() = r->second.first;\
+                    result.redirectProviderId() = r->second.second;\
+                    req.respond(result);\
+                    return;\
+                }\
                 result.error() = "Sequencer with UUID "s + sequencer_id.to_string() + " not found";\
                 req.respond(result);\
                 spdlog::error("[provider:{}] Sequencer {} not found", id(), sequencer_id.to_string());\
                 return;\
             }\
-            __var__ = it->second;\
+            __var__ = useBackend(it->second);\
+        }while(0)
+
+#define ADMIT_REQUEST(__bytes__) \
+        auto __ticket__ = m_admission->admit(sequencer_id, ctx, __bytes__);\
+        if(not __ticket__) {\
+            result.success() = false;\
+            result.error() = __ticket__.error();\
+            result.retryAfter() = __ticket__.retryAfter();\
+            req.respond(result);\
+            spdlog::trace("[provider:{}] Rejected request on sequencer {}: {}", id(), sequencer_id.to_string(), result.error());\
+            return;\
+        }
+
+// moves the admission slot of the request into a shared_ptr, so that it
+// is held until an asynchronous backend operation completes
+#define TAKE_TICKET() std::make_shared<AdmissionControl::Ticket>(std::move(__ticket__))
+
+// rejects client modifications of the objects the provider uses internally
+#define CHECK_NOT_RESERVED(__object__) \
+        do {\
+            if(__object__ == TimestampOracle::object_name) {\
+                result.success() = false;\
+                result.error() = "Object "s + __object__ + " is reserved";\
+                req.respond(result);\
+                return;\
+            }\
+        }while(0)
+
+// checks the size of the data of a request, as sent by the client,
+// before a buffer of that size is allocated
+#define CHECK_SIZE(__size__, __bulk__) \
+        do {\
+            if(not validSize(__size__, __bulk__, result.error())) {\
+                result.success() = false;\
+                req.respond(result);\
+                spdlog::error("[provider:{}] {} on sequencer {}", id(), result.error(), sequencer_id.to_string());\
+                return;\
+            }\
+        }while(0)
+
+#define CHECK_DEADLINE() \
+        do {\
+            if(ctx.expired()) {\
+                result.success() = false;\
+                result.error() = "Request dropped because its deadline expired";\
+                req.respond(result);\
+                spdlog::trace("[provider:{}] Dropped expired request on sequencer {}", id(), sequencer_id.to_string());\
+                return;\
+            }\
         }while(0)
 
 namespace mobject {
@@ -48,6 +124,21 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
 
     std::string          m_token;
     tl::pool             m_pool;
+    json                 m_config;
+    // Pools in which the RPCs of each lane run
+    std::unique_ptr<Lanes> m_lanes;
+    // Object cache shared by all the backends (may be null)
+    std::unique_ptr<ObjectCache> m_cache;
+    // results of recent non-idempotent requests, replayed to retries
+    std::unique_ptr<DedupTable> m_dedup;
+    // order and errors of the posted operations of each client
+    PostedTable m_posted;
+    // bounds on the requests executing and waiting (see AdmissionControl)
+    std::unique_ptr<AdmissionControl> m_admission;
+    // maximum number of names returned by a listObjects RPC
+    size_t m_max_list_page;
+    // maximum size of the data of a request
+    size_t m_max_request_size;
     // Admin RPC
     tl::remote_procedure m_create_sequencer;
     tl::remote_procedure m_open_sequencer;
@@ -57,21 +148,109 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
     tl::remote_procedure m_check_sequencer;
     tl::remote_procedure m_say_hello;
     tl::remote_procedure m_compute_sum;
+    tl::remote_procedure m_compute_sum_array;
+    tl::remote_procedure m_write;
+    tl::remote_procedure m_append;
+    tl::remote_procedure m_posted_write;
+    tl::remote_procedure m_posted_append;
+    tl::remote_procedure m_posted_barrier;
+    tl::remote_procedure m_read;
+    tl::remote_procedure m_remove;
+    tl::remote_procedure m_flush;
+    tl::remote_procedure m_list_objects;
+    tl::remote_procedure m_omap_set;
+    tl::remote_procedure m_omap_get;
+    tl::remote_procedure m_omap_remove;
+    tl::remote_procedure m_omap_scan;
+    tl::remote_procedure m_execute;
+    tl::remote_procedure m_migrate_sequencer;
+    tl::remote_procedure m_migration_begin;
+    tl::remote_procedure m_migration_put;
+    tl::remote_procedure m_migration_end;
+    tl::remote_procedure m_replica_create;
+    tl::remote_procedure m_replicate;
+    tl::remote_procedure m_promote_sequencer;
+    tl::remote_procedure m_watch;
+    tl::remote_procedure m_timestamps;
+    tl::remote_procedure m_get_statistics;
     // Backends
     std::unordered_map<UUID, std::shared_ptr<Backend>> m_backends;
+    // Type and configuration of each sequencer, to recreate it when migrating
+    std::unordered_map<UUID, std::pair<std::string, std::string>> m_sequencer_info;
+    // Sequencers that migrated away, with the address and provider id they moved to
+    std::unordered_map<UUID, std::pair<std::string, uint16_t>> m_redirects;
+    // Sequencers in the final phase of a migration; requests to them wait
+    std::unordered_set<UUID> m_frozen;
+    // Replicas of sequencers whose primary is on another provider
+    std::unordered_map<UUID, std::shared_ptr<Backend>> m_replicas;
+    // timestamp oracles of the sequencers, created on first use
+    std::unordered_map<UUID, std::shared_ptr<TimestampOracle>> m_oracles;
     tl::mutex m_backends_mtx;
+    tl::condition_variable m_backends_cv;
+    // number of requests using each backend (see useBackend)
+    std::unordered_map<Backend*, size_t> m_backend_users;
+    tl::mutex m_users_mtx;
+    tl::condition_variable m_users_cv;
+    // continuations of asynchronous backend operations yet to run (see continuation)
+    size_t m_pending_completions = 0;
+    tl::mutex m_pending_mtx;
+    tl::condition_variable m_pending_cv;
+    // pending watch requests
+    std::unique_ptr<WatchRegistry> m_watches;
 
-    ProviderImpl(const tl::engine& engine, uint16_t provider_id, const tl::pool& pool)
+    ProviderImpl(const tl::engine& engine, uint16_t provider_id, const json& config, const tl::pool& pool)
     : tl::provider<ProviderImpl>(engine, provider_id)
     , m_pool(pool)
-    , m_create_sequencer(define("mobject_create_sequencer", &ProviderImpl::createSequencer, pool))
-    , m_open_sequencer(define("mobject_open_sequencer", &ProviderImpl::openSequencer, pool))
-    , m_close_sequencer(define("mobject_close_sequencer", &ProviderImpl::closeSequencer, pool))
-    , m_destroy_sequencer(define("mobject_destroy_sequencer", &ProviderImpl::destroySequencer, pool))
-    , m_check_sequencer(define("mobject_check_sequencer", &ProviderImpl::checkSequencer, pool))
-    , m_say_hello(define("mobject_say_hello", &ProviderImpl::sayHello, pool))
-    , m_compute_sum(define("mobject_compute_sum",  &ProviderImpl::computeSum, pool))
+    , m_config(config)
+    , m_lanes(Lanes::fromConfig(engine, config.contains("lanes") ? config["lanes"] : json(), pool))
+    , m_cache(config.contains("cache") ? ObjectCache::fromConfig(config["cache"]) : nullptr)
+    , m_dedup(DedupTable::fromConfig(config.contains("dedup") ? config["dedup"] : json()))
+    , m_posted(std::chrono::milliseconds(config.contains("posted") ? config["posted"].value("turn_timeout_ms", 30000) : 30000),
+               std::chrono::milliseconds(config.contains("posted") ? config["posted"].value("idle_timeout_ms", 600000) : 600000))
+    , m_admission(AdmissionControl::fromConfig(config.contains("admission") ? config["admission"] : json()))
+    , m_max_list_page(config.contains("limits") ? config["limits"].value("max_list_page", (size_t)1024) : (size_t)1024)
+    , m_max_request_size(config.contains("limits") ? config["limits"].value("max_request_size", (size_t)1 << 30) : (size_t)1 << 30)
+    , m_create_sequencer(define("mobject_create_sequencer", &ProviderImpl::createSequencer, m_lanes->pool(Lanes::ADMIN)))
+    , m_open_sequencer(define("mobject_open_sequencer", &ProviderImpl::openSequencer, m_lanes->pool(Lanes::ADMIN)))
+    , m_close_sequencer(define("mobject_close_sequencer", &ProviderImpl::closeSequencer, m_lanes->pool(Lanes::ADMIN)))
+    , m_destroy_sequencer(define("mobject_destroy_sequencer", &ProviderImpl::destroySequencer, m_lanes->pool(Lanes::ADMIN)))
+    , m_check_sequencer(define("mobject_check_sequencer", &ProviderImpl::checkSequencer, m_lanes->pool(Lanes::CONTROL)))
+    , m_say_hello(define("mobject_say_hello", &ProviderImpl::sayHello, m_lanes->pool(Lanes::CONTROL)))
+    , m_compute_sum(define("mobject_compute_sum",  &ProviderImpl::computeSum, m_lanes->pool(Lanes::DATA)))
+    , m_compute_sum_array(define("mobject_compute_sum_array", &ProviderImpl::computeSumArray, m_lanes->pool(Lanes::DATA)))
+    , m_write(define("mobject_write", &ProviderImpl::write, m_lanes->pool(Lanes::DATA)))
+    , m_append(define("mobject_append", &ProviderImpl::append, m_lanes->pool(Lanes::DATA)))
+    , m_posted_write(define("mobject_posted_write", &ProviderImpl::postedWrite, m_lanes->pool(Lanes::DATA)))
+    , m_posted_append(define("mobject_posted_append", &ProviderImpl::postedAppend, m_lanes->pool(Lanes::DATA)))
+    , m_posted_barrier(define("mobject_posted_barrier", &ProviderImpl::postedBarrier, m_lanes->pool(Lanes::CONTROL)))
+    , m_read(define("mobject_read", &ProviderImpl::read, m_lanes->pool(Lanes::DATA)))
+    , m_remove(define("mobject_remove", &ProviderImpl::remove, m_lanes->pool(Lanes::DATA)))
+    , m_flush(define("mobject_flush", &ProviderImpl::flush, m_lanes->pool(Lanes::DATA)))
+    , m_list_objects(define("mobject_list_objects", &ProviderImpl::listObjects, m_lanes->pool(Lanes::DATA)))
+    , m_omap_set(define("mobject_omap_set", &ProviderImpl::omapSet, m_lanes->pool(Lanes::DATA)))
+    , m_omap_get(define("mobject_omap_get", &ProviderImpl::omapGet, m_lanes->pool(Lanes::DATA)))
+    , m_omap_remove(define("mobject_omap_remove", &ProviderImpl::omapRemove, m_lanes->pool(Lanes::DATA)))
+    , m_omap_scan(define("mobject_omap_scan", &ProviderImpl::omapScan, m_lanes->pool(Lanes::DATA)))
+    , m_execute(define("mobject_execute", &ProviderImpl::execute, m_lanes->pool(Lanes::DATA)))
+    , m_migrate_sequencer(define("mobject_migrate_sequencer", &ProviderImpl::migrateSequencer, m_lanes->pool(Lanes::ADMIN)))
+    , m_migration_begin(define("mobject_migration_begin", &ProviderImpl::migrationBegin, m_lanes->pool(Lanes::CONTROL)))
+    , m_migration_put(define("mobject_migration_put", &ProviderImpl::migrationPut, m_lanes->pool(Lanes::CONTROL)))
+    , m_migration_end(define("mobject_migration_end", &ProviderImpl::migrationEnd, m_lanes->pool(Lanes::CONTROL)))
+    , m_replica_create(define("mobject_replica_create", &ProviderImpl::replicaCreate, m_lanes->pool(Lanes::ADMIN)))
+    , m_replicate(define("mobject_replicate", &ProviderImpl::replicate, m_lanes->pool(Lanes::CONTROL)))
+    , m_promote_sequencer(define("mobject_promote_sequencer", &ProviderImpl::promoteSequencer, m_lanes->pool(Lanes::ADMIN)))
+    , m_watch(define("mobject_watch", &ProviderImpl::watch, m_lanes->pool(Lanes::CONTROL)))
+    , m_timestamps(define("mobject_timestamps", &ProviderImpl::timestamps, m_lanes->pool(Lanes::DATA)))
+    , m_get_statistics(define("mobject_get_statistics", &ProviderImpl::getStatistics, m_lanes->pool(Lanes::CONTROL)))
     {
+        if(m_cache) m_config["cache"] = m_cache->getConfig();
+        auto coalesce_ms = m_config.contains("watch") ? m_config["watch"].value("coalesce_ms", 2) : 2;
+        auto max_objects = m_config.contains("watch") ? m_config["watch"].value("max_objects", (size_t)1024) : (size_t)1024;
+        m_watches.reset(new WatchRegistry(engine, m_lanes->pool(Lanes::CONTROL), std::chrono::milliseconds(coalesce_ms),
+            max_objects,
+            [this](const UUID& sequencer_id, const WatchRegistry::Versions& objects) {
+                return changedVersions(sequencer_id, objects);
+            }));
         spdlog::trace("[provider:{0}] Registered provider with id {0}", id());
     }
 
@@ -84,6 +263,39 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
         m_check_sequencer.deregister();
         m_say_hello.deregister();
         m_compute_sum.deregister();
+        m_compute_sum_array.deregister();
+        m_write.deregister();
+        m_append.deregister();
+        m_posted_write.deregister();
+        m_posted_append.deregister();
+        m_posted_barrier.deregister();
+        m_read.deregister();
+        m_remove.deregister();
+        m_flush.deregister();
+        m_list_objects.deregister();
+        m_omap_set.deregister();
+        m_omap_get.deregister();
+        m_omap_remove.deregister();
+        m_omap_scan.deregister();
+        m_execute.deregister();
+        m_migrate_sequencer.deregister();
+        m_migration_begin.deregister();
+        m_migration_put.deregister();
+        m_migration_end.deregister();
+        m_replica_create.deregister();
+        m_replicate.deregister();
+        m_promote_sequencer.deregister();
+        m_watch.deregister();
+        m_timestamps.deregister();
+        m_get_statistics.deregister();
+        {
+            // no new handler can start, but asynchronous backend
+            // operations may still have to complete
+            std::unique_lock<tl::mutex> lock(m_pending_mtx);
+            while(m_pending_completions != 0)
+                m_pending_cv.wait(lock);
+        }
+        m_watches.reset();
         spdlog::trace("[provider:{}]    => done!", id());
     }
 
@@ -139,9 +351,23 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
                     id(), sequencer_type, sequencer_id.to_string());
             req.respond(result);
             return;
-        } else {
+        }
+
+        std::string error;
+        auto sequencer = setupReplication(sequencer_id, token, sequencer_type, json_config,
+                                          std::move(backend), ReplicaSetup::CREATE, error);
+        if(not sequencer) {
+            result.success() = false;
+            result.error() = error;
+            spdlog::error("[provider:{}] Could not set up replication of sequencer {}: {}",
+                    id(), sequencer_id.to_string(), error);
+            req.respond(result);
+            return;
+        }
+        {
             std::lock_guard<tl::mutex> lock(m_backends_mtx);
-            m_backends[sequencer_id] = std::move(backend);
+            m_backends[sequencer_id] = std::move(sequencer);
+            m_sequencer_info[sequencer_id] = std::make_pair(sequencer_type, sequencer_config);
             result.value() = sequencer_id;
         }
         
@@ -202,9 +428,23 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
                     id(), sequencer_type, sequencer_id.to_string());
             req.respond(result);
             return;
-        } else {
+        }
+
+        std::string error;
+        auto sequencer = setupReplication(sequencer_id, token, sequencer_type, json_config,
+                                          std::move(backend), ReplicaSetup::OPEN, error);
+        if(not sequencer) {
+            result.success() = false;
+            result.error() = error;
+            spdlog::error("[provider:{}] Could not set up replication of sequencer {}: {}",
+                    id(), sequencer_id.to_string(), error);
+            req.respond(result);
+            return;
+        }
+        {
             std::lock_guard<tl::mutex> lock(m_backends_mtx);
-            m_backends[sequencer_id] = std::move(backend);
+            m_backends[sequencer_id] = std::move(sequencer);
+            m_sequencer_info[sequencer_id] = std::make_pair(sequencer_type, sequencer_config);
             result.value() = sequencer_id;
         }
         
@@ -241,7 +481,11 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
             }
 
             m_backends.erase(sequencer_id);
+            m_sequencer_info.erase(sequencer_id);
+            m_oracles.erase(sequencer_id);
         }
+        if(m_cache) m_cache->invalidate(sequencer_id);
+        m_watches->notify(sequencer_id);
         req.respond(result);
         spdlog::trace("[provider:{}] Sequencer {} successfully closed", id(), sequencer_id.to_string());
     }
@@ -260,21 +504,48 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
             return;
         }
 
+        // the sequencer is removed from the maps under the lock, but
+        // destroyed (which may take a while, e.g. to destroy its replicas)
+        // after releasing it
+        std::shared_ptr<Backend> backend;
+        bool is_replica = false;
         {
             std::lock_guard<tl::mutex> lock(m_backends_mtx);
 
-            if(m_backends.count(sequencer_id) == 0) {
+            auto it = m_backends.find(sequencer_id);
+            auto replica = m_replicas.find(sequencer_id);
+            if(it != m_backends.end()) {
+                backend = std::move(it->second);
+                m_backends.erase(it);
+                m_oracles.erase(sequencer_id);
+            } else if(replica != m_replicas.end()) {
+                backend = std::move(replica->second);
+                m_replicas.erase(replica);
+                is_replica = true;
+            } else {
                 result.success() = false;
                 result.error() = "Sequencer "s + sequencer_id.to_string() + " not found";
                 req.respond(result);
                 spdlog::error("[provider:{}] Sequencer {} not found", id(), sequencer_id.to_string());
                 return;
             }
+            m_sequencer_info.erase(sequencer_id);
+        }
 
-            result = m_backends[sequencer_id]->destroy();
-            m_backends.erase(sequencer_id);
+        if(is_replica) {
+            result = backend->destroy();
+            req.respond(result);
+            spdlog::trace("[provider:{}] Replica of sequencer {} successfully destroyed",
+                    id(), sequencer_id.to_string());
+            return;
         }
 
+        // let the requests still using the sequencer complete first
+        waitUntilUnused(backend);
+        result = backend->destroy();
+        if(m_cache) m_cache->invalidate(sequencer_id);
+        m_watches->notify(sequencer_id);
+
         req.respond(result);
         spdlog::trace("[provider:{}] Sequencer {} successfully destroyed", id(), sequencer_id.to_string());
     }
@@ -300,15 +571,1486 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
 
     void computeSum(const tl::request& req,
                     const UUID& sequencer_id,
+                    const RequestContext& ctx,
                     int32_t x, int32_t y) {
         spdlog::trace("[provider:{}] Received sayHello request for sequencer {}", id(), sequencer_id.to_string());
         RequestResult<int32_t> result;
         FIND_SEQUENCER(sequencer);
+        CHECK_DEADLINE();
+        ADMIT_REQUEST(0);
         result = sequencer->computeSum(x, y);
         req.respond(result);
         spdlog::trace("[provider:{}] Successfully executed computeSum on sequencer {}", id(), sequencer_id.to_string());
     }
 
+    void computeSumArray(const tl::request& req,
+                         const UUID& sequencer_id,
+                         const RequestContext& ctx,
+                         size_t count,
+                         const tl::bulk& bulk) {
+        spdlog::trace("[provider:{}] Received computeSumArray request for sequencer {}", id(), sequencer_id.to_string());
+        RequestResult<bool> result;
+        FIND_SEQUENCER(sequencer);
+        CHECK_DEADLINE();
+        // the client's bulk handle holds x, y and the result, one after the
+        // other; count is checked against its size before being multiplied
+        if(count > bulk.size() / (3*sizeof(int32_t))) {
+            result.success() = false;
+            result.error() = "Invalid count "s + std::to_string(count)
+                           + " for a bulk handle of " + std::to_string(bulk.size()) + " bytes";
+            req.respond(result);
+            spdlog::error("[provider:{}] {} in computeSumArray", id(), result.error());
+            return;
+        }
+        size_t size = count*sizeof(int32_t);
+        ADMIT_REQUEST(3*size);
+        if(count == 0) {
+            req.respond(result);
+            return;
+        }
+        std::vector<int32_t> buffer(3*count);
+        auto local = get_engine().expose({{buffer.data(), 3*size}}, tl::bulk_mode::read_write);
+        try {
+            bulk(0, 2*size).on(req.get_endpoint()) >> local(0, 2*size);
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            req.respond(result);
+            spdlog::error("[provider:{}] Bulk transfer failed in computeSumArray: {}", id(), result.error());
+            return;
+        }
+        result = sequencer->computeSumArray(buffer.data(), buffer.data() + count, buffer.data() + 2*count, count);
+        if(result.success()) {
+            try {
+                bulk(2*size, size).on(req.get_endpoint()) << local(2*size, size);
+            } catch(const std::exception& ex) {
+                result.success() = false;
+                result.error() = ex.what();
+                spdlog::error("[provider:{}] Bulk transfer failed in computeSumArray: {}", id(), result.error());
+            }
+        }
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed computeSumArray on sequencer {}", id(), sequencer_id.to_string());
+    }
+
+    // bulk transfers are done in chunks of this size, so that the
+    // checksum of each chunk is computed while it is still in cache
+    static constexpr size_t transfer_chunk_size = 1024*1024;
+
+    /**
+     * @brief Pulls size bytes from the client's bulk handle into data
+     * and returns their checksum. Throws if the transfer fails. The
+     * transfer of each chunk is started, in a ULT of the data lane,
+     * before the checksum of the previous one is computed, so that
+     * checksumming overlaps with the network.
+     */
+    uint32_t pull(const tl::request& req, const tl::bulk& bulk, char* data, size_t size) {
+        uint32_t crc = 0;
+        if(size == 0) return crc;
+        auto local = get_engine().expose({{data, size}}, tl::bulk_mode::write_only);
+        auto ep = req.get_endpoint();
+        // local copy: std::min takes its arguments by reference, and the
+        // static member has no out-of-class definition
+        const size_t max_chunk_size = transfer_chunk_size;
+        auto transfer = [&](size_t chunk) {
+            size_t chunk_size = std::min(max_chunk_size, size - chunk);
+            bulk(chunk, chunk_size).on(ep) >> local(chunk, chunk_size);
+        };
+        transfer(0);
+        for(size_t chunk = 0; chunk < size; chunk += max_chunk_size) {
+            size_t chunk_size = std::min(max_chunk_size, size - chunk);
+            size_t next = chunk + chunk_size;
+            if(next == size) {
+                crc = crc32c(data + chunk, chunk_size, crc);
+                break;
+            }
+            std::exception_ptr error;
+            auto pending = m_lanes->pool(Lanes::DATA).make_thread([&transfer, &error, next]() {
+                try {
+                    transfer(next);
+                } catch(...) {
+                    error = std::current_exception();
+                }
+            });
+            crc = crc32c(data + chunk, chunk_size, crc);
+            pending->join();
+            if(error) std::rethrow_exception(error);
+        }
+        return crc;
+    }
+
+    void write(const tl::request& req,
+               const UUID& sequencer_id,
+               const RequestContext& ctx,
+               const std::string& object,
+               uint64_t offset,
+               size_t size,
+               uint32_t checksum,
+               const tl::bulk& bulk) {
+        spdlog::trace("[provider:{}] Received write request for object {} in sequencer {}",
+                id(), object, sequencer_id.to_string());
+        RequestResult<bool> result;
+        FIND_SEQUENCER(sequencer);
+        CHECK_NOT_RESERVED(object);
+        CHECK_SIZE(size, bulk);
+        CHECK_DEADLINE();
+        ADMIT_REQUEST(size);
+        std::vector<char> buffer(size);
+        uint32_t crc = 0;
+        try {
+            crc = pull(req, bulk, buffer.data(), size);
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            req.respond(result);
+            spdlog::error("[provider:{}] Bulk transfer failed in write: {}", id(), result.error());
+            return;
+        }
+        if(crc != checksum) {
+            result.success() = false;
+            result.error() = "Checksum mismatch in data received for object "s + object;
+            req.respond(result);
+            spdlog::error("[provider:{}] Checksum mismatch in write to object {}", id(), object);
+            return;
+        }
+        // the transfer may have taken long enough for the client to give up
+        CHECK_DEADLINE();
+        auto data = std::make_shared<std::vector<char>>(std::move(buffer));
+        auto ticket = TAKE_TICKET();
+        sequencer->writeAsync(object, offset, data->data(), size, continuation<bool>(
+            [this, req, sequencer, sequencer_id, object, offset, size, data, ticket]
+            (RequestResult<bool> result) { // sequencer, data and ticket kept alive until completion
+                if(m_cache) m_cache->invalidate(sequencer_id, object, offset, size);
+                m_watches->notify(sequencer_id, object);
+                req.respond(result);
+                spdlog::trace("[provider:{}] Successfully executed write on sequencer {}", id(), sequencer_id.to_string());
+            }));
+    }
+
+    void append(const tl::request& req,
+                const UUID& sequencer_id,
+                const RequestContext& ctx,
+                const UUID& client_id,
+                uint64_t request_seq,
+                const std::string& object,
+                size_t size,
+                uint32_t checksum,
+                const tl::bulk& bulk) {
+        spdlog::trace("[provider:{}] Received append request for object {} in sequencer {}",
+                id(), object, sequencer_id.to_string());
+        // value is the offset at which the data was appended
+        RequestResult<uint64_t> result;
+        FIND_SEQUENCER(sequencer);
+        CHECK_NOT_RESERVED(object);
+        CHECK_SIZE(size, bulk);
+        CHECK_DEADLINE();
+        ADMIT_REQUEST(size);
+        if(not m_dedup->begin(client_id, sequencer_id, request_seq, ctx.retry, result)) {
+            // retry of an append that was already executed
+            req.respond(result);
+            return;
+        }
+        // the transfer happens before the offset is reserved, so concurrent
+        // appenders only serialize on the reservation itself
+        std::vector<char> buffer(size);
+        uint32_t crc = 0;
+        try {
+            crc = pull(req, bulk, buffer.data(), size);
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            m_dedup->abandon(client_id, request_seq);
+            req.respond(result);
+            spdlog::error("[provider:{}] Bulk transfer failed in append: {}", id(), result.error());
+            return;
+        }
+        if(crc != checksum) {
+            result.success() = false;
+            result.error() = "Checksum mismatch in data received for object "s + object;
+            m_dedup->abandon(client_id, request_seq);
+            req.respond(result);
+            spdlog::error("[provider:{}] Checksum mismatch in append to object {}", id(), object);
+            return;
+        }
+        if(ctx.expired()) {
+            // the client gave up during the transfer; forget the request
+            // so that its retry, if any, is executed
+            m_dedup->abandon(client_id, request_seq);
+        }
+        CHECK_DEADLINE();
+        result = sequencer->reserve(object, size);
+        if(result.success() && size != 0) {
+            uint64_t offset = result.value();
+            auto write_result = sequencer->write(object, offset, buffer.data(), size);
+            result.success() = write_result.success();
+            result.error() = write_result.error();
+            if(m_cache) m_cache->invalidate(sequencer_id, object, offset, size);
+        }
+        if(result.success()) m_watches->notify(sequencer_id, object);
+        m_dedup->complete(client_id, request_seq, result);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed append on sequencer {}", id(), sequencer_id.to_string());
+    }
+
+    /**
+     * @brief Posted operations get no response; their errors are
+     * recorded in m_posted and reported to the client by the next
+     * barrier. They are applied in the order the client posted them,
+     * and never dropped because of a deadline. The client keeps their
+     * data exposed until the barrier that follows them, so it can be
+     * pulled while they wait for their turn.
+     */
+    void postedWrite(const tl::request& req,
+                     const UUID& sequencer_id,
+                     const RequestContext& ctx,
+                     const UUID& client_id,
+                     uint64_t posted_seq,
+                     const std::string& object,
+                     uint64_t offset,
+                     size_t size,
+                     uint32_t checksum,
+                     const tl::bulk& bulk) {
+        spdlog::trace("[provider:{}] Received posted write {} for object {} in sequencer {}",
+                id(), posted_seq, object, sequencer_id.to_string());
+        if(not m_posted.waitTurn(client_id, sequencer_id, posted_seq)) {
+            spdlog::error("[provider:{}] Ignoring posted write {} that arrived too late", id(), posted_seq);
+            return;
+        }
+        RequestResult<bool> result;
+        try {
+            auto sequencer = findSequencer(sequencer_id, result.error());
+            if(not sequencer) {
+                result.success() = false;
+            } else if(object == TimestampOracle::object_name) {
+                result.success() = false;
+                result.error() = "Object "s + object + " is reserved";
+            } else if(not validSize(size, bulk, result.error())) {
+                result.success() = false;
+            } else if(auto ticket = m_admission->admit(sequencer_id, ctx, size)) {
+                std::vector<char> buffer(size);
+                if(pull(req, bulk, buffer.data(), size) != checksum) {
+                    result.success() = false;
+                    result.error() = "Checksum mismatch in data received for object "s + object;
+                } else {
+                    result = sequencer->write(object, offset, buffer.data(), size);
+                    if(m_cache) m_cache->invalidate(sequencer_id, object, offset, size);
+                    m_watches->notify(sequencer_id, object);
+                }
+            } else {
+                result.success() = false;
+                result.error() = ticket.error();
+            }
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+        }
+        m_posted.complete(client_id, sequencer_id, posted_seq, result.error(), result.success());
+        if(not result.success())
+            spdlog::error("[provider:{}] Posted write to object {} failed: {}", id(), object, result.error());
+    }
+
+    void postedAppend(const tl::request& req,
+                      const UUID& sequencer_id,
+                      const RequestContext& ctx,
+                      const UUID& client_id,
+                      uint64_t posted_seq,
+                      const std::string& object,
+                      size_t size,
+                      uint32_t checksum,
+                      const tl::bulk& bulk) {
+        spdlog::trace("[provider:{}] Received posted append {} for object {} in sequencer {}",
+                id(), posted_seq, object, sequencer_id.to_string());
+        if(not m_posted.waitTurn(client_id, sequencer_id, posted_seq)) {
+            spdlog::error("[provider:{}] Ignoring posted append {} that arrived too late", id(), posted_seq);
+            return;
+        }
+        RequestResult<uint64_t> result;
+        try {
+            auto sequencer = findSequencer(sequencer_id, result.error());
+            if(not sequencer) {
+                result.success() = false;
+            } else if(object == TimestampOracle::object_name) {
+                result.success() = false;
+                result.error() = "Object "s + object + " is reserved";
+            } else if(not validSize(size, bulk, result.error())) {
+                result.success() = false;
+            } else if(auto ticket = m_admission->admit(sequencer_id, ctx, size)) {
+                std::vector<char> buffer(size);
+                if(pull(req, bulk, buffer.data(), size) != checksum) {
+                    result.success() = false;
+                    result.error() = "Checksum mismatch in data received for object "s + object;
+                } else {
+                    result = sequencer->reserve(object, size);
+                    if(result.success() && size != 0) {
+                        uint64_t offset = result.value();
+                        auto write_result = sequencer->write(object, offset, buffer.data(), size);
+                        result.success() = write_result.success();
+                        result.error() = write_result.error();
+                        if(m_cache) m_cache->invalidate(sequencer_id, object, offset, size);
+                    }
+                    if(result.success()) m_watches->notify(sequencer_id, object);
+                }
+            } else {
+                result.success() = false;
+                result.error() = ticket.error();
+            }
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+        }
+        m_posted.complete(client_id, sequencer_id, posted_seq, result.error(), result.success());
+        if(not result.success())
+            spdlog::error("[provider:{}] Posted append to object {} failed: {}", id(), object, result.error());
+    }
+
+    void postedBarrier(const tl::request& req,
+                       const UUID& sequencer_id,
+                       const RequestContext& ctx,
+                       const UUID& client_id,
+                       uint64_t posted_seq) {
+        spdlog::trace("[provider:{}] Received posted barrier {} for sequencer {}",
+                id(), posted_seq, sequencer_id.to_string());
+        // value is the number of posted operations that failed; the
+        // sequencer may have moved since they were posted, so it is not
+        // looked up: their failure is recorded like any other
+        RequestResult<uint64_t> result = m_posted.barrier(client_id, sequencer_id, posted_seq, ctx.deadline());
+        req.respond(result);
+        spdlog::trace("[provider:{}] Completed posted barrier {} for sequencer {}",
+                id(), posted_seq, sequencer_id.to_string());
+    }
+
+    void read(const tl::request& req,
+              const UUID& sequencer_id,
+              const RequestContext& ctx,
+              const std::string& object,
+              uint64_t offset,
+              size_t size,
+              const tl::bulk& bulk) {
+        spdlog::trace("[provider:{}] Received read request for object {} in sequencer {}",
+                id(), object, sequencer_id.to_string());
+        // value is the number of bytes read and their checksum
+        RequestResult<std::pair<size_t, uint32_t>> result;
+        // backups serve reads from their replica of the sequencer (clients
+        // hedge slow reads to them), bypassing the cache, which replicated
+        // operations do not invalidate
+        std::shared_ptr<Backend> sequencer = findReplica(sequencer_id);
+        const bool is_replica = static_cast<bool>(sequencer);
+        if(not is_replica) {
+            FIND_SEQUENCER(primary);
+            sequencer = std::move(primary);
+        }
+        CHECK_SIZE(size, bulk);
+        CHECK_DEADLINE();
+        ADMIT_REQUEST(size);
+        auto buffer = std::make_shared<std::vector<char>>(size);
+        auto ticket = TAKE_TICKET();
+        auto finish = [this, req, sequencer, sequencer_id, bulk, buffer, ticket]
+            (RequestResult<size_t> read_result) { // sequencer, buffer and ticket kept alive until completion
+                RequestResult<std::pair<size_t, uint32_t>> result;
+                result.success() = read_result.success();
+                result.error() = read_result.error();
+                if(result.success()) {
+                    size_t n = read_result.value();
+                    result.value() = std::make_pair(n, crc32c(buffer->data(), n));
+                    if(n != 0) {
+                        try {
+                            auto local = get_engine().expose({{buffer->data(), n}}, tl::bulk_mode::read_only);
+                            bulk(0, n).on(req.get_endpoint()) << local;
+                        } catch(const std::exception& ex) {
+                            result.success() = false;
+                            result.error() = ex.what();
+                            spdlog::error("[provider:{}] Bulk transfer failed in read: {}", id(), result.error());
+                        }
+                    }
+                }
+                req.respond(result);
+                spdlog::trace("[provider:{}] Successfully executed read on sequencer {}", id(), sequencer_id.to_string());
+            };
+        if(m_cache && not is_replica)
+            finish(m_cache->read(sequencer_id, *sequencer, object, offset, buffer->data(), size));
+        else
+            sequencer->readAsync(object, offset, buffer->data(), size, continuation<size_t>(std::move(finish)));
+    }
+
+    void remove(const tl::request& req,
+                const UUID& sequencer_id,
+                const RequestContext& ctx,
+                const std::string& object) {
+        spdlog::trace("[provider:{}] Received remove request for object {} in sequencer {}",
+                id(), object, sequencer_id.to_string());
+        RequestResult<bool> result;
+        FIND_SEQUENCER(sequencer);
+        CHECK_NOT_RESERVED(object);
+        CHECK_DEADLINE();
+        ADMIT_REQUEST(0);
+        result = sequencer->remove(object);
+        if(m_cache) m_cache->invalidate(sequencer_id, object);
+        m_watches->notify(sequencer_id, object);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed remove on sequencer {}", id(), sequencer_id.to_string());
+    }
+
+    void flush(const tl::request& req,
+               const UUID& sequencer_id,
+               const RequestContext& ctx) {
+        spdlog::trace("[provider:{}] Received flush request for sequencer {}", id(), sequencer_id.to_string());
+        RequestResult<bool> result;
+        FIND_SEQUENCER(sequencer);
+        CHECK_DEADLINE();
+        ADMIT_REQUEST(0);
+        auto ticket = TAKE_TICKET();
+        sequencer->flushAsync(continuation<bool>(
+            [this, req, sequencer, sequencer_id, ticket]
+            (RequestResult<bool> result) { // sequencer and ticket kept alive until completion
+                req.respond(result);
+                spdlog::trace("[provider:{}] Successfully executed flush on sequencer {}", id(), sequencer_id.to_string());
+            }));
+    }
+
+    void listObjects(const tl::request& req,
+                     const UUID& sequencer_id,
+                     const RequestContext& ctx,
+                     const std::string& prefix,
+                     const std::string& start_after,
+                     size_t max,
+                     const tl::bulk& bulk) {
+        spdlog::trace("[provider:{}] Received listObjects request for sequencer {}", id(), sequencer_id.to_string());
+        // value is the number of names sent, and whether more names
+        // were available that did not fit in the page or in the client's buffer
+        RequestResult<std::pair<size_t, bool>> result;
+        FIND_SEQUENCER(sequencer);
+        CHECK_DEADLINE();
+        ADMIT_REQUEST(0);
+        size_t page = std::max<size_t>(std::min(max, m_max_list_page), 1);
+        // the objects used internally are not listed; one more name is
+        // asked for so that a page is not cut short by their removal
+        auto list_result = sequencer->listObjects(prefix, start_after, page + 1);
+        bool more = false;
+        if(list_result.success()) {
+            auto& names = list_result.value();
+            more = names.size() > page;
+            names.erase(std::remove(names.begin(), names.end(), TimestampOracle::object_name), names.end());
+            if(names.size() > page) names.resize(page);
+        }
+        result.success() = list_result.success();
+        result.error() = list_result.error();
+        if(result.success()) {
+            // names are packed in a single buffer, each followed by a '\0'
+            auto& names = list_result.value();
+            size_t capacity = bulk.is_null() ? 0 : bulk.size();
+            std::vector<char> buffer;
+            size_t count = 0;
+            for(; count < names.size(); count++) {
+                if(buffer.size() + names[count].size() + 1 > capacity) break;
+                buffer.insert(buffer.end(), names[count].begin(), names[count].end());
+                buffer.push_back('\0');
+            }
+            result.value() = std::make_pair(count, more || count < names.size());
+            if(count == 0 && !names.empty()) {
+                result.success() = false;
+                result.error() = "Buffer too small for object name "s + names[0];
+            } else if(!buffer.empty()) {
+                try {
+                    auto local = get_engine().expose({{buffer.data(), buffer.size()}}, tl::bulk_mode::read_only);
+                    bulk(0, buffer.size()).on(req.get_endpoint()) << local;
+                } catch(const std::exception& ex) {
+                    result.success() = false;
+                    result.error() = ex.what();
+                    spdlog::error("[provider:{}] Bulk transfer failed in listObjects: {}", id(), result.error());
+                }
+            }
+        }
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed listObjects on sequencer {}", id(), sequencer_id.to_string());
+    }
+
+    void omapSet(const tl::request& req,
+                 const UUID& sequencer_id,
+                 const RequestContext& ctx,
+                 const std::string& object,
+                 const std::vector<std::pair<std::string, std::string>>& entries) {
+        spdlog::trace("[provider:{}] Received omapSet request for object {} in sequencer {}",
+                id(), object, sequencer_id.to_string());
+        RequestResult<bool> result;
+        FIND_SEQUENCER(sequencer);
+        CHECK_NOT_RESERVED(object);
+        CHECK_DEADLINE();
+        size_t bytes = 0;
+        for(auto& entry : entries) bytes += entry.first.size() + entry.second.size();
+        ADMIT_REQUEST(bytes);
+        result = sequencer->omapSet(object, entries);
+        m_watches->notify(sequencer_id, object);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed omapSet on sequencer {}", id(), sequencer_id.to_string());
+    }
+
+    void omapGet(const tl::request& req,
+                 const UUID& sequencer_id,
+                 const RequestContext& ctx,
+                 const std::string& object,
+                 const std::vector<std::string>& keys) {
+        spdlog::trace("[provider:{}] Received omapGet request for object {} in sequencer {}",
+                id(), object, sequencer_id.to_string());
+        RequestResult<std::vector<std::pair<std::string, std::string>>> result;
+        FIND_SEQUENCER(sequencer);
+        CHECK_DEADLINE();
+        ADMIT_REQUEST(0);
+        result = sequencer->omapGet(object, keys);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed omapGet on sequencer {}", id(), sequencer_id.to_string());
+    }
+
+    void omapRemove(const tl::request& req,
+                    const UUID& sequencer_id,
+                    const RequestContext& ctx,
+                    const std::string& object,
+                    const std::vector<std::string>& keys) {
+        spdlog::trace("[provider:{}] Received omapRemove request for object {} in sequencer {}",
+                id(), object, sequencer_id.to_string());
+        RequestResult<bool> result;
+        FIND_SEQUENCER(sequencer);
+        CHECK_NOT_RESERVED(object);
+        CHECK_DEADLINE();
+        ADMIT_REQUEST(0);
+        result = sequencer->omapRemove(object, keys);
+        m_watches->notify(sequencer_id, object);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed omapRemove on sequencer {}", id(), sequencer_id.to_string());
+    }
+
+    void omapScan(const tl::request& req,
+                  const UUID& sequencer_id,
+                  const RequestContext& ctx,
+                  const std::string& object,
+                  const std::string& prefix,
+                  const std::string& start_after,
+                  size_t max) {
+        spdlog::trace("[provider:{}] Received omapScan request for object {} in sequencer {}",
+                id(), object, sequencer_id.to_string());
+        RequestResult<std::vector<std::pair<std::string, std::string>>> result;
+        FIND_SEQUENCER(sequencer);
+        CHECK_DEADLINE();
+        ADMIT_REQUEST(0);
+        result = sequencer->omapScan(object, prefix, start_after, max);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed omapScan on sequencer {}", id(), sequencer_id.to_string());
+    }
+
+    void execute(const tl::request& req,
+                 const UUID& sequencer_id,
+                 const RequestContext& ctx,
+                 const UUID& client_id,
+                 uint64_t request_seq,
+                 const std::string& object,
+                 const WriteOp& op,
+                 uint32_t checksum) {
+        spdlog::trace("[provider:{}] Received execute request for object {} in sequencer {}",
+                id(), object, sequencer_id.to_string());
+        RequestResult<uint64_t> result;
+        FIND_SEQUENCER(sequencer);
+        CHECK_NOT_RESERVED(object);
+        CHECK_DEADLINE();
+        size_t bytes = 0;
+        for(auto& step : op.steps()) bytes += step.data.size();
+        ADMIT_REQUEST(bytes);
+        if(not m_dedup->begin(client_id, sequencer_id, request_seq, ctx.retry, result)) {
+            // retry of an operation that was already executed
+            req.respond(result);
+            return;
+        }
+        // checksum covers the data of all the write steps, in order
+        uint32_t crc = 0;
+        for(auto& step : op.steps())
+            if(step.type == WriteOp::WRITE)
+                crc = crc32c(step.data.data(), step.data.size(), crc);
+        if(crc != checksum) {
+            result.success() = false;
+            result.error() = "Checksum mismatch in data received for object "s + object;
+            m_dedup->abandon(client_id, request_seq);
+            req.respond(result);
+            spdlog::error("[provider:{}] Checksum mismatch in execute on object {}", id(), object);
+            return;
+        }
+        // the handler's arguments do not outlive it
+        auto op_copy = std::make_shared<WriteOp>(op);
+        auto ticket = TAKE_TICKET();
+        sequencer->executeAsync(object, *op_copy, continuation<uint64_t>(
+            [this, req, sequencer, sequencer_id, client_id, request_seq, object, op_copy, ticket]
+            (RequestResult<uint64_t> result) { // sequencer, op_copy and ticket kept alive until completion
+                if(!op_copy->steps().empty()) {
+                    if(m_cache) m_cache->invalidate(sequencer_id, object);
+                    m_watches->notify(sequencer_id, object);
+                }
+                m_dedup->complete(client_id, request_seq, result);
+                req.respond(result);
+                spdlog::trace("[provider:{}] Successfully executed execute on sequencer {}", id(), sequencer_id.to_string());
+            }));
+    }
+
+
+    // number of rounds re-copying the objects modified during a migration
+    // before the final cut-over, and number of modified objects below which
+    // the cut-over happens right away
+    static constexpr int    migration_max_rounds = 8;
+    static constexpr size_t migration_cutover_threshold = 64;
+
+    void migrateSequencer(const tl::request& req,
+                          const std::string& token,
+                          const UUID& sequencer_id,
+                          const std::string& dest_address,
+                          uint16_t dest_provider_id) {
+        spdlog::trace("[provider:{}] Received migrateSequencer request for sequencer {}",
+                id(), sequencer_id.to_string());
+        spdlog::trace("[provider:{}]    => destination = {}, provider {}",
+                id(), dest_address, dest_provider_id);
+        RequestResult<bool> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        auto fail = [&](const std::string& error) {
+            result.success() = false;
+            result.error() = error;
+            req.respond(result);
+            spdlog::error("[provider:{}] Migration of sequencer {} failed: {}",
+                    id(), sequencer_id.to_string(), error);
+        };
+
+        std::shared_ptr<Backend> backend;
+        std::pair<std::string, std::string> info;
+        {
+            std::lock_guard<tl::mutex> lock(m_backends_mtx);
+            auto it = m_backends.find(sequencer_id);
+            if(it == m_backends.end())
+                return fail("Sequencer "s + sequencer_id.to_string() + " not found");
+            if(dynamic_cast<MigratingBackend*>(it->second.get()))
+                return fail("Sequencer "s + sequencer_id.to_string() + " is already being migrated");
+            backend = it->second;
+            info = m_sequencer_info[sequencer_id];
+        }
+
+        tl::provider_handle dest;
+        try {
+            dest = tl::provider_handle(get_engine().lookup(dest_address), dest_provider_id);
+            RequestResult<bool> begin = m_migration_begin.on(dest)(
+                token, sequencer_id, info.first, info.second);
+            if(not begin.success())
+                return fail(begin.error());
+        } catch(const std::exception& ex) {
+            return fail(ex.what());
+        }
+
+        // from now on, track the objects modified while they are being copied
+        auto migrating = std::make_shared<MigratingBackend>(backend);
+        {
+            std::lock_guard<tl::mutex> lock(m_backends_mtx);
+            m_backends[sequencer_id] = migrating;
+        }
+        // wait for the requests that started before the wrapper was installed
+        waitUntilUnused(backend);
+
+        auto abort = [&](const std::string& error) {
+            {
+                std::lock_guard<tl::mutex> lock(m_backends_mtx);
+                m_frozen.erase(sequencer_id);
+                auto it = m_backends.find(sequencer_id);
+                if(it != m_backends.end() && it->second == migrating)
+                    it->second = backend;
+            }
+            m_backends_cv.notify_all();
+            try {
+                RequestResult<bool> destroyed = m_destroy_sequencer.on(dest)(token, sequencer_id);
+                (void)destroyed;
+            } catch(...) {}
+            fail(error);
+        };
+
+        // copy all the objects while the sequencer keeps serving requests,
+        // then copy again the objects modified in the meantime
+        std::string error;
+        if(not copyAllObjects(dest, token, sequencer_id, *backend, error))
+            return abort(error);
+        for(int round = 0; round < migration_max_rounds; round++) {
+            auto dirty = migrating->takeDirty();
+            if(not copyObjects(dest, token, sequencer_id, *backend, dirty, error))
+                return abort(error);
+            if(dirty.size() < migration_cutover_threshold) break;
+        }
+
+        // cut-over: new requests wait, in-flight ones complete, then
+        // the last modified objects are copied and requests are redirected
+        {
+            std::lock_guard<tl::mutex> lock(m_backends_mtx);
+            auto it = m_backends.find(sequencer_id);
+            if(it == m_backends.end() || it->second != migrating) {
+                // the sequencer was closed or destroyed during the migration
+                error = "Sequencer "s + sequencer_id.to_string() + " was closed during migration";
+            } else {
+                m_frozen.insert(sequencer_id);
+                m_backends.erase(it);
+            }
+        }
+        if(not error.empty())
+            return abort(error);
+        waitUntilUnused(migrating);
+        // once the last objects are copied, the destination takes over the
+        // replicas of the sequencer, which are now up to date with it, and
+        // the results of its requests, so that a retry redirected there is
+        // not executed a second time
+        bool ended = copyObjects(dest, token, sequencer_id, *backend, migrating->takeDirty(), error);
+        if(ended) {
+            try {
+                RequestResult<bool> end = m_migration_end.on(dest)(
+                    token, sequencer_id, m_dedup->completed(sequencer_id));
+                if(not end.success()) {
+                    error = end.error();
+                    ended = false;
+                }
+            } catch(const std::exception& ex) {
+                error = ex.what();
+                ended = false;
+            }
+        }
+        if(not ended) {
+            {
+                std::lock_guard<tl::mutex> lock(m_backends_mtx);
+                m_backends[sequencer_id] = migrating;
+            }
+            return abort(error);
+        }
+        {
+            std::lock_guard<tl::mutex> lock(m_backends_mtx);
+            m_frozen.erase(sequencer_id);
+            m_redirects[sequencer_id] = std::make_pair(dest_address, dest_provider_id);
+            m_sequencer_info.erase(sequencer_id);
+            m_oracles.erase(sequencer_id);
+        }
+        m_backends_cv.notify_all();
+        if(m_cache) m_cache->invalidate(sequencer_id);
+        // watchers are answered with the redirect to the destination
+        m_watches->notify(sequencer_id);
+
+        req.respond(result);
+        spdlog::trace("[provider:{}] Sequencer {} successfully migrated to {}",
+                id(), sequencer_id.to_string(), dest_address);
+    }
+
+    void migrationBegin(const tl::request& req,
+                        const std::string& token,
+                        const UUID& sequencer_id,
+                        const std::string& sequencer_type,
+                        const std::string& sequencer_config) {
+        spdlog::trace("[provider:{}] Received migrationBegin request for sequencer {}",
+                id(), sequencer_id.to_string());
+        RequestResult<bool> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        // the objects copied here are already on the replicas of the
+        // sequencer, if it has any, so the sequencer is only wrapped into
+        // a ReplicatedBackend by migrationEnd, which takes them over
+        std::unique_ptr<Backend> backend;
+        try {
+            auto json_config = json::parse(sequencer_config);
+            backend = SequencerFactory::createSequencer(sequencer_type, get_engine(), json_config);
+            if(not backend) throw Exception("Unknown sequencer type "s + sequencer_type);
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            req.respond(result);
+            spdlog::error("[provider:{}] Could not create sequencer {} for migration: {}",
+                    id(), sequencer_id.to_string(), result.error());
+            return;
+        }
+
+        {
+            std::lock_guard<tl::mutex> lock(m_backends_mtx);
+            if(m_backends.count(sequencer_id) || m_replicas.count(sequencer_id)) {
+                result.success() = false;
+                result.error() = "Sequencer "s + sequencer_id.to_string() + " already exists";
+            } else {
+                m_backends[sequencer_id] = std::move(backend);
+                m_sequencer_info[sequencer_id] = std::make_pair(sequencer_type, sequencer_config);
+                // the sequencer may be coming back after having migrated away
+                m_redirects.erase(sequencer_id);
+            }
+        }
+        if(m_cache) m_cache->invalidate(sequencer_id);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Created sequencer {} for incoming migration",
+                id(), sequencer_id.to_string());
+    }
+
+    void migrationPut(const tl::request& req,
+                      const std::string& token,
+                      const UUID& sequencer_id,
+                      const std::string& object,
+                      bool exists,
+                      uint64_t version,
+                      const std::vector<std::pair<std::string, std::string>>& omap,
+                      size_t size,
+                      uint32_t checksum,
+                      const tl::bulk& bulk) {
+        spdlog::trace("[provider:{}] Received migrationPut request for object {} in sequencer {}",
+                id(), object, sequencer_id.to_string());
+        RequestResult<bool> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        FIND_SEQUENCER(sequencer);
+        std::vector<char> buffer(size);
+        try {
+            if(pull(req, bulk, buffer.data(), size) != checksum)
+                throw Exception("Checksum mismatch in data received for object "s + object);
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            req.respond(result);
+            spdlog::error("[provider:{}] Could not receive object {}: {}", id(), object, result.error());
+            return;
+        }
+        // replace the object with the state received from the source
+        sequencer->remove(object);
+        if(exists) {
+            result = sequencer->write(object, 0, buffer.data(), size);
+            if(result.success()) {
+                WriteOp op;
+                op.create().setVersion(version);
+                if(not omap.empty()) op.omapSet(omap);
+                auto r = sequencer->execute(object, op);
+                result.success() = r.success();
+                result.error() = r.error();
+            }
+        }
+        if(m_cache) m_cache->invalidate(sequencer_id, object);
+        m_watches->notify(sequencer_id, object);
+        req.respond(result);
+    }
+
+    void migrationEnd(const tl::request& req,
+                      const std::string& token,
+                      const UUID& sequencer_id,
+                      const std::vector<DedupTable::Record>& dedup_records) {
+        spdlog::trace("[provider:{}] Received migrationEnd request for sequencer {}",
+                id(), sequencer_id.to_string());
+        RequestResult<bool> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        std::shared_ptr<Backend> backend;
+        std::pair<std::string, std::string> info;
+        {
+            std::lock_guard<tl::mutex> lock(m_backends_mtx);
+            auto it = m_backends.find(sequencer_id);
+            if(it == m_backends.end()) {
+                result.success() = false;
+                result.error() = "Sequencer "s + sequencer_id.to_string() + " not found";
+                req.respond(result);
+                spdlog::error("[provider:{}] Sequencer {} not found", id(), sequencer_id.to_string());
+                return;
+            }
+            backend = it->second;
+            info = m_sequencer_info[sequencer_id];
+        }
+
+        // the sequencer was created by migrationBegin from this configuration
+        std::string error;
+        auto sequencer = setupReplication(sequencer_id, token, info.first, json::parse(info.second),
+                                          backend, ReplicaSetup::ADOPT, error);
+        if(not sequencer) {
+            result.success() = false;
+            result.error() = error;
+            req.respond(result);
+            spdlog::error("[provider:{}] Could not take over the replicas of sequencer {}: {}",
+                    id(), sequencer_id.to_string(), error);
+            return;
+        }
+        m_dedup->restore(sequencer_id, dedup_records);
+        {
+            std::lock_guard<tl::mutex> lock(m_backends_mtx);
+            m_backends[sequencer_id] = std::move(sequencer);
+        }
+        req.respond(result);
+        spdlog::trace("[provider:{}] Completed incoming migration of sequencer {}",
+                id(), sequencer_id.to_string());
+    }
+
+    void replicaCreate(const tl::request& req,
+                       const std::string& token,
+                       const UUID& sequencer_id,
+                       const std::string& sequencer_type,
+                       const std::string& sequencer_config,
+                       bool open) {
+        spdlog::trace("[provider:{}] Received replicaCreate request for sequencer {}",
+                id(), sequencer_id.to_string());
+        RequestResult<bool> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        std::unique_ptr<Backend> backend;
+        try {
+            auto json_config = json::parse(sequencer_config);
+            if(open)
+                backend = SequencerFactory::openSequencer(sequencer_type, get_engine(), json_config);
+            else
+                backend = SequencerFactory::createSequencer(sequencer_type, get_engine(), json_config);
+            if(not backend) throw Exception("Unknown sequencer type "s + sequencer_type);
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            req.respond(result);
+            spdlog::error("[provider:{}] Could not create replica of sequencer {}: {}",
+                    id(), sequencer_id.to_string(), result.error());
+            return;
+        }
+
+        {
+            std::lock_guard<tl::mutex> lock(m_backends_mtx);
+            if(m_backends.count(sequencer_id) || m_replicas.count(sequencer_id)) {
+                result.success() = false;
+                result.error() = "Sequencer "s + sequencer_id.to_string() + " already exists";
+            } else {
+                m_replicas[sequencer_id] = std::move(backend);
+                m_sequencer_info[sequencer_id] = std::make_pair(sequencer_type, sequencer_config);
+            }
+        }
+        req.respond(result);
+        spdlog::trace("[provider:{}] Created replica of sequencer {}", id(), sequencer_id.to_string());
+    }
+
+    void replicate(const tl::request& req,
+                   const std::string& token,
+                   const UUID& sequencer_id,
+                   const std::vector<ReplicatedOp>& ops) {
+        spdlog::trace("[provider:{}] Received replicate request for sequencer {} ({} operations)",
+                id(), sequencer_id.to_string(), ops.size());
+        RequestResult<bool> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        std::shared_ptr<Backend> replica;
+        {
+            std::lock_guard<tl::mutex> lock(m_backends_mtx);
+            auto it = m_replicas.find(sequencer_id);
+            if(it != m_replicas.end()) replica = it->second;
+        }
+        if(not replica) {
+            result.success() = false;
+            result.error() = "Replica of sequencer "s + sequencer_id.to_string() + " not found";
+            req.respond(result);
+            spdlog::error("[provider:{}] Replica of sequencer {} not found", id(), sequencer_id.to_string());
+            return;
+        }
+        result = ReplicatedBackend::apply(*replica, ops);
+        req.respond(result);
+    }
+
+    void promoteSequencer(const tl::request& req,
+                          const std::string& token,
+                          const UUID& sequencer_id) {
+        spdlog::trace("[provider:{}] Received promoteSequencer request for sequencer {}",
+                id(), sequencer_id.to_string());
+        RequestResult<bool> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        {
+            std::lock_guard<tl::mutex> lock(m_backends_mtx);
+            auto it = m_replicas.find(sequencer_id);
+            if(it == m_replicas.end()) {
+                result.success() = false;
+                result.error() = "Replica of sequencer "s + sequencer_id.to_string() + " not found";
+                req.respond(result);
+                spdlog::error("[provider:{}] Replica of sequencer {} not found", id(), sequencer_id.to_string());
+                return;
+            }
+            m_backends[sequencer_id] = std::move(it->second);
+            m_replicas.erase(it);
+            m_redirects.erase(sequencer_id);
+        }
+        if(m_cache) m_cache->invalidate(sequencer_id);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Replica of sequencer {} promoted to primary", id(), sequencer_id.to_string());
+    }
+
+    /**
+     * @brief Returns the statistics of the provider (see Provider::getStatistics).
+     */
+    json statistics() {
+        json stats = json::object();
+        if(m_cache) stats["cache"] = m_cache->getStatistics();
+        stats["admission"] = m_admission->getStatistics();
+        std::lock_guard<tl::mutex> lock(m_backends_mtx);
+        for(auto& p : m_backends) {
+            auto replicated = dynamic_cast<ReplicatedBackend*>(p.second.get());
+            if(not replicated) continue;
+            stats["replication"][p.first.to_string()] = {
+                { "backups", replicated->numBackups() },
+                { "dropped_backups", replicated->numDroppedBackups() }
+            };
+        }
+        return stats;
+    }
+
+    void getStatistics(const tl::request& req,
+                       const std::string& token) {
+        spdlog::trace("[provider:{}] Received getStatistics request", id());
+        RequestResult<std::string> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        result.value() = statistics().dump();
+        req.respond(result);
+    }
+
+    void watch(const tl::request& req,
+               const UUID& sequencer_id,
+               const RequestContext& ctx,
+               const WatchRegistry::Versions& objects,
+               uint32_t timeout_ms) {
+        spdlog::trace("[provider:{}] Received watch request for {} objects in sequencer {}",
+                id(), objects.size(), sequencer_id.to_string());
+        RequestResult<WatchRegistry::Versions> result;
+        CHECK_DEADLINE();
+        // the request is answered by the WatchRegistry, possibly much later,
+        // but no later than the deadline of the client
+        auto timeout = std::chrono::milliseconds(timeout_ms);
+        if(ctx.timeout_ms != 0) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    ctx.deadline() - RequestContext::clock::now());
+            timeout = std::max(std::chrono::milliseconds(0), std::min(timeout, remaining));
+        }
+        auto copy = objects;
+        m_watches->watch(req, sequencer_id, std::move(copy), timeout);
+    }
+
+    void timestamps(const tl::request& req,
+                    const UUID& sequencer_id,
+                    const RequestContext& ctx,
+                    const UUID& client_id,
+                    uint64_t request_seq,
+                    size_t count) {
+        spdlog::trace("[provider:{}] Received timestamps request for sequencer {}",
+                id(), sequencer_id.to_string());
+        // value is the first of count consecutive timestamps
+        RequestResult<uint64_t> result;
+        FIND_SEQUENCER(sequencer);
+        CHECK_DEADLINE();
+        ADMIT_REQUEST(0);
+        std::shared_ptr<TimestampOracle> oracle;
+        try {
+            oracle = findOracle(sequencer_id);
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            req.respond(result);
+            spdlog::error("[provider:{}] Could not create timestamp oracle for sequencer {}: {}",
+                    id(), sequencer_id.to_string(), result.error());
+            return;
+        }
+        if(not oracle) {
+            result.success() = false;
+            result.error() = "Sequencer "s + sequencer_id.to_string() + " does not issue timestamps";
+            req.respond(result);
+            return;
+        }
+        if(not m_dedup->begin(client_id, sequencer_id, request_seq, ctx.retry, result)) {
+            // retry of a request whose timestamps were already issued
+            req.respond(result);
+            return;
+        }
+        result = oracle->next(*sequencer, count);
+        m_dedup->complete(client_id, request_seq, result);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed timestamps on sequencer {}", id(), sequencer_id.to_string());
+    }
+
+    private:
+
+    /**
+     * @brief Returns the timestamp oracle of a sequencer, creating it if
+     * the sequencer's configuration has a "timestamps" section, or nullptr
+     * if it does not. The oracle is created lazily (rather than with the
+     * sequencer) so that sequencers that migrated to this provider or
+     * were promoted from a replica get one as well.
+     */
+    std::shared_ptr<TimestampOracle> findOracle(const UUID& sequencer_id) {
+        std::lock_guard<tl::mutex> lock(m_backends_mtx);
+        auto it = m_oracles.find(sequencer_id);
+        if(it != m_oracles.end()) return it->second;
+        auto info = m_sequencer_info.find(sequencer_id);
+        if(info == m_sequencer_info.end()) return nullptr;
+        auto config = json::parse(info->second.second);
+        if(not config.contains("timestamps")) return nullptr;
+        std::shared_ptr<TimestampOracle> oracle = TimestampOracle::fromConfig(config["timestamps"]);
+        m_oracles[sequencer_id] = oracle;
+        return oracle;
+    }
+
+    /**
+     * @brief Returns, among the provided objects with their known version,
+     * those whose current version is different (0 if the object does not
+     * exist). Used by the WatchRegistry to answer watch requests.
+     */
+    RequestResult<WatchRegistry::Versions> changedVersions(const UUID& sequencer_id,
+                                                           const WatchRegistry::Versions& objects) {
+        RequestResult<WatchRegistry::Versions> result;
+        std::shared_ptr<Backend> sequencer;
+        {
+            std::unique_lock<tl::mutex> lock(m_backends_mtx);
+            while(!m_frozen.empty() && m_frozen.count(sequencer_id))
+                m_backends_cv.wait(lock);
+            auto it = m_backends.find(sequencer_id);
+            if(it != m_backends.end()) {
+                sequencer = useBackend(it->second);
+            } else {
+                result.success() = false;
+                auto r = m_redirects.find(sequencer_id);
+                if(r != m_redirects.end()) {
+                    result.error() = "Sequencer with UUID "s + sequencer_id.to_string() + " has moved";
+                    result.redirectAddress() = r->second.first;
+                    result.redirectProviderId() = r->second.second;
+                } else {
+                    result.error() = "Sequencer with UUID "s + sequencer_id.to_string() + " not found";
+                }
+                return result;
+            }
+        }
+        for(auto& object : objects) {
+            auto version = sequencer->execute(object.first, WriteOp());
+            uint64_t current = version.success() ? version.value() : 0;
+            if(current != object.second)
+                result.value().emplace_back(object.first, current);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Turns the rest of a handler into the Completion of an
+     * asynchronous backend operation. Responding to a request requires
+     * an Argobots ULT, so if the backend completes the operation from
+     * another kind of thread, the rest of the handler runs in a new ULT
+     * of the data lane's pool. The continuation is counted in
+     * m_pending_completions until it has run, since it uses the provider.
+     */
+    template<typename T, typename F>
+    Completion<T> continuation(F&& f) {
+        auto pool = m_lanes->pool(Lanes::DATA);
+        {
+            std::lock_guard<tl::mutex> lock(m_pending_mtx);
+            m_pending_completions += 1;
+        }
+        auto run = [this, f=std::forward<F>(f)](RequestResult<T> result) mutable {
+            f(std::move(result));
+            std::lock_guard<tl::mutex> lock(m_pending_mtx);
+            m_pending_completions -= 1;
+            if(m_pending_completions == 0) m_pending_cv.notify_all();
+        };
+        return [pool, run](RequestResult<T> result) mutable {
+            ABT_unit_type type;
+            if(ABT_self_get_type(&type) == ABT_SUCCESS && type == ABT_UNIT_TYPE_THREAD) {
+                run(std::move(result));
+                return;
+            }
+            pool.make_thread([run, result]() mutable { run(std::move(result)); }, tl::anonymous());
+        };
+    }
+
+    /**
+     * @brief Same as the FIND_SEQUENCER macro, for handlers that do not
+     * respond: returns the sequencer, or null with the reason in error.
+     */
+    /**
+     * @brief Checks the size of the data of a request against the
+     * provider's max_request_size and the size of the client's bulk
+     * handle, setting error if it is invalid.
+     */
+    bool validSize(size_t size, const tl::bulk& bulk, std::string& error) const {
+        if(size > m_max_request_size) {
+            error = "Request size "s + std::to_string(size) + " exceeds the maximum of "
+                  + std::to_string(m_max_request_size) + " bytes";
+            return false;
+        }
+        if(size != 0 && (bulk.is_null() || bulk.size() < size)) {
+            error = "Invalid size "s + std::to_string(size) + " for a bulk handle of "
+                  + std::to_string(bulk.is_null() ? 0 : bulk.size()) + " bytes";
+            return false;
+        }
+        return true;
+    }
+
+    std::shared_ptr<Backend> findSequencer(const UUID& sequencer_id, std::string& error) {
+        std::unique_lock<tl::mutex> lock(m_backends_mtx);
+        while(!m_frozen.empty() && m_frozen.count(sequencer_id))
+            m_backends_cv.wait(lock);
+        auto it = m_backends.find(sequencer_id);
+        if(it != m_backends.end()) return useBackend(it->second);
+        if(m_redirects.count(sequencer_id))
+            error = "Sequencer with UUID "s + sequencer_id.to_string() + " has moved";
+        else
+            error = "Sequencer with UUID "s + sequencer_id.to_string() + " not found";
+        return nullptr;
+    }
+
+    /**
+     * @brief Returns the replica of a sequencer held by this provider
+     * (nullptr if it does not hold one).
+     */
+    std::shared_ptr<Backend> findReplica(const UUID& sequencer_id) {
+        std::lock_guard<tl::mutex> lock(m_backends_mtx);
+        auto it = m_replicas.find(sequencer_id);
+        if(it == m_replicas.end()) return nullptr;
+        return it->second;
+    }
+
+    // how setupReplication gets the replicas of a sequencer: creating or
+    // opening them, or taking over those of a sequencer migrating here
+    enum class ReplicaSetup { CREATE, OPEN, ADOPT };
+
+    /**
+     * @brief If the configuration of a new sequencer has a "replication"
+     * section, creates (or opens, or adopts) its replicas on the backup
+     * providers and wraps the backend into a ReplicatedBackend. The section
+     * looks like
+     * { "backups" : [ { "address" : "...", "provider_id" : 1 } ], "max_batch_size" : 256 }.
+     * Returns nullptr and sets error on failure, in which case the replicas
+     * that were created are destroyed, as well as the backend unless the
+     * replicas were to be adopted.
+     */
+    std::shared_ptr<Backend> setupReplication(const UUID& sequencer_id,
+                                              const std::string& token,
+                                              const std::string& sequencer_type,
+                                              const json& config,
+                                              std::shared_ptr<Backend> backend,
+                                              ReplicaSetup setup,
+                                              std::string& error) {
+        std::shared_ptr<Backend> sequencer = std::move(backend);
+        bool open = setup == ReplicaSetup::OPEN;
+        if(not config.is_object() || not config.contains("replication"))
+            return sequencer;
+        auto& replication = config["replication"];
+        json replica_config = config;
+        replica_config.erase("replication");
+        std::vector<tl::provider_handle> backups;
+        size_t max_batch_size = 256;
+        int64_t timeout_ms = 10000;
+        try {
+            max_batch_size = replication.value("max_batch_size", max_batch_size);
+            if(max_batch_size == 0)
+                throw Exception("max_batch_size should be strictly positive");
+            timeout_ms = replication.value("timeout_ms", timeout_ms);
+            if(timeout_ms <= 0)
+                throw Exception("timeout_ms should be strictly positive");
+            for(auto& backup : replication.value("backups", json::array())) {
+                auto endpoint = get_engine().lookup(backup.at("address").get<std::string>());
+                tl::provider_handle ph(endpoint, backup.at("provider_id").get<uint16_t>());
+                if(setup == ReplicaSetup::ADOPT) {
+                    backups.push_back(std::move(ph));
+                    continue;
+                }
+                RequestResult<bool> created = m_replica_create.on(ph)(
+                    token, sequencer_id, sequencer_type, replica_config.dump(), open);
+                if(not created.success())
+                    throw Exception(created.error());
+                backups.push_back(std::move(ph));
+            }
+        } catch(const std::exception& ex) {
+            error = ex.what();
+            if(setup == ReplicaSetup::ADOPT) return nullptr;
+            for(auto& ph : backups) {
+                try {
+                    RequestResult<bool> destroyed = m_destroy_sequencer.on(ph)(token, sequencer_id);
+                    (void)destroyed;
+                } catch(...) {}
+            }
+            sequencer->destroy();
+            return nullptr;
+        }
+        return std::make_shared<ReplicatedBackend>(
+            sequencer, m_replicate, m_destroy_sequencer,
+            sequencer_id, token, backups, max_batch_size,
+            std::chrono::milliseconds(timeout_ms));
+    }
+
+    /**
+     * @brief Returns a reference to a backend that counts as a use of it
+     * until the request holding it releases it (see waitUntilUnused).
+     * Must be called with m_backends_mtx held, so that a backend replaced
+     * in m_backends cannot gain new users.
+     */
+    std::shared_ptr<Backend> useBackend(const std::shared_ptr<Backend>& backend) {
+        {
+            std::lock_guard<tl::mutex> lock(m_users_mtx);
+            m_backend_users[backend.get()] += 1;
+        }
+        return std::shared_ptr<Backend>(backend.get(), [this, backend](Backend* b) {
+            std::lock_guard<tl::mutex> lock(m_users_mtx);
+            auto it = m_backend_users.find(b);
+            if(--it->second == 0) {
+                m_backend_users.erase(it);
+                m_users_cv.notify_all();
+            }
+        });
+    }
+
+    /**
+     * @brief Waits until the requests that obtained a backend with
+     * useBackend have released it.
+     */
+    void waitUntilUnused(const std::shared_ptr<Backend>& backend) {
+        std::unique_lock<tl::mutex> lock(m_users_mtx);
+        while(m_backend_users.count(backend.get()))
+            m_users_cv.wait(lock);
+    }
+
+    bool copyAllObjects(const tl::provider_handle& dest,
+                        const std::string& token,
+                        const UUID& sequencer_id,
+                        Backend& backend,
+                        std::string& error) {
+        std::string start_after;
+        while(true) {
+            auto page = backend.listObjects("", start_after, 1024);
+            if(not page.success()) {
+                error = page.error();
+                return false;
+            }
+            if(page.value().empty()) return true;
+            if(not copyObjects(dest, token, sequencer_id, backend, page.value(), error))
+                return false;
+            start_after = page.value().back();
+        }
+    }
+
+    bool copyObjects(const tl::provider_handle& dest,
+                     const std::string& token,
+                     const UUID& sequencer_id,
+                     Backend& backend,
+                     const std::vector<std::string>& objects,
+                     std::string& error) {
+        for(auto& object : objects)
+            if(not copyObject(dest, token, sequencer_id, backend, object, error))
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief Sends the current state of an object (data, omap, version)
+     * to the destination of a migration, or its absence if it does not
+     * exist. If the object is modified while being read, it is recorded
+     * as dirty and copied again later, so the state sent does not need
+     * to be a consistent snapshot.
+     */
+    bool copyObject(const tl::provider_handle& dest,
+                    const std::string& token,
+                    const UUID& sequencer_id,
+                    Backend& backend,
+                    const std::string& object,
+                    std::string& error) {
+        auto exists = [&]() {
+            auto r = backend.listObjects(object, "", 1);
+            return r.success() && !r.value().empty() && r.value()[0] == object;
+        };
+        bool present = exists();
+        uint64_t version = 0;
+        std::vector<char> data;
+        std::vector<std::pair<std::string, std::string>> omap;
+        while(present) {
+            // the version is read first: any later modification marks the object dirty
+            auto v = backend.execute(object, WriteOp());
+            if(not v.success()) { present = exists(); if(present) { error = v.error(); return false; } break; }
+            version = v.value();
+            bool ok = true;
+            while(ok) {
+                size_t offset = data.size();
+                data.resize(offset + transfer_chunk_size);
+                auto r = backend.read(object, offset, data.data() + offset, transfer_chunk_size);
+                if(not r.success()) { ok = false; error = r.error(); break; }
+                data.resize(offset + r.value());
+                if(r.value() < transfer_chunk_size) break;
+            }
+            std::string start_after;
+            while(ok) {
+                auto r = backend.omapScan(object, "", start_after, 1024);
+                if(not r.success()) { ok = false; error = r.error(); break; }
+                if(r.value().empty()) break;
+                start_after = r.value().back().first;
+                omap.insert(omap.end(), r.value().begin(), r.value().end());
+            }
+            if(ok) break;
+            // an error is expected if the object was removed concurrently
+            present = exists();
+            if(present) return false;
+            error.clear();
+        }
+        if(not present) {
+            data.clear();
+            omap.clear();
+        }
+        try {
+            tl::bulk bulk;
+            if(not data.empty())
+                bulk = get_engine().expose({{data.data(), data.size()}}, tl::bulk_mode::read_only);
+            RequestResult<bool> r = m_migration_put.on(dest)(
+                token, sequencer_id, object, present, version, omap,
+                data.size(), crc32c(data.data(), data.size()), bulk);
+            if(not r.success()) {
+                error = r.error();
+                return false;
+            }
+        } catch(const std::exception& ex) {
+            error = ex.what();
+            return false;
+        }
+        return true;
+    }
 };
 
 }
@@ -0,0 +1,268 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "ReplicatedBackend.hpp"
+#include "Hash.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace mobject {
+
+namespace tl = thallium;
+
+tl::mutex& ReplicatedBackend::objectLock(const std::string& object) {
+    return m_object_locks[hash64(object) % num_object_locks];
+}
+
+uint64_t ReplicatedBackend::enqueue(ReplicatedOp&& op) {
+    std::lock_guard<tl::mutex> lock(m_mtx);
+    m_pending.push_back(std::move(op));
+    return ++m_queued;
+}
+
+void ReplicatedBackend::waitReplicated(uint64_t seq) {
+    std::unique_lock<tl::mutex> lock(m_mtx);
+    while(m_acked < seq) {
+        if(m_sending) {
+            m_cv.wait(lock);
+            continue;
+        }
+        // nobody is sending: this caller sends everything queued so far,
+        // including the operations of the callers waiting behind it
+        m_sending = true;
+        std::vector<ReplicatedOp> batch;
+        size_t n = std::min(m_pending.size(), m_max_batch_size);
+        batch.reserve(n);
+        std::move(m_pending.begin(), m_pending.begin() + n, std::back_inserter(batch));
+        m_pending.erase(m_pending.begin(), m_pending.begin() + n);
+        m_sent += n;
+        uint64_t last = m_sent;
+        auto backups = m_backups;
+        size_t num_backups = backups.size();
+        lock.unlock();
+        sendBatch(batch, backups);
+        lock.lock();
+        m_dropped += num_backups - backups.size();
+        m_backups = std::move(backups);
+        m_acked = last;
+        m_sending = false;
+        m_cv.notify_all();
+    }
+}
+
+void ReplicatedBackend::sendBatch(const std::vector<ReplicatedOp>& batch,
+                                  std::vector<tl::provider_handle>& backups) {
+    if(batch.empty() || backups.empty()) return;
+    std::vector<tl::async_response> responses;
+    std::vector<bool> failed(backups.size(), false);
+    responses.reserve(backups.size());
+    for(size_t i = 0; i < backups.size(); i++) {
+        try {
+            responses.push_back(m_replicate.on(backups[i]).timed_async(m_timeout, m_token, m_sequencer_id, batch));
+        } catch(const std::exception& ex) {
+            spdlog::error("Could not send replication batch of sequencer {} to backup {}: {}",
+                    m_sequencer_id.to_string(), static_cast<std::string>(backups[i]), ex.what());
+            failed[i] = true;
+            responses.emplace_back();
+        }
+    }
+    for(size_t i = 0; i < backups.size(); i++) {
+        if(failed[i]) continue;
+        try {
+            RequestResult<bool> result = responses[i].wait();
+            if(not result.success()) {
+                spdlog::error("Backup {} of sequencer {} failed to apply replication batch: {}",
+                        static_cast<std::string>(backups[i]), m_sequencer_id.to_string(), result.error());
+                failed[i] = true;
+            }
+        } catch(const std::exception& ex) {
+            spdlog::error("Backup {} of sequencer {} did not respond to replication batch: {}",
+                    static_cast<std::string>(backups[i]), m_sequencer_id.to_string(), ex.what());
+            failed[i] = true;
+        }
+    }
+    std::vector<tl::provider_handle> remaining;
+    for(size_t i = 0; i < backups.size(); i++)
+        if(not failed[i]) remaining.push_back(backups[i]);
+    backups = std::move(remaining);
+}
+
+template<typename Result, typename Apply, typename MakeOp>
+Result ReplicatedBackend::replicate(const std::string& object, Apply&& apply, MakeOp&& make_op) {
+    uint64_t seq;
+    Result result;
+    {
+        std::lock_guard<tl::mutex> lock(objectLock(object));
+        result = apply();
+        if(not result.success()) return result;
+        ReplicatedOp op;
+        op.object = object;
+        make_op(op, result);
+        seq = enqueue(std::move(op));
+    }
+    waitReplicated(seq);
+    return result;
+}
+
+RequestResult<bool> ReplicatedBackend::apply(Backend& backend,
+                                             const std::vector<ReplicatedOp>& ops) {
+    RequestResult<bool> result;
+    for(auto& op : ops) {
+        if(op.remove) {
+            auto r = backend.remove(op.object);
+            result.success() = r.success();
+            result.error() = r.error();
+        } else if(op.reserve) {
+            auto r = backend.reserve(op.object, op.size);
+            result.success() = r.success();
+            result.error() = r.error();
+            if(r.success() && r.value() != op.offset) {
+                result.success() = false;
+                result.error() = "Replica of object " + op.object + " reserved a different offset";
+            }
+        } else {
+            auto r = backend.execute(op.object, op.op);
+            result.success() = r.success();
+            result.error() = r.error();
+        }
+        if(not result.success()) break;
+    }
+    return result;
+}
+
+size_t ReplicatedBackend::numBackups() {
+    std::lock_guard<tl::mutex> lock(m_mtx);
+    return m_backups.size();
+}
+
+size_t ReplicatedBackend::numDroppedBackups() {
+    std::lock_guard<tl::mutex> lock(m_mtx);
+    return m_dropped;
+}
+
+void ReplicatedBackend::sayHello() {
+    m_backend->sayHello();
+}
+
+RequestResult<int32_t> ReplicatedBackend::computeSum(int32_t x, int32_t y) {
+    return m_backend->computeSum(x, y);
+}
+
+RequestResult<bool> ReplicatedBackend::write(const std::string& object,
+                                             uint64_t offset,
+                                             const char* data,
+                                             size_t size) {
+    return replicate<RequestResult<bool>>(object,
+        [&]() { return m_backend->write(object, offset, data, size); },
+        [&](ReplicatedOp& op, const RequestResult<bool>&) {
+            op.op.create().write(offset, data, size);
+        });
+}
+
+RequestResult<uint64_t> ReplicatedBackend::reserve(const std::string& object,
+                                                   size_t size) {
+    return replicate<RequestResult<uint64_t>>(object,
+        [&]() { return m_backend->reserve(object, size); },
+        [&](ReplicatedOp& op, const RequestResult<uint64_t>& result) {
+            op.reserve = true;
+            op.offset = result.value();
+            op.size = size;
+        });
+}
+
+RequestResult<size_t> ReplicatedBackend::read(const std::string& object,
+                                              uint64_t offset,
+                                              char* data,
+                                              size_t size) {
+    return m_backend->read(object, offset, data, size);
+}
+
+RequestResult<bool> ReplicatedBackend::remove(const std::string& object) {
+    return replicate<RequestResult<bool>>(object,
+        [&]() { return m_backend->remove(object); },
+        [&](ReplicatedOp& op, const RequestResult<bool>&) {
+            op.remove = true;
+        });
+}
+
+RequestResult<std::vector<std::string>> ReplicatedBackend::listObjects(
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) {
+    return m_backend->listObjects(prefix, start_after, max);
+}
+
+RequestResult<bool> ReplicatedBackend::omapSet(const std::string& object,
+                                               const KeyValues& entries) {
+    return replicate<RequestResult<bool>>(object,
+        [&]() { return m_backend->omapSet(object, entries); },
+        [&](ReplicatedOp& op, const RequestResult<bool>&) {
+            op.op.create().omapSet(entries);
+        });
+}
+
+RequestResult<ReplicatedBackend::KeyValues> ReplicatedBackend::omapGet(
+        const std::string& object,
+        const std::vector<std::string>& keys) {
+    return m_backend->omapGet(object, keys);
+}
+
+RequestResult<bool> ReplicatedBackend::omapRemove(const std::string& object,
+                                                  const std::vector<std::string>& keys) {
+    return replicate<RequestResult<bool>>(object,
+        [&]() { return m_backend->omapRemove(object, keys); },
+        [&](ReplicatedOp& op, const RequestResult<bool>&) {
+            op.op.omapRemove(keys);
+        });
+}
+
+RequestResult<ReplicatedBackend::KeyValues> ReplicatedBackend::omapScan(
+        const std::string& object,
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) {
+    return m_backend->omapScan(object, prefix, start_after, max);
+}
+
+RequestResult<uint64_t> ReplicatedBackend::execute(const std::string& object,
+                                                   const WriteOp& op) {
+    if(op.steps().empty() && not op.creates() && not op.setsVersion())
+        return m_backend->execute(object, op); // only checks preconditions
+    return replicate<RequestResult<uint64_t>>(object,
+        [&]() { return m_backend->execute(object, op); },
+        [&](ReplicatedOp& rop, const RequestResult<uint64_t>& result) {
+            rop.op = op;
+            rop.op.setVersion(result.value());
+        });
+}
+
+RequestResult<bool> ReplicatedBackend::flush() {
+    return m_backend->flush();
+}
+
+RequestResult<bool> ReplicatedBackend::destroy() {
+    std::vector<tl::provider_handle> backups;
+    {
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        backups.swap(m_backups);
+    }
+    for(auto& backup : backups) {
+        try {
+            RequestResult<bool> result = m_destroy.on(backup)(m_token, m_sequencer_id);
+            if(not result.success())
+                spdlog::warn("Could not destroy replica of sequencer {} on {}: {}",
+                        m_sequencer_id.to_string(), static_cast<std::string>(backup), result.error());
+        } catch(const std::exception& ex) {
+            spdlog::warn("Could not destroy replica of sequencer {} on {}: {}",
+                    m_sequencer_id.to_string(), static_cast<std::string>(backup), ex.what());
+        }
+    }
+    return m_backend->destroy();
+}
+
+}
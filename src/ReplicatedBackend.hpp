@@ -0,0 +1,215 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_REPLICATED_BACKEND_HPP
+#define __MOBJECT_REPLICATED_BACKEND_HPP
+
+#include <mobject/Backend.hpp>
+#include <mobject/UUID.hpp>
+
+#include <thallium.hpp>
+#include <thallium/serialization/stl/string.hpp>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mobject {
+
+/**
+ * @brief Modification of an object sent by a primary to its backups.
+ * Every mutation is expressed as a WriteOp (or a removal, or a
+ * reservation), so backups apply it with Backend::execute (or
+ * Backend::remove, or Backend::reserve).
+ */
+struct ReplicatedOp {
+
+    std::string object;
+    bool        remove = false;
+    bool        reserve = false;
+    uint64_t    offset = 0; // offset obtained by the primary for a reservation
+    uint64_t    size = 0;   // size of a reservation
+    WriteOp     op;
+
+    template<typename Archive>
+    void serialize(Archive& a) {
+        a & object;
+        a & remove;
+        a & reserve;
+        a & offset;
+        a & size;
+        a & op;
+    }
+};
+
+/**
+ * @brief ReplicatedBackend wraps the backend of a primary sequencer and
+ * forwards every successful mutation to the backup providers holding a
+ * replica of the sequencer, before returning to the caller.
+ *
+ * Mutations are applied locally first, then queued. A mutation returns
+ * once the batch containing it has been applied by all the backups.
+ * Batches are sent to all the backups in parallel and, while a batch is
+ * in flight, the mutations that complete locally accumulate into the
+ * next one (group commit), so replication adds about one round-trip to
+ * the latency of a mutation regardless of the number of backups, and
+ * concurrent mutations share RPCs.
+ *
+ * Mutations of the same object are queued in the order in which they
+ * were applied locally, so replicas go through the same states (and
+ * versions) as the primary. Reservations made by append are replicated
+ * too, so that a promoted replica does not hand out offsets already
+ * reserved on the primary.
+ *
+ * A backup that fails to apply a batch, or does not answer within the
+ * replication timeout ("timeout_ms" in the "replication" section of the
+ * sequencer's configuration, 10 seconds by default), is removed from the
+ * set of backups (and an error is logged) so that the primary remains
+ * available; it should then be destroyed and replaced. The number of
+ * backups dropped is reported by numDroppedBackups (and in the
+ * statistics of the provider).
+ */
+class ReplicatedBackend : public Backend {
+
+    using KeyValues = std::vector<std::pair<std::string, std::string>>;
+
+    static constexpr size_t num_object_locks = 64;
+
+    std::shared_ptr<Backend>                     m_backend;
+    thallium::remote_procedure                   m_replicate;
+    thallium::remote_procedure                   m_destroy;
+    UUID                                         m_sequencer_id;
+    std::string                                  m_token;
+    std::vector<thallium::provider_handle>       m_backups;
+    size_t                                       m_max_batch_size;
+    std::chrono::milliseconds                    m_timeout;
+    // serialize the local application and queueing of the mutations
+    // of a given object, so they are queued in the order they are applied
+    std::array<thallium::mutex, num_object_locks> m_object_locks;
+    // replication queue
+    std::vector<ReplicatedOp>                    m_pending;
+    uint64_t                                     m_queued = 0;  // number of ops queued so far
+    uint64_t                                     m_sent = 0;    // number of ops taken into batches
+    uint64_t                                     m_acked = 0;   // number of ops applied by the backups
+    size_t                                       m_dropped = 0; // number of backups dropped after a failure
+    bool                                         m_sending = false;
+    thallium::mutex                              m_mtx;
+    thallium::condition_variable                 m_cv;
+
+    thallium::mutex& objectLock(const std::string& object);
+
+    uint64_t enqueue(ReplicatedOp&& op);
+
+    void waitReplicated(uint64_t seq);
+
+    void sendBatch(const std::vector<ReplicatedOp>& batch,
+                   std::vector<thallium::provider_handle>& backups);
+
+    template<typename Result, typename Apply, typename MakeOp>
+    Result replicate(const std::string& object, Apply&& apply, MakeOp&& make_op);
+
+    public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param backend Backend of the primary sequencer.
+     * @param replicate RPC applying a batch of ReplicatedOps on a backup.
+     * @param destroy RPC destroying the replica held by a backup.
+     * @param sequencer_id UUID of the sequencer.
+     * @param token Security token of the backups.
+     * @param backups Providers holding a replica.
+     * @param max_batch_size Maximum number of operations per RPC.
+     * @param timeout Time after which a backup that has not applied
+     * a batch is dropped.
+     */
+    ReplicatedBackend(const std::shared_ptr<Backend>& backend,
+                      const thallium::remote_procedure& replicate,
+                      const thallium::remote_procedure& destroy,
+                      const UUID& sequencer_id,
+                      const std::string& token,
+                      const std::vector<thallium::provider_handle>& backups,
+                      size_t max_batch_size,
+                      std::chrono::milliseconds timeout)
+    : m_backend(backend)
+    , m_replicate(replicate)
+    , m_destroy(destroy)
+    , m_sequencer_id(sequencer_id)
+    , m_token(token)
+    , m_backups(backups)
+    , m_max_batch_size(max_batch_size)
+    , m_timeout(timeout) {}
+
+    /**
+     * @brief Applies a batch of operations received from a primary
+     * to the backend of a replica.
+     */
+    static RequestResult<bool> apply(Backend& backend,
+                                     const std::vector<ReplicatedOp>& ops);
+
+    /**
+     * @brief Returns the number of backups still receiving the mutations.
+     */
+    size_t numBackups();
+
+    /**
+     * @brief Returns the number of backups dropped because they failed
+     * to apply a batch.
+     */
+    size_t numDroppedBackups();
+
+    void sayHello() override;
+
+    RequestResult<int32_t> computeSum(int32_t x, int32_t y) override;
+
+    RequestResult<bool> write(const std::string& object,
+                              uint64_t offset,
+                              const char* data,
+                              size_t size) override;
+
+    RequestResult<uint64_t> reserve(const std::string& object,
+                                    size_t size) override;
+
+    RequestResult<size_t> read(const std::string& object,
+                               uint64_t offset,
+                               char* data,
+                               size_t size) override;
+
+    RequestResult<bool> remove(const std::string& object) override;
+
+    RequestResult<std::vector<std::string>> listObjects(
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) override;
+
+    RequestResult<bool> omapSet(const std::string& object,
+                                const KeyValues& entries) override;
+
+    RequestResult<KeyValues> omapGet(
+            const std::string& object,
+            const std::vector<std::string>& keys) override;
+
+    RequestResult<bool> omapRemove(const std::string& object,
+                                   const std::vector<std::string>& keys) override;
+
+    RequestResult<KeyValues> omapScan(
+            const std::string& object,
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) override;
+
+    RequestResult<uint64_t> execute(const std::string& object,
+                                    const WriteOp& op) override;
+
+    RequestResult<bool> flush() override;
+
+    RequestResult<bool> destroy() override;
+};
+
+}
+
+#endif
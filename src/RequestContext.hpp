@@ -0,0 +1,80 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_REQUEST_CONTEXT_HPP
+#define __MOBJECT_REQUEST_CONTEXT_HPP
+
+#include <thallium/serialization/stl/string.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace mobject {
+
+/**
+ * @brief Information sent by the client along with each request on a
+ * sequencer, following the sequencer's UUID. timeout_ms is the time
+ * the client is still willing to wait for the response (0 if it has no
+ * deadline). Since the clocks of the client and of the provider are not
+ * synchronized, the provider turns it into a local deadline when it
+ * receives the request, and drops requests whose deadline expired
+ * before they could be executed. priority is the request's Priority
+ * class, which providers scheduling requests by deadline take into
+ * account, and tenant (with its token) identifies the team the request
+ * is made for, for fair queuing and quotas (see AdmissionControl).
+ * retry is set when an earlier attempt of the same request timed out,
+ * so that it may have been executed (see DedupTable::begin).
+ */
+struct RequestContext {
+
+    using clock = std::chrono::steady_clock;
+
+    uint32_t          timeout_ms = 0;
+    uint8_t           priority = 1; // see mobject::Priority
+    std::string       tenant;
+    std::string       tenant_token;
+    bool              retry = false;
+    clock::time_point received; // set on the provider when the request is received
+
+    /**
+     * @brief Returns the deadline of the request in the provider's
+     * clock (time_point::max() if the request has no deadline).
+     */
+    clock::time_point deadline() const {
+        if(timeout_ms == 0) return clock::time_point::max();
+        return received + std::chrono::milliseconds(timeout_ms);
+    }
+
+    /**
+     * @brief Returns whether the client stopped waiting for the response.
+     */
+    bool expired() const {
+        return timeout_ms != 0 && clock::now() > deadline();
+    }
+
+    template<typename Archive>
+    void save(Archive& a) const {
+        a & timeout_ms;
+        a & priority;
+        a & tenant;
+        a & tenant_token;
+        a & retry;
+    }
+
+    template<typename Archive>
+    void load(Archive& a) {
+        a & timeout_ms;
+        a & priority;
+        a & tenant;
+        a & tenant_token;
+        a & retry;
+        received = clock::now();
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "mobject/Router.hpp"
+#include "mobject/Exception.hpp"
+
+#include "RouterImpl.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+
+namespace mobject {
+
+using json = nlohmann::json;
+
+Router::Router() = default;
+
+Router::Router(const Client& client, const std::string& config) {
+    json cfg;
+    try {
+        cfg = json::parse(config.empty() ? "{}" : config);
+    } catch(json::parse_error& e) {
+        throw Exception(e.what());
+    }
+    if(not cfg.is_object())
+        throw Exception("Router configuration should be an object");
+    size_t virtual_nodes = cfg.value("virtual_nodes", (size_t)128);
+    if(virtual_nodes == 0)
+        throw Exception("virtual_nodes should be strictly positive");
+    self = std::make_shared<RouterImpl>(client, virtual_nodes);
+    if(not cfg.contains("members")) return;
+    auto& members = cfg["members"];
+    if(not members.is_array())
+        throw Exception("\"members\" field in Router configuration should be an array");
+    for(auto& m : members) {
+        if(not m.is_object()
+        || not m.contains("address") || not m["address"].is_string()
+        || not m.contains("sequencer_id") || not m["sequencer_id"].is_string())
+            throw Exception("Router members should have an \"address\" and a \"sequencer_id\"");
+        auto address = m["address"].get<std::string>();
+        auto provider_id = m.value("provider_id", (uint16_t)0);
+        auto sequencer_id = UUID::from_string(m["sequencer_id"].get<std::string>().c_str());
+        addMember(address, provider_id, sequencer_id);
+    }
+}
+
+Router::Router(const Router&) = default;
+
+Router::Router(Router&&) = default;
+
+Router& Router::operator=(const Router&) = default;
+
+Router& Router::operator=(Router&&) = default;
+
+Router::~Router() = default;
+
+Router::operator bool() const {
+    return static_cast<bool>(self);
+}
+
+std::string Router::getConfig() const {
+    if(not self) throw Exception("Invalid mobject::Router object");
+    json cfg = json::object();
+    cfg["virtual_nodes"] = self->m_virtual_nodes;
+    cfg["members"] = json::array();
+    for(auto& m : self->m_members) {
+        cfg["members"].push_back({
+            { "address", m.address },
+            { "provider_id", m.provider_id },
+            { "sequencer_id", m.sequencer_id.to_string() }
+        });
+    }
+    return cfg.dump();
+}
+
+void Router::addMember(const std::string& address,
+                       uint16_t provider_id,
+                       const UUID& sequencer_id,
+                       bool check) {
+    if(not self) throw Exception("Invalid mobject::Router object");
+    for(auto& m : self->m_members)
+        if(m.sequencer_id == sequencer_id)
+            throw Exception(std::string("Sequencer ") + sequencer_id.to_string() + " is already a member of the Router");
+    auto handle = self->m_client.makeSequencerHandle(address, provider_id, sequencer_id, check);
+    self->m_members.push_back({ address, provider_id, sequencer_id, handle });
+    self->rebuild();
+}
+
+void Router::removeMember(const UUID& sequencer_id) {
+    if(not self) throw Exception("Invalid mobject::Router object");
+    auto& members = self->m_members;
+    auto it = std::find_if(members.begin(), members.end(),
+        [&](const RouterImpl::Member& m) { return m.sequencer_id == sequencer_id; });
+    if(it == members.end())
+        throw Exception(std::string("Sequencer ") + sequencer_id.to_string() + " is not a member of the Router");
+    members.erase(it);
+    self->rebuild();
+}
+
+size_t Router::numMembers() const {
+    if(not self) throw Exception("Invalid mobject::Router object");
+    return self->m_members.size();
+}
+
+SequencerHandle Router::route(const std::string& object) const {
+    if(not self) throw Exception("Invalid mobject::Router object");
+    if(self->m_members.empty())
+        throw Exception("Router has no members");
+    return self->memberFor(object).handle;
+}
+
+UUID Router::locate(const std::string& object) const {
+    if(not self) throw Exception("Invalid mobject::Router object");
+    if(self->m_members.empty())
+        throw Exception("Router has no members");
+    return self->memberFor(object).sequencer_id;
+}
+
+}
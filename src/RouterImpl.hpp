@@ -0,0 +1,69 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_ROUTER_IMPL_H
+#define __MOBJECT_ROUTER_IMPL_H
+
+#include <mobject/Client.hpp>
+#include <mobject/SequencerHandle.hpp>
+#include <mobject/UUID.hpp>
+#include "Hash.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace mobject {
+
+class RouterImpl {
+
+    public:
+
+    struct Member {
+        std::string     address;
+        uint16_t        provider_id;
+        UUID            sequencer_id;
+        SequencerHandle handle;
+    };
+
+    Client              m_client;
+    size_t              m_virtual_nodes = 128;
+    std::vector<Member> m_members;
+    // points on the hash ring and the index of the member owning them,
+    // sorted by point
+    std::vector<std::pair<uint64_t, size_t>> m_ring;
+
+    RouterImpl(const Client& client, size_t virtual_nodes)
+    : m_client(client)
+    , m_virtual_nodes(virtual_nodes) {}
+
+    /**
+     * @brief Recomputes the ring after a membership change. A member's
+     * points only depend on its sequencer UUID, so they do not move
+     * when other members are added or removed.
+     */
+    void rebuild() {
+        m_ring.clear();
+        m_ring.reserve(m_members.size() * m_virtual_nodes);
+        for(size_t i = 0; i < m_members.size(); i++) {
+            auto key = m_members[i].sequencer_id.to_string();
+            for(size_t v = 0; v < m_virtual_nodes; v++)
+                m_ring.emplace_back(hash64(key, v), i);
+        }
+        std::sort(m_ring.begin(), m_ring.end());
+    }
+
+    const Member& memberFor(const std::string& object) const {
+        uint64_t h = hash64(object);
+        auto it = std::lower_bound(m_ring.begin(), m_ring.end(),
+                                   std::make_pair(h, (size_t)0));
+        if(it == m_ring.end()) it = m_ring.begin();
+        return m_members[it->second];
+    }
+};
+
+}
+
+#endif
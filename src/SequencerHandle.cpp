@@ -10,12 +10,417 @@
 #include "AsyncRequestImpl.hpp"
 #include "ClientImpl.hpp"
 #include "SequencerHandleImpl.hpp"
+#include "Checksum.hpp"
+#include "RequestContext.hpp"
+#include "LatencyTracker.hpp"
+#include "Timespec.hpp"
 
 #include <thallium/serialization/stl/string.hpp>
 #include <thallium/serialization/stl/pair.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+
 namespace mobject {
 
+using clock = std::chrono::steady_clock;
+
+/**
+ * @brief Deadline and retry options of a call, shared by its attempts.
+ */
+struct CallOptions {
+
+    // maximum number of times a request rejected by a busy provider is sent again
+    static constexpr unsigned max_busy_retries = 8;
+
+    clock::time_point         deadline = clock::time_point::max();
+    bool                      retry = true; // whether the request can safely be sent again
+    unsigned                  attempts = 0; // number of attempts made so far
+    unsigned                  busy_retries = 0; // number of times the provider was busy
+    bool                      timed_out = false; // an attempt timed out, possibly after being executed
+    Priority                  priority = Priority::NORMAL;
+    std::chrono::milliseconds wait = std::chrono::milliseconds(0); // time the provider may hold the request
+
+    CallOptions(const SequencerHandleImpl& impl, bool retry = true)
+    : retry(retry)
+    , priority(impl.m_priority) {
+        auto timeout = impl.timeout();
+        if(timeout.count() > 0) deadline = clock::now() + timeout;
+    }
+
+    bool expired() const {
+        return clock::now() >= deadline;
+    }
+
+    /**
+     * @brief Extends the deadline (and the timeout of each attempt) of
+     * a request that the provider holds on purpose, e.g. a long poll.
+     */
+    void allowWait(std::chrono::milliseconds w) {
+        wait = w;
+        if(deadline != clock::time_point::max()) deadline += w;
+    }
+
+    /**
+     * @brief Returns the timeout of the next attempt, 0 if it has none,
+     * or a negative value if the deadline has passed.
+     */
+    std::chrono::milliseconds attemptTimeout(const ClientImpl& client) const {
+        auto timeout = client.m_attempt_timeout;
+        if(timeout.count() > 0) timeout += wait;
+        if(deadline != clock::time_point::max()) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now());
+            if(remaining.count() <= 0) return std::chrono::milliseconds(-1);
+            if(timeout.count() == 0 || remaining < timeout) timeout = remaining;
+        }
+        return timeout;
+    }
+
+    /**
+     * @brief Returns whether an attempt that timed out can be retried,
+     * in which case it waits for a random backoff delay (full jitter).
+     */
+    bool backoff(const ClientImpl& client) {
+        timed_out = true;
+        if(not retry || attempts > client.m_max_retries || expired()) return false;
+        static thread_local std::mt19937 rng(std::random_device{}());
+        auto max_delay = client.m_backoff.count() << std::min<unsigned>(attempts - 1, 16);
+        auto delay = std::uniform_int_distribution<int64_t>(0, max_delay)(rng);
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+        if(delay >= remaining) return false;
+        if(delay > 0) tl::thread::sleep(client.m_engine, delay);
+        return true;
+    }
+
+    /**
+     * @brief Returns whether a request that a busy provider rejected can
+     * be sent again, in which case it waits for the provider's hint plus
+     * up to 50% more at random, so that rejected clients do not all
+     * come back at once. Such requests had no effect, so they can be
+     * sent again even if they are not idempotent.
+     */
+    bool busyBackoff(const ClientImpl& client, uint32_t retry_after) {
+        if(busy_retries >= max_busy_retries) return false;
+        busy_retries += 1;
+        static thread_local std::mt19937 rng(std::random_device{}());
+        auto delay = retry_after + std::uniform_int_distribution<uint32_t>(0, retry_after / 2)(rng);
+        if(deadline != clock::time_point::max()
+        && clock::now() + std::chrono::milliseconds(delay) >= deadline)
+            return false;
+        tl::thread::sleep(client.m_engine, delay);
+        return true;
+    }
+};
+
+/**
+ * @brief Returns the RequestContext sent with an attempt of a call
+ * limited to the given timeout (none if not positive).
+ */
+static RequestContext makeContext(const ClientImpl& client,
+                                  const CallOptions& options,
+                                  std::chrono::milliseconds timeout) {
+    RequestContext ctx;
+    ctx.timeout_ms   = timeout.count() > 0 ? timeout.count() : 0;
+    ctx.priority     = static_cast<uint8_t>(options.priority);
+    ctx.tenant       = client.m_tenant;
+    ctx.tenant_token = client.m_tenant_token;
+    ctx.retry        = options.timed_out;
+    return ctx;
+}
+
+template<typename Result>
+static Result timedOut() {
+    Result result;
+    result.success() = false;
+    result.error() = "Request timed out";
+    return result;
+}
+
+/**
+ * @brief Sends an RPC to the sequencer and returns its response. The
+ * RPC is sent with a RequestContext holding the time remaining before
+ * the call's deadline. If the sequencer has migrated to another
+ * provider, the handle is updated to point to the new provider and the
+ * RPC is sent again. If an attempt times out, the RPC is retried
+ * according to the client's retry policy. If the provider is busy, the
+ * RPC is sent again after the delay it suggests.
+ */
+template<typename Result, typename ... Args>
+static Result call(SequencerHandleImpl& impl,
+                   const tl::remote_procedure& rpc,
+                   CallOptions& options,
+                   const UUID& sequencer_id,
+                   const Args& ... args) {
+    auto& client = *impl.m_client;
+    unsigned redirects = 0;
+    while(true) {
+        auto timeout = options.attemptTimeout(client);
+        if(timeout.count() < 0) return timedOut<Result>();
+        auto ctx = makeContext(client, options, timeout);
+        options.attempts += 1;
+        try {
+            Result response = timeout.count() == 0
+                ? rpc.on(impl.providerHandle())(sequencer_id, ctx, args...)
+                : rpc.on(impl.providerHandle()).timed(timeout, sequencer_id, ctx, args...);
+            if(response.busy()) {
+                if(options.busyBackoff(client, response.retryAfter())) continue;
+                return response;
+            }
+            if(not response.redirected() || redirects == SequencerHandleImpl::max_redirects)
+                return response;
+            redirects += 1;
+            impl.redirect(response.redirectAddress(), response.redirectProviderId());
+        } catch(const tl::timeout&) {
+            if(not options.backoff(client)) return timedOut<Result>();
+        }
+    }
+}
+
+/**
+ * @brief Sends the first attempt of an asynchronous call.
+ */
+template<typename ... Args>
+static tl::async_response callAsync(SequencerHandleImpl& impl,
+                                    const tl::remote_procedure& rpc,
+                                    CallOptions& options,
+                                    const UUID& sequencer_id,
+                                    const Args& ... args) {
+    auto timeout = options.attemptTimeout(*impl.m_client);
+    // an already expired call is sent with a minimal timeout, so that
+    // it fails when it is waited on
+    if(timeout.count() < 0) timeout = std::chrono::milliseconds(1);
+    auto ctx = makeContext(*impl.m_client, options, timeout);
+    options.attempts += 1;
+    if(timeout.count() == 0)
+        return rpc.on(impl.providerHandle()).async(sequencer_id, ctx, args...);
+    return rpc.on(impl.providerHandle()).timed_async(timeout, sequencer_id, ctx, args...);
+}
+
+/**
+ * @brief Waits for the response of an asynchronous call. If the sequencer
+ * has migrated, the provider is busy or the attempt timed out, the call
+ * is continued synchronously, as in call.
+ */
+template<typename Result, typename ... Args>
+static Result waitResponse(AsyncRequestImpl& async_request,
+                           SequencerHandleImpl& impl,
+                           const tl::remote_procedure& rpc,
+                           CallOptions& options,
+                           const UUID& sequencer_id,
+                           const Args& ... args) {
+    try {
+        Result response = async_request.m_async_response.wait();
+        if(response.busy()) {
+            if(not options.busyBackoff(*impl.m_client, response.retryAfter())) return response;
+        } else if(not response.redirected()) {
+            return response;
+        } else {
+            impl.redirect(response.redirectAddress(), response.redirectProviderId());
+        }
+    } catch(const tl::timeout&) {
+        if(not options.backoff(*impl.m_client)) return timedOut<Result>();
+    }
+    return call<Result>(impl, rpc, options, sequencer_id, args...);
+}
+
+using ReadResult = RequestResult<std::pair<size_t, uint32_t>>;
+
+/**
+ * @brief Reads from the sequencer and, if the read has not completed
+ * after the client's hedging delay, from one of its replicas as well.
+ * Each request transfers into its own buffer, and the data of the
+ * response that is used is copied into data. The response of the
+ * primary is always used if it arrives first; a failed response from
+ * the replica is ignored in favor of the primary's. The other request
+ * is not waited for: its response is discarded when it arrives (if it
+ * is still queued on its provider when the call's deadline expires,
+ * the provider drops it).
+ */
+static ReadResult hedgedRead(const std::shared_ptr<SequencerHandleImpl>& impl,
+                             const CallOptions& options,
+                             const std::string& object,
+                             uint64_t offset,
+                             char* data,
+                             size_t size) {
+    struct Hedge {
+        tl::mutex              mtx;
+        tl::condition_variable cv;
+        bool                   done = false;
+        unsigned               pending = 0;
+        ReadResult             response;
+        std::vector<char>      buffer;
+    };
+    auto& client = *impl->m_client;
+    auto hedge = std::make_shared<Hedge>();
+    auto start = clock::now();
+    // sends the read to the primary (replica < 0) or to the given replica
+    auto attempt = [hedge, impl, options=options, object, offset, size, start](int replica) mutable {
+        auto& client = *impl->m_client;
+        std::vector<char> buffer(size);
+        ReadResult response;
+        try {
+            tl::bulk bulk;
+            if(size != 0) {
+                bulk = client.m_engine.expose(
+                    {{buffer.data(), size}}, tl::bulk_mode::write_only);
+            }
+            if(replica < 0) {
+                response = call<ReadResult>(*impl, client.m_read, options,
+                    impl->m_sequencer_id, object, offset, size, bulk);
+                client.m_read_latencies.record(
+                    std::chrono::duration_cast<LatencyTracker::duration>(clock::now() - start));
+            } else {
+                // a single attempt, within the deadline of the call
+                auto& ph = impl->m_replicas[replica];
+                auto timeout = options.attemptTimeout(client);
+                auto ctx = makeContext(client, options, timeout);
+                if(timeout.count() < 0)
+                    response = timedOut<ReadResult>();
+                else if(timeout.count() == 0)
+                    response = client.m_read.on(ph)(impl->m_sequencer_id, ctx, object, offset, size, bulk);
+                else
+                    response = client.m_read.on(ph).timed(timeout, impl->m_sequencer_id, ctx, object, offset, size, bulk);
+                if(response.redirected()) {
+                    response.success() = false;
+                    response.error() = "Replica has moved";
+                }
+            }
+        } catch(const tl::timeout&) {
+            response = timedOut<ReadResult>();
+        } catch(const std::exception& ex) {
+            response.success() = false;
+            response.error() = ex.what();
+        }
+        std::lock_guard<tl::mutex> lock(hedge->mtx);
+        hedge->pending -= 1;
+        if(not hedge->done && (replica < 0 || response.success() || hedge->pending == 0)) {
+            hedge->done     = true;
+            hedge->response = std::move(response);
+            hedge->buffer   = std::move(buffer);
+        }
+        hedge->cv.notify_all();
+    };
+    auto pool = client.m_engine.get_handler_pool();
+    std::unique_lock<tl::mutex> lock(hedge->mtx);
+    hedge->pending += 1;
+    pool.make_thread([attempt]() mutable { attempt(-1); }, tl::anonymous());
+    // reads are not hedged until enough latencies have been observed
+    auto delay = client.m_read_latencies.percentile(
+        client.m_hedge_percentile, LatencyTracker::duration::max());
+    if(delay != LatencyTracker::duration::max()) {
+        auto hedge_at = start + std::max<LatencyTracker::duration>(delay, client.m_hedge_min_delay);
+        while(not hedge->done && clock::now() < hedge_at) {
+            auto ts = timespecAt(hedge_at);
+            hedge->cv.wait_until(lock, &ts);
+        }
+        if(not hedge->done && not options.expired()) {
+            static thread_local std::mt19937 rng(std::random_device{}());
+            int replica = std::uniform_int_distribution<int>(0, static_cast<int>(impl->m_replicas.size()) - 1)(rng);
+            hedge->pending += 1;
+            pool.make_thread([attempt, replica]() mutable { attempt(replica); }, tl::anonymous());
+        }
+    }
+    while(not hedge->done)
+        hedge->cv.wait(lock);
+    if(hedge->response.success())
+        std::copy(hedge->buffer.begin(),
+                  hedge->buffer.begin() + std::min(hedge->response.value().first, size),
+                  data);
+    return hedge->response;
+}
+
+/**
+ * @brief Waits until the provider of a stream has applied the operations
+ * posted to it, and records those that failed in the stream. Called with
+ * the stream's mutex locked. Throws if the provider cannot be reached
+ * before the call's deadline.
+ */
+static void drainPosted(SequencerHandleImpl& impl,
+                        ClientImpl::PostedStream& stream,
+                        CallOptions& options) {
+    if(stream.m_posted == 0) return;
+    auto& client = *impl.m_client;
+    auto& rpc = client.m_posted_barrier;
+    RequestResult<uint64_t> response;
+    while(true) {
+        auto timeout = options.attemptTimeout(client);
+        if(timeout.count() < 0) throw Exception("Request timed out");
+        auto ctx = makeContext(client, options, timeout);
+        options.attempts += 1;
+        try {
+            response = timeout.count() == 0
+                ? rpc.on(stream.m_ph)(impl.m_sequencer_id, ctx, stream.m_stream_id, stream.m_posted)
+                : rpc.on(stream.m_ph).timed(timeout, impl.m_sequencer_id, ctx, stream.m_stream_id, stream.m_posted);
+            break;
+        } catch(const tl::timeout&) {
+            // waiting again is harmless
+            if(not options.backoff(client)) throw Exception("Request timed out");
+        }
+    }
+    if(not response.success()) throw Exception(response.error());
+    if(response.value() != 0) {
+        if(stream.m_failed == 0) stream.m_first_error = response.error();
+        stream.m_failed += response.value();
+    }
+    stream.m_data.clear();
+    // the provider forgets the streams that are no longer used, so
+    // the next operations go into a new one
+    stream.m_stream_id = UUID::generate();
+    stream.m_posted    = 0;
+}
+
+/**
+ * @brief Posts an operation to the sequencer: sends it without waiting
+ * for a response, numbered after the previous operations of the stream,
+ * followed by the size, checksum and bulk handle of a copy of its data.
+ * If the window of outstanding operations is full, or if the handle now
+ * points to another provider than the stream, the operations posted so
+ * far are drained first, which starts a new stream.
+ */
+template<typename ... Args>
+static void post(SequencerHandleImpl& impl,
+                 const tl::remote_procedure& rpc,
+                 const char* data,
+                 size_t size,
+                 const Args& ... args) {
+    auto& client = *impl.m_client;
+    auto stream = client.postedStream(impl.m_sequencer_id, true);
+    std::lock_guard<tl::mutex> lock(stream->m_mtx);
+    CallOptions options(impl);
+    auto ph = impl.providerHandle();
+    auto address = static_cast<std::string>(ph);
+    bool moved = address != stream->m_address || ph.provider_id() != stream->m_ph.provider_id();
+    if(moved || stream->m_posted >= client.m_posted_window)
+        drainPosted(impl, *stream, options);
+    if(moved) {
+        // draining started a new stream
+        stream->m_ph      = ph;
+        stream->m_address = address;
+    }
+    // the provider pulls the data when the operation's turn comes,
+    // possibly after this call returned, so it pulls it from a copy
+    stream->m_data.emplace_back();
+    auto& copy = stream->m_data.back();
+    copy.m_buffer.assign(data, data + size);
+    if(size != 0) {
+        copy.m_bulk = client.m_engine.expose(
+            {{copy.m_buffer.data(), size}}, tl::bulk_mode::read_only);
+    }
+    // posted operations have no deadline: the provider never drops them
+    auto ctx = makeContext(client, options, std::chrono::milliseconds(0));
+    stream->m_posted += 1;
+    try {
+        rpc.on(ph)(impl.m_sequencer_id, ctx, stream->m_stream_id, stream->m_posted, args...,
+                   size, crc32c(data, size), copy.m_bulk);
+    } catch(...) {
+        // not sent, so the provider must not wait for it
+        stream->m_posted -= 1;
+        stream->m_data.pop_back();
+        throw;
+    }
+}
+
 SequencerHandle::SequencerHandle() = default;
 
 SequencerHandle::SequencerHandle(const std::shared_ptr<SequencerHandleImpl>& impl)
@@ -35,6 +440,52 @@ SequencerHandle::operator bool() const {
     return static_cast<bool>(self);
 }
 
+/**
+ * @brief Creates a new SequencerHandleImpl with the same settings as impl.
+ */
+static std::shared_ptr<SequencerHandleImpl> copyImpl(const SequencerHandleImpl& impl) {
+    auto copy = std::make_shared<SequencerHandleImpl>(
+        impl.m_client, impl.providerHandle(), impl.m_sequencer_id);
+    copy->m_timeout  = impl.m_timeout;
+    copy->m_replicas = impl.m_replicas;
+    copy->m_priority = impl.m_priority;
+    copy->m_posting  = impl.m_posting;
+    return copy;
+}
+
+SequencerHandle SequencerHandle::withTimeout(std::chrono::milliseconds timeout) const {
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto impl = copyImpl(*self);
+    impl->m_timeout = timeout;
+    return SequencerHandle(impl);
+}
+
+SequencerHandle SequencerHandle::withReplicas(
+        const std::vector<std::pair<std::string, uint16_t>>& replicas) const {
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto impl = copyImpl(*self);
+    impl->m_replicas.clear();
+    for(auto& replica : replicas) {
+        impl->m_replicas.emplace_back(
+            self->m_client->m_engine.lookup(replica.first), replica.second);
+    }
+    return SequencerHandle(impl);
+}
+
+SequencerHandle SequencerHandle::withPriority(Priority priority) const {
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto impl = copyImpl(*self);
+    impl->m_priority = priority;
+    return SequencerHandle(impl);
+}
+
+SequencerHandle SequencerHandle::withPosting() const {
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto impl = copyImpl(*self);
+    impl->m_posting = true;
+    return SequencerHandle(impl);
+}
+
 Client SequencerHandle::client() const {
     return Client(self->m_client);
 }
@@ -42,9 +493,8 @@ Client SequencerHandle::client() const {
 void SequencerHandle::sayHello() const {
     if(not self) throw Exception("Invalid mobject::SequencerHandle object");
     auto& rpc = self->m_client->m_say_hello;
-    auto& ph  = self->m_ph;
     auto& sequencer_id = self->m_sequencer_id;
-    rpc.on(ph)(sequencer_id);
+    rpc.on(self->providerHandle())(sequencer_id);
 }
 
 void SequencerHandle::computeSum(
@@ -54,23 +504,23 @@ void SequencerHandle::computeSum(
 {
     if(not self) throw Exception("Invalid mobject::SequencerHandle object");
     auto& rpc = self->m_client->m_compute_sum;
-    auto& ph  = self->m_ph;
     auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
     if(req == nullptr) { // synchronous call
-        RequestResult<int32_t> response = rpc.on(ph)(sequencer_id, x, y);
+        RequestResult<int32_t> response = call<RequestResult<int32_t>>(*self, rpc, options, sequencer_id, x, y);
         if(response.success()) {
             if(result) *result = response.value();
         } else {
             throw Exception(response.error());
         }
     } else { // asynchronous call
-        auto async_response = rpc.on(ph).async(sequencer_id, x, y);
+        auto async_response = callAsync(*self, rpc, options, sequencer_id, x, y);
         auto async_request_impl =
             std::make_shared<AsyncRequestImpl>(std::move(async_response));
         async_request_impl->m_wait_callback =
-            [result](AsyncRequestImpl& async_request_impl) {
-                RequestResult<int32_t> response =
-                    async_request_impl.m_async_response.wait();
+            [result, impl=self, x, y, options](AsyncRequestImpl& async_request_impl) mutable {
+                RequestResult<int32_t> response = waitResponse<RequestResult<int32_t>>(async_request_impl, *impl,
+                    impl->m_client->m_compute_sum, options, impl->m_sequencer_id, x, y);
                     if(response.success()) {
                         if(result) *result = response.value();
                     } else {
@@ -81,4 +531,370 @@ void SequencerHandle::computeSum(
     }
 }
 
+void SequencerHandle::computeSumArray(
+        const int32_t* x, const int32_t* y,
+        int32_t* result, size_t count,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto& rpc = self->m_client->m_compute_sum_array;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    // the provider pulls x and y and pushes the result into the same bulk handle
+    tl::bulk bulk;
+    if(count != 0) {
+        size_t size = count*sizeof(int32_t);
+        bulk = self->m_client->m_engine.expose(
+            {{const_cast<int32_t*>(x), size},
+             {const_cast<int32_t*>(y), size},
+             {result, size}}, tl::bulk_mode::read_write);
+    }
+    if(req == nullptr) { // synchronous call
+        RequestResult<bool> response = call<RequestResult<bool>>(*self, rpc, options, sequencer_id, count, bulk);
+        if(not response.success()) {
+            throw Exception(response.error());
+        }
+    } else { // asynchronous call
+        auto async_response = callAsync(*self, rpc, options, sequencer_id, count, bulk);
+        auto async_request_impl =
+            std::make_shared<AsyncRequestImpl>(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [bulk, impl=self, count, options](AsyncRequestImpl& async_request_impl) mutable { // bulk kept alive until completion
+                RequestResult<bool> response = waitResponse<RequestResult<bool>>(async_request_impl, *impl,
+                    impl->m_client->m_compute_sum_array, options, impl->m_sequencer_id, count, bulk);
+                if(not response.success()) {
+                    throw Exception(response.error());
+                }
+            };
+        *req = AsyncRequest(std::move(async_request_impl));
+    }
+}
+
+void SequencerHandle::write(
+        const std::string& object,
+        uint64_t offset,
+        const char* data,
+        size_t size,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    if(self->m_posting) {
+        if(req) throw Exception("Posted writes cannot be waited on, use flush()");
+        post(*self, self->m_client->m_posted_write, data, size, object, offset);
+        return;
+    }
+    auto& rpc = self->m_client->m_write;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    tl::bulk bulk;
+    if(size != 0) {
+        bulk = self->m_client->m_engine.expose(
+            {{const_cast<char*>(data), size}}, tl::bulk_mode::read_only);
+    }
+    uint32_t checksum = crc32c(data, size);
+    if(req == nullptr) { // synchronous call
+        RequestResult<bool> response = call<RequestResult<bool>>(*self, rpc, options, sequencer_id, object, offset, size, checksum, bulk);
+        if(not response.success()) {
+            throw Exception(response.error());
+        }
+    } else { // asynchronous call
+        auto async_response = callAsync(*self, rpc, options, sequencer_id, object, offset, size, checksum, bulk);
+        auto async_request_impl =
+            std::make_shared<AsyncRequestImpl>(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [bulk, impl=self, object, offset, size, checksum, options](AsyncRequestImpl& async_request_impl) mutable { // bulk kept alive until completion
+                RequestResult<bool> response = waitResponse<RequestResult<bool>>(async_request_impl, *impl,
+                    impl->m_client->m_write, options, impl->m_sequencer_id, object, offset, size, checksum, bulk);
+                    if(not response.success()) {
+                        throw Exception(response.error());
+                    }
+            };
+        *req = AsyncRequest(std::move(async_request_impl));
+    }
+}
+
+void SequencerHandle::append(
+        const std::string& object,
+        const char* data,
+        size_t size,
+        uint64_t* offset,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    if(self->m_posting) {
+        if(offset || req) throw Exception("Posted appends cannot be waited on, use flush()");
+        post(*self, self->m_client->m_posted_append, data, size, object);
+        return;
+    }
+    auto& rpc = self->m_client->m_append;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    tl::bulk bulk;
+    if(size != 0) {
+        bulk = self->m_client->m_engine.expose(
+            {{const_cast<char*>(data), size}}, tl::bulk_mode::read_only);
+    }
+    uint32_t checksum = crc32c(data, size);
+    auto& client_id = self->m_client->m_client_id;
+    uint64_t request_seq = self->m_client->nextRequestSeq();
+    if(req == nullptr) { // synchronous call
+        RequestResult<uint64_t> response = call<RequestResult<uint64_t>>(*self, rpc, options, sequencer_id, client_id, request_seq, object, size, checksum, bulk);
+        if(not response.success()) {
+            throw Exception(response.error());
+        }
+        if(offset) *offset = response.value();
+    } else { // asynchronous call
+        auto async_response = callAsync(*self, rpc, options, sequencer_id, client_id, request_seq, object, size, checksum, bulk);
+        auto async_request_impl =
+            std::make_shared<AsyncRequestImpl>(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [bulk, offset, impl=self, request_seq, object, size, checksum, options](AsyncRequestImpl& async_request_impl) mutable { // bulk kept alive until completion
+                RequestResult<uint64_t> response = waitResponse<RequestResult<uint64_t>>(async_request_impl, *impl,
+                    impl->m_client->m_append, options, impl->m_sequencer_id, impl->m_client->m_client_id,
+                    request_seq, object, size, checksum, bulk);
+                if(not response.success()) {
+                    throw Exception(response.error());
+                }
+                if(offset) *offset = response.value();
+            };
+        *req = AsyncRequest(std::move(async_request_impl));
+    }
+}
+
+void SequencerHandle::read(
+        const std::string& object,
+        uint64_t offset,
+        char* data,
+        size_t size,
+        size_t* bytes_read,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto& rpc = self->m_client->m_read;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    // blocking reads are hedged if the client enables it and the
+    // handle knows replicas of the sequencer
+    bool hedged = req == nullptr
+               && self->m_client->m_hedge_percentile > 0
+               && not self->m_replicas.empty();
+    tl::bulk bulk;
+    if(size != 0 && not hedged) {
+        bulk = self->m_client->m_engine.expose(
+            {{data, size}}, tl::bulk_mode::write_only);
+    }
+    // the response contains the number of bytes read and their checksum
+    auto check_response = [data, bytes_read, object](
+            const RequestResult<std::pair<size_t, uint32_t>>& response) {
+        if(not response.success())
+            throw Exception(response.error());
+        if(crc32c(data, response.value().first) != response.value().second)
+            throw Exception("Checksum mismatch in data read from object " + object);
+        if(bytes_read) *bytes_read = response.value().first;
+    };
+    if(req == nullptr) { // synchronous call
+        RequestResult<std::pair<size_t, uint32_t>> response = hedged
+            ? hedgedRead(self, options, object, offset, data, size)
+            : call<RequestResult<std::pair<size_t, uint32_t>>>(*self, rpc, options, sequencer_id, object, offset, size, bulk);
+        check_response(response);
+    } else { // asynchronous call
+        auto async_response = callAsync(*self, rpc, options, sequencer_id, object, offset, size, bulk);
+        auto async_request_impl =
+            std::make_shared<AsyncRequestImpl>(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [bulk, check_response, impl=self, object, offset, size, options](AsyncRequestImpl& async_request_impl) mutable { // bulk kept alive until completion
+                RequestResult<std::pair<size_t, uint32_t>> response = waitResponse<RequestResult<std::pair<size_t, uint32_t>>>(async_request_impl, *impl,
+                    impl->m_client->m_read, options, impl->m_sequencer_id, object, offset, size, bulk);
+                check_response(response);
+            };
+        *req = AsyncRequest(std::move(async_request_impl));
+    }
+}
+
+void SequencerHandle::remove(const std::string& object) const {
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto& rpc = self->m_client->m_remove;
+    auto& sequencer_id = self->m_sequencer_id;
+    // a retry of a removal that succeeded would fail
+    CallOptions options(*self, false);
+    RequestResult<bool> response = call<RequestResult<bool>>(*self, rpc, options, sequencer_id, object);
+    if(not response.success()) {
+        throw Exception(response.error());
+    }
+}
+
+void SequencerHandle::flush() const {
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto& rpc = self->m_client->m_flush;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    // operations posted before the flush are applied before the sequencer is flushed
+    std::string posted_error;
+    auto stream = self->m_client->postedStream(sequencer_id, false);
+    if(stream) {
+        std::lock_guard<tl::mutex> lock(stream->m_mtx);
+        drainPosted(*self, *stream, options);
+        if(stream->m_failed != 0) {
+            posted_error = std::to_string(stream->m_failed)
+                         + " posted operation(s) failed, first error: " + stream->m_first_error;
+            stream->m_failed = 0;
+            stream->m_first_error.clear();
+        }
+    }
+    RequestResult<bool> response = call<RequestResult<bool>>(*self, rpc, options, sequencer_id);
+    if(not response.success()) {
+        if(not posted_error.empty()) posted_error += "; ";
+        throw Exception(posted_error + response.error());
+    }
+    if(not posted_error.empty()) {
+        throw Exception(posted_error);
+    }
+}
+
+std::vector<std::string> SequencerHandle::listObjects(
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) const
+{
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto& rpc = self->m_client->m_list_objects;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    // names are received packed in a single buffer, each followed by a '\0';
+    // if they do not all fit, the remaining ones are fetched with further RPCs
+    std::vector<char> buffer(std::min<size_t>(std::max<size_t>(max*64, 4096), 1024*1024));
+    auto bulk = self->m_client->m_engine.expose(
+        {{buffer.data(), buffer.size()}}, tl::bulk_mode::write_only);
+    std::vector<std::string> names;
+    std::string after = start_after;
+    while(names.size() < max) {
+        RequestResult<std::pair<size_t, bool>> response =
+            call<RequestResult<std::pair<size_t, bool>>>(*self, rpc, options, sequencer_id, prefix, after, max - names.size(), bulk);
+        if(not response.success()) {
+            throw Exception(response.error());
+        }
+        const char* p = buffer.data();
+        for(size_t i = 0; i < response.value().first; i++) {
+            names.emplace_back(p);
+            p += names.back().size() + 1;
+        }
+        if(not response.value().second || names.empty()) break;
+        after = names.back();
+    }
+    return names;
+}
+
+void SequencerHandle::omapSet(
+        const std::string& object,
+        const std::vector<std::pair<std::string, std::string>>& entries) const
+{
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto& rpc = self->m_client->m_omap_set;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    RequestResult<bool> response = call<RequestResult<bool>>(*self, rpc, options, sequencer_id, object, entries);
+    if(not response.success()) {
+        throw Exception(response.error());
+    }
+}
+
+std::vector<std::pair<std::string, std::string>> SequencerHandle::omapGet(
+        const std::string& object,
+        const std::vector<std::string>& keys) const
+{
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto& rpc = self->m_client->m_omap_get;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    RequestResult<std::vector<std::pair<std::string, std::string>>> response = call<RequestResult<std::vector<std::pair<std::string, std::string>>>>(*self, rpc, options, sequencer_id, object, keys);
+    if(not response.success()) {
+        throw Exception(response.error());
+    }
+    return std::move(response.value());
+}
+
+void SequencerHandle::omapRemove(
+        const std::string& object,
+        const std::vector<std::string>& keys) const
+{
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto& rpc = self->m_client->m_omap_remove;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    RequestResult<bool> response = call<RequestResult<bool>>(*self, rpc, options, sequencer_id, object, keys);
+    if(not response.success()) {
+        throw Exception(response.error());
+    }
+}
+
+std::vector<std::pair<std::string, std::string>> SequencerHandle::omapScan(
+        const std::string& object,
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) const
+{
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto& rpc = self->m_client->m_omap_scan;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    RequestResult<std::vector<std::pair<std::string, std::string>>> response =
+        call<RequestResult<std::vector<std::pair<std::string, std::string>>>>(*self, rpc, options, sequencer_id, object, prefix, start_after, max);
+    if(not response.success()) {
+        throw Exception(response.error());
+    }
+    return std::move(response.value());
+}
+
+uint64_t SequencerHandle::execute(
+        const std::string& object,
+        const WriteOp& op) const
+{
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto& rpc = self->m_client->m_execute;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    uint32_t checksum = 0;
+    for(auto& step : op.steps())
+        if(step.type == WriteOp::WRITE)
+            checksum = crc32c(step.data.data(), step.data.size(), checksum);
+    auto& client_id = self->m_client->m_client_id;
+    uint64_t request_seq = self->m_client->nextRequestSeq();
+    RequestResult<uint64_t> response = call<RequestResult<uint64_t>>(*self, rpc, options, sequencer_id, client_id, request_seq, object, op, checksum);
+    if(not response.success()) {
+        throw Exception(response.error());
+    }
+    return response.value();
+}
+
+std::vector<std::pair<std::string, uint64_t>> SequencerHandle::watch(
+        const std::vector<std::pair<std::string, uint64_t>>& objects,
+        uint32_t timeout_ms) const
+{
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto& rpc = self->m_client->m_watch;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    options.allowWait(std::chrono::milliseconds(timeout_ms));
+    RequestResult<std::vector<std::pair<std::string, uint64_t>>> response =
+        call<RequestResult<std::vector<std::pair<std::string, uint64_t>>>>(*self, rpc, options, sequencer_id, objects, timeout_ms);
+    if(not response.success()) {
+        throw Exception(response.error());
+    }
+    return std::move(response.value());
+}
+
+uint64_t SequencerHandle::timestamps(size_t count) const {
+    if(not self) throw Exception("Invalid mobject::SequencerHandle object");
+    auto& rpc = self->m_client->m_timestamps;
+    auto& sequencer_id = self->m_sequencer_id;
+    CallOptions options(*self);
+    auto& client_id = self->m_client->m_client_id;
+    uint64_t request_seq = self->m_client->nextRequestSeq();
+    RequestResult<uint64_t> response = call<RequestResult<uint64_t>>(*self, rpc, options, sequencer_id, client_id, request_seq, count);
+    if(not response.success()) {
+        throw Exception(response.error());
+    }
+    return response.value();
+}
+
 }
@@ -7,6 +7,11 @@
 #define __MOBJECT_SEQUENCER_HANDLE_IMPL_H
 
 #include <mobject/UUID.hpp>
+#include <mobject/SequencerHandle.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <vector>
 
 namespace mobject {
 
@@ -14,12 +19,48 @@ class SequencerHandleImpl {
 
     public:
 
+    // number of times a request follows a migrated sequencer before giving up
+    static constexpr unsigned max_redirects = 8;
+
     UUID                        m_sequencer_id;
     std::shared_ptr<ClientImpl> m_client;
-    tl::provider_handle         m_ph;
+    tl::provider_handle         m_ph; // may change if the sequencer migrates
+    mutable tl::mutex           m_ph_mtx;
+    // deadline of the calls made through this handle, overriding the
+    // client's default if not negative (see SequencerHandle::withTimeout)
+    std::chrono::milliseconds   m_timeout = std::chrono::milliseconds(-1);
+    // providers holding replicas of the sequencer, to which slow
+    // reads are hedged (see SequencerHandle::withReplicas)
+    std::vector<tl::provider_handle> m_replicas;
+    // priority class of the requests (see SequencerHandle::withPriority)
+    Priority                    m_priority = Priority::NORMAL;
+    // whether writes and appends are posted (see SequencerHandle::withPosting)
+    bool                        m_posting = false;
 
     SequencerHandleImpl() = default;
-    
+
+    tl::provider_handle providerHandle() const {
+        std::lock_guard<tl::mutex> lock(m_ph_mtx);
+        return m_ph;
+    }
+
+    /**
+     * @brief Returns the deadline of the calls made through this handle
+     * (0 if they have none).
+     */
+    std::chrono::milliseconds timeout() const {
+        return m_timeout.count() >= 0 ? m_timeout : m_client->m_timeout;
+    }
+
+    /**
+     * @brief Points the handle to the provider a sequencer moved to.
+     */
+    void redirect(const std::string& address, uint16_t provider_id) {
+        auto ph = tl::provider_handle(m_client->m_engine.lookup(address), provider_id);
+        std::lock_guard<tl::mutex> lock(m_ph_mtx);
+        m_ph = std::move(ph);
+    }
+
     SequencerHandleImpl(const std::shared_ptr<ClientImpl>& client, 
                        tl::provider_handle&& ph,
                        const UUID& sequencer_id)
@@ -0,0 +1,237 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "mobject/StripedHandle.hpp"
+#include "mobject/Exception.hpp"
+
+#include "StripedHandleImpl.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <set>
+
+namespace mobject {
+
+using json = nlohmann::json;
+
+StripedHandle::StripedHandle() = default;
+
+StripedHandle::StripedHandle(const std::vector<SequencerHandle>& sequencers,
+                             const std::string& config) {
+    if(sequencers.empty())
+        throw Exception("StripedHandle requires at least one sequencer");
+    for(auto& s : sequencers)
+        if(not s) throw Exception("Invalid mobject::SequencerHandle passed to StripedHandle");
+    json cfg;
+    try {
+        cfg = json::parse(config.empty() ? "{}" : config);
+    } catch(json::parse_error& e) {
+        throw Exception(e.what());
+    }
+    if(not cfg.is_object())
+        throw Exception("StripedHandle configuration should be an object");
+    size_t stripe_unit   = cfg.value("stripe_unit", (size_t)1024*1024);
+    size_t stripe_width  = cfg.value("stripe_width", sequencers.size());
+    size_t max_in_flight = cfg.value("max_in_flight", (size_t)64);
+    if(stripe_unit == 0)
+        throw Exception("stripe_unit should be strictly positive");
+    if(stripe_width == 0 || stripe_width > sequencers.size())
+        throw Exception("stripe_width should be between 1 and the number of sequencers");
+    if(max_in_flight == 0)
+        throw Exception("max_in_flight should be strictly positive");
+    self = std::make_shared<StripedHandleImpl>(
+        sequencers, stripe_unit, stripe_width, max_in_flight);
+}
+
+StripedHandle::StripedHandle(const StripedHandle&) = default;
+
+StripedHandle::StripedHandle(StripedHandle&&) = default;
+
+StripedHandle& StripedHandle::operator=(const StripedHandle&) = default;
+
+StripedHandle& StripedHandle::operator=(StripedHandle&&) = default;
+
+StripedHandle::~StripedHandle() = default;
+
+StripedHandle::operator bool() const {
+    return static_cast<bool>(self);
+}
+
+std::string StripedHandle::getConfig() const {
+    if(not self) throw Exception("Invalid mobject::StripedHandle object");
+    json cfg = {
+        { "stripe_unit", self->m_stripe_unit },
+        { "stripe_width", self->m_stripe_width },
+        { "max_in_flight", self->m_max_in_flight }
+    };
+    return cfg.dump();
+}
+
+/**
+ * @brief Issues count asynchronous operations with at most window of
+ * them in flight, and waits for all of them. If errors is null and an
+ * operation fails, no further operation is issued, the ones in flight
+ * are waited for (so that no transfer is pending on the caller's buffer
+ * when this function returns), and the first error is rethrown. If
+ * errors is not null, all the operations are issued and the error of
+ * each of them is stored in (*errors)[i].
+ */
+static void runInParallel(size_t count, size_t window,
+                          const std::function<void(size_t, AsyncRequest*)>& issue,
+                          std::vector<std::exception_ptr>* errors = nullptr) {
+    std::deque<std::pair<size_t, AsyncRequest>> in_flight;
+    std::exception_ptr error;
+    if(errors) errors->assign(count, nullptr);
+    auto fail = [&](size_t i, std::exception_ptr e) {
+        if(errors) (*errors)[i] = e;
+        else if(not error) error = e;
+    };
+    auto wait_one = [&]() {
+        try {
+            in_flight.front().second.wait();
+        } catch(...) {
+            fail(in_flight.front().first, std::current_exception());
+        }
+        in_flight.pop_front();
+    };
+    for(size_t i = 0; i < count && not error; i++) {
+        if(in_flight.size() >= window) wait_one();
+        if(error) break;
+        AsyncRequest req;
+        try {
+            issue(i, &req);
+        } catch(...) {
+            fail(i, std::current_exception());
+            continue;
+        }
+        in_flight.emplace_back(i, std::move(req));
+    }
+    while(not in_flight.empty()) wait_one();
+    if(error) std::rethrow_exception(error);
+}
+
+/**
+ * @brief Checks whether a sequencer holds a part of an object. Used
+ * after an operation on the part failed, to tell an error from a part
+ * that was never written.
+ */
+static bool holdsPart(const SequencerHandle& sequencer, const std::string& object) {
+    // the object itself is the first name starting with its own name
+    auto names = sequencer.listObjects(object, "", 1);
+    return not names.empty() && names[0] == object;
+}
+
+void StripedHandle::write(const std::string& object,
+                          uint64_t offset,
+                          const char* data,
+                          size_t size) const {
+    if(not self) throw Exception("Invalid mobject::StripedHandle object");
+    auto chunks = self->split(object, offset, size);
+    // only the sequencers holding the stripe units written to are
+    // involved; the others may not hold any part of the object
+    runInParallel(chunks.size(), self->m_max_in_flight,
+        [&](size_t i, AsyncRequest* req) {
+            auto& c = chunks[i];
+            self->m_sequencers[c.target].write(
+                object, c.sub_offset, data + (c.offset - offset), c.size, req);
+        });
+}
+
+void StripedHandle::read(const std::string& object,
+                         uint64_t offset,
+                         char* data,
+                         size_t size,
+                         size_t* bytes_read) const {
+    if(not self) throw Exception("Invalid mobject::StripedHandle object");
+    auto chunks = self->split(object, offset, size);
+    // in addition to the chunks, read one byte from each sequencer of the
+    // stripe at its first position past the end of the requested range:
+    // the object extends past the range if and only if one of them does
+    uint64_t end = offset + size;
+    size_t width = self->m_stripe_width;
+    for(size_t s = 0; s < width; s++) {
+        uint64_t stripe = end / self->m_stripe_unit;
+        uint64_t in_unit = end % self->m_stripe_unit;
+        if(stripe % width != s) {
+            stripe += (s + width - stripe % width) % width;
+            in_unit = 0;
+        }
+        StripedHandleImpl::Chunk probe;
+        probe.target = self->targetOf(object, s);
+        probe.sub_offset = (stripe / width) * self->m_stripe_unit + in_unit;
+        probe.offset = end;
+        probe.size = 1;
+        chunks.push_back(probe);
+    }
+    size_t num_chunks = chunks.size() - width;
+    std::vector<size_t> chunk_bytes(chunks.size(), 0);
+    std::vector<char> probe_bytes(width);
+    std::vector<std::exception_ptr> errors;
+    runInParallel(chunks.size(), self->m_max_in_flight,
+        [&](size_t i, AsyncRequest* req) {
+            auto& c = chunks[i];
+            char* buffer = i < num_chunks ? data + (c.offset - offset)
+                                          : &probe_bytes[i - num_chunks];
+            self->m_sequencers[c.target].read(
+                object, c.sub_offset, buffer, c.size, &chunk_bytes[i], req);
+        }, &errors);
+    // a sequencer that failed and does not hold any part of the object
+    // holds an empty part; the object must be held by at least one
+    std::exception_ptr first_error;
+    std::set<size_t> missing;
+    for(size_t i = 0; i < chunks.size(); i++) {
+        if(not errors[i]) continue;
+        if(not first_error) first_error = errors[i];
+        auto target = chunks[i].target;
+        if(missing.count(target)) continue;
+        if(holdsPart(self->m_sequencers[target], object))
+            std::rethrow_exception(errors[i]);
+        missing.insert(target);
+    }
+    if(missing.size() == width)
+        std::rethrow_exception(first_error);
+    // the object ends past the range if a probe read a byte, otherwise
+    // at the furthest byte read; short chunks before that point are
+    // holes and read as zeros
+    uint64_t obj_end = offset;
+    for(size_t i = num_chunks; i < chunks.size(); i++)
+        if(chunk_bytes[i] != 0) obj_end = end;
+    for(size_t i = 0; i < num_chunks; i++)
+        if(chunk_bytes[i] != 0)
+            obj_end = std::max<uint64_t>(obj_end, chunks[i].offset + chunk_bytes[i]);
+    for(size_t i = 0; i < num_chunks; i++) {
+        uint64_t hole_start = chunks[i].offset + chunk_bytes[i];
+        uint64_t hole_end   = std::min<uint64_t>(chunks[i].offset + chunks[i].size, obj_end);
+        if(hole_start < hole_end)
+            std::memset(data + (hole_start - offset), 0, hole_end - hole_start);
+    }
+    if(bytes_read) *bytes_read = obj_end - offset;
+}
+
+void StripedHandle::remove(const std::string& object) const {
+    if(not self) throw Exception("Invalid mobject::StripedHandle object");
+    std::exception_ptr error;
+    size_t missing = 0;
+    for(size_t s = 0; s < self->m_stripe_width; s++) {
+        auto& sequencer = self->m_sequencers[self->targetOf(object, s)];
+        try {
+            sequencer.remove(object);
+        } catch(...) {
+            if(not holdsPart(sequencer, object)) {
+                missing += 1;
+                if(missing < self->m_stripe_width) continue;
+            }
+            if(not error) error = std::current_exception();
+        }
+    }
+    if(error) std::rethrow_exception(error);
+}
+
+}
@@ -0,0 +1,74 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_STRIPED_HANDLE_IMPL_H
+#define __MOBJECT_STRIPED_HANDLE_IMPL_H
+
+#include <mobject/SequencerHandle.hpp>
+#include "Hash.hpp"
+
+#include <vector>
+
+namespace mobject {
+
+class StripedHandleImpl {
+
+    public:
+
+    /**
+     * @brief Part of an I/O that falls within a single stripe unit.
+     */
+    struct Chunk {
+        size_t   target;     // index of the sequencer
+        uint64_t sub_offset; // offset in the object stored on that sequencer
+        uint64_t offset;     // offset in the striped object
+        size_t   size;
+    };
+
+    std::vector<SequencerHandle> m_sequencers;
+    size_t                       m_stripe_unit = 1024*1024;
+    size_t                       m_stripe_width = 0;
+    size_t                       m_max_in_flight = 64;
+
+    StripedHandleImpl(const std::vector<SequencerHandle>& sequencers,
+                      size_t stripe_unit, size_t stripe_width, size_t max_in_flight)
+    : m_sequencers(sequencers)
+    , m_stripe_unit(stripe_unit)
+    , m_stripe_width(stripe_width)
+    , m_max_in_flight(max_in_flight) {}
+
+    /**
+     * @brief Index of the sequencer holding the given stripe of an object.
+     */
+    size_t targetOf(const std::string& object, uint64_t stripe) const {
+        size_t first = hash64(object) % m_sequencers.size();
+        return (first + stripe % m_stripe_width) % m_sequencers.size();
+    }
+
+    /**
+     * @brief Splits [offset, offset+size) of an object into chunks.
+     */
+    std::vector<Chunk> split(const std::string& object, uint64_t offset, size_t size) const {
+        std::vector<Chunk> chunks;
+        uint64_t end = offset + size;
+        while(offset < end) {
+            uint64_t stripe = offset / m_stripe_unit;
+            uint64_t in_unit = offset % m_stripe_unit;
+            size_t n = std::min<uint64_t>(m_stripe_unit - in_unit, end - offset);
+            Chunk chunk;
+            chunk.target = targetOf(object, stripe);
+            chunk.sub_offset = (stripe / m_stripe_width) * m_stripe_unit + in_unit;
+            chunk.offset = offset;
+            chunk.size = n;
+            chunks.push_back(chunk);
+            offset += n;
+        }
+        return chunks;
+    }
+};
+
+}
+
+#endif
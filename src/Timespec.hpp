@@ -0,0 +1,41 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_TIMESPEC_HPP
+#define __MOBJECT_TIMESPEC_HPP
+
+#include <chrono>
+#include <time.h>
+
+namespace mobject {
+
+/**
+ * @brief Returns the absolute time, in the CLOCK_REALTIME clock that
+ * thallium's condition_variable::wait_until() expects, that is the given
+ * duration from now. Negative durations count as 0.
+ */
+template<typename Rep, typename Period>
+inline struct timespec timespecIn(std::chrono::duration<Rep, Period> wait) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+    if(ns < 0) ns = 0;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ns += ts.tv_nsec;
+    ts.tv_sec += ns / 1000000000;
+    ts.tv_nsec = ns % 1000000000;
+    return ts;
+}
+
+/**
+ * @brief Same as timespecIn(t - now()), for a time point of any clock.
+ */
+template<typename Clock, typename Duration>
+inline struct timespec timespecAt(std::chrono::time_point<Clock, Duration> t) {
+    return timespecIn(t - Clock::now());
+}
+
+}
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "TimestampOracle.hpp"
+#include "mobject/Exception.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace mobject {
+
+using namespace std::string_literals;
+
+const std::string TimestampOracle::object_name = "__timestamp_oracle__";
+
+// number of compare-and-set attempts before giving up on raising the bound
+static constexpr unsigned max_raise_attempts = 8;
+
+TimestampOracle::TimestampOracle(unsigned logical_bits, std::chrono::milliseconds window,
+                                 size_t max_count)
+: m_logical_bits(logical_bits)
+, m_window(window)
+, m_max_count(max_count) {}
+
+std::unique_ptr<TimestampOracle> TimestampOracle::fromConfig(const json& config) {
+    if(not config.is_object())
+        throw Exception("\"timestamps\" entry in sequencer configuration should be an object");
+    unsigned logical_bits = config.value("logical_bits", 18u);
+    int64_t window_ms     = config.value("window_ms", (int64_t)3000);
+    int64_t max_count     = config.value("max_count", (int64_t)1048576);
+    if(logical_bits > 22)
+        throw Exception("\"timestamps.logical_bits\" should be at most 22");
+    if(window_ms <= 0)
+        throw Exception("\"timestamps.window_ms\" should be strictly positive");
+    if(max_count <= 0)
+        throw Exception("\"timestamps.max_count\" should be strictly positive");
+    return std::unique_ptr<TimestampOracle>(
+        new TimestampOracle(logical_bits, std::chrono::milliseconds(window_ms), max_count));
+}
+
+uint64_t TimestampOracle::physicalNow() const {
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch());
+    return static_cast<uint64_t>(ms.count()) << m_logical_bits;
+}
+
+RequestResult<uint64_t> TimestampOracle::next(Backend& backend, size_t count) {
+    RequestResult<uint64_t> result;
+    if(count == 0 || count > m_max_count) {
+        result.success() = false;
+        result.error() = "Number of timestamps should be between 1 and "s + std::to_string(m_max_count);
+        return result;
+    }
+    std::unique_lock<thallium::mutex> lock(m_mtx);
+    while(true) {
+        uint64_t first = std::max(m_last + 1, physicalNow());
+        if(first > UINT64_MAX - count) {
+            result.success() = false;
+            result.error() = "Timestamps exhausted";
+            return result;
+        }
+        if(m_loaded && first + count <= m_limit) {
+            m_last = first + count - 1;
+            result.value() = first;
+            return result;
+        }
+        if(m_raising) {
+            // another thread is raising the bound; the new bound
+            // will most likely cover this request as well
+            m_cv.wait(lock);
+            continue;
+        }
+        m_raising = true;
+        uint64_t last     = std::max(m_last, m_limit);
+        bool     loaded   = m_loaded;
+        uint64_t version  = m_version;
+        uint64_t previous = 0, limit = 0;
+        lock.unlock();
+        auto raised = raise(backend, count, last, loaded, version, previous, limit);
+        lock.lock();
+        m_raising = false;
+        m_cv.notify_all();
+        if(not raised.success()) {
+            m_loaded = false;
+            result.success() = false;
+            result.error() = raised.error();
+            spdlog::error("[timestamps] Could not raise the bound: {}", raised.error());
+            return result;
+        }
+        // skip the timestamps below the previous bound, which may have
+        // been issued before a restart or by another instance
+        if(previous) m_last = std::max(m_last, previous - 1);
+        m_limit   = limit;
+        m_version = version;
+        m_loaded  = true;
+    }
+}
+
+RequestResult<bool> TimestampOracle::raise(Backend& backend, size_t count, uint64_t last,
+                                           bool loaded, uint64_t& version,
+                                           uint64_t& previous, uint64_t& limit) const {
+    RequestResult<bool> result;
+    previous = last;
+    for(unsigned attempt = 0; attempt < max_raise_attempts; attempt++) {
+        if(not loaded) {
+            // the version is read before the bound, so that a concurrent
+            // update of the bound makes the compare-and-set below fail
+            auto v = backend.execute(object_name, WriteOp());
+            version = v.success() ? v.value() : 0;
+            auto values = backend.omapGet(object_name, {"limit"});
+            previous = 0;
+            if(values.success() && not values.value().empty()) {
+                try {
+                    previous = std::stoull(values.value()[0].second);
+                } catch(const std::exception&) {
+                    result.success() = false;
+                    result.error() = "Invalid timestamp bound in object "s + object_name;
+                    return result;
+                }
+            }
+            previous = std::max(previous, last);
+            loaded = true;
+        }
+        uint64_t now = physicalNow();
+        uint64_t window = (uint64_t)m_window.count() << m_logical_bits;
+        if(previous >= UINT64_MAX - count || now >= UINT64_MAX - count || now > UINT64_MAX - window) {
+            result.success() = false;
+            result.error() = "Timestamps exhausted";
+            return result;
+        }
+        uint64_t base = std::max(previous + 1, now);
+        limit = std::max(base + count, now + window);
+        WriteOp op;
+        op.create().assertVersion(version).omapSet({{"limit", std::to_string(limit)}});
+        auto r = backend.execute(object_name, op);
+        if(r.success()) {
+            version = r.value();
+            return result;
+        }
+        result.error() = r.error();
+        loaded = false;
+    }
+    result.success() = false;
+    return result;
+}
+
+}
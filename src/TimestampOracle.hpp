@@ -0,0 +1,119 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_TIMESTAMP_ORACLE_HPP
+#define __MOBJECT_TIMESTAMP_ORACLE_HPP
+
+#include "mobject/Backend.hpp"
+
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace mobject {
+
+/**
+ * @brief The TimestampOracle issues strictly increasing 64-bit
+ * timestamps for a sequencer, as needed by transactions (e.g. the
+ * start and commit timestamps of Percolator). A timestamp is a hybrid
+ * logical clock: the physical time in milliseconds shifted left by
+ * "logical_bits", plus a logical counter incremented for each timestamp
+ * issued within the same millisecond. When more timestamps than the
+ * logical counter can hold are requested, the clock runs ahead of the
+ * physical time until the physical time catches up.
+ *
+ * To never issue a timestamp twice, even after a restart, the oracle
+ * only issues timestamps below an upper bound stored in the omap of
+ * an object of the sequencer (object_name). The bound is raised
+ * "window_ms" milliseconds ahead of the physical time whenever it is
+ * reached, with a compare-and-set on the object's version, so the
+ * backend is only written a few times per second. Requests that
+ * arrive while the bound is being raised wait for that single update
+ * and are then all served from memory. Since the bound is an object
+ * like any other, it follows the sequencer when it is migrated or
+ * replicated.
+ *
+ * The provider creates an oracle for the sequencers whose configuration
+ * contains a "timestamps" object, e.g.
+ * { "timestamps" : { "logical_bits" : 18, "window_ms" : 3000, "max_count" : 1048576 } }
+ * The provider hides object_name from listObjects and rejects the
+ * client requests modifying it.
+ */
+class TimestampOracle {
+
+    using json = nlohmann::json;
+
+    public:
+
+    /**
+     * @brief Name of the object holding the upper bound.
+     */
+    static const std::string object_name;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param logical_bits Number of low bits holding the logical counter.
+     * @param window Margin by which the bound is raised above the physical time.
+     * @param max_count Maximum number of timestamps issued by a single call.
+     */
+    TimestampOracle(unsigned logical_bits, std::chrono::milliseconds window, size_t max_count);
+
+    /**
+     * @brief Builds a TimestampOracle from the "timestamps" section
+     * of a sequencer's configuration. Throws an Exception if the
+     * configuration is invalid.
+     */
+    static std::unique_ptr<TimestampOracle> fromConfig(const json& config);
+
+    /**
+     * @brief Issues count consecutive timestamps, greater than all the
+     * timestamps previously issued by this sequencer. Fails if count is
+     * 0 or more than max_count.
+     *
+     * @param backend Backend of the sequencer, in which the bound is stored.
+     * @param count Number of timestamps to issue.
+     *
+     * @return a RequestResult containing the first timestamp.
+     */
+    RequestResult<uint64_t> next(Backend& backend, size_t count);
+
+    private:
+
+    unsigned                     m_logical_bits;
+    std::chrono::milliseconds    m_window;
+    size_t                       m_max_count;
+    thallium::mutex              m_mtx;
+    thallium::condition_variable m_cv;
+    bool                         m_loaded = false;  // m_limit and m_version were read from the backend
+    bool                         m_raising = false; // a thread is raising the bound
+    uint64_t                     m_last = 0;        // last timestamp issued
+    uint64_t                     m_limit = 0;       // timestamps must be strictly below this bound
+    uint64_t                     m_version = 0;     // version of the object holding the bound
+
+    /**
+     * @brief Returns the current physical time as a timestamp
+     * (i.e. with a logical counter of 0).
+     */
+    uint64_t physicalNow() const;
+
+    /**
+     * @brief Raises the bound stored in the backend so that count
+     * timestamps following last can be issued. version is the
+     * version of the object holding the bound, if known (loaded).
+     * On success, sets limit to the new bound, previous to the bound
+     * that was stored, and version to the new version of the object.
+     */
+    RequestResult<bool> raise(Backend& backend, size_t count, uint64_t last,
+                              bool loaded, uint64_t& version,
+                              uint64_t& previous, uint64_t& limit) const;
+};
+
+}
+
+#endif
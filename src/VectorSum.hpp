@@ -0,0 +1,134 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_VECTOR_SUM_H
+#define __MOBJECT_VECTOR_SUM_H
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace mobject {
+
+/**
+ * Element-wise addition of int32 arrays with overflow detection, used
+ * by Backend::computeSumArray. The implementation uses AVX-512 or AVX2
+ * on x86-64 when the CPU supports them (detected once, at runtime), and
+ * NEON on aarch64, where it is always available, and falls back to a
+ * portable loop otherwise. A sum overflows when both operands have the
+ * same sign and the (wrapped) sum has the other sign, i.e. when the
+ * sign bit of (x ^ s) & (y ^ s) is set; the vector kernels test this
+ * for a whole vector at once and only locate the overflowing element
+ * when there is one.
+ */
+namespace vectorsum {
+
+/**
+ * @brief Adds x[i] and y[i] into z[i] for i in [start, n), and returns
+ * the index of the first sum that overflows, or n if none does.
+ */
+inline size_t scalar(const int32_t* x, const int32_t* y, int32_t* z, size_t start, size_t n) {
+    for(size_t i = start; i < n; i++) {
+        if(__builtin_add_overflow(x[i], y[i], &z[i])) return i;
+    }
+    return n;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2")))
+inline size_t avx2(const int32_t* x, const int32_t* y, int32_t* z, size_t n) {
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+        __m256i s = _mm256_add_epi32(a, b);
+        __m256i o = _mm256_and_si256(_mm256_xor_si256(a, s), _mm256_xor_si256(b, s));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(z + i), s);
+        if(_mm256_movemask_ps(_mm256_castsi256_ps(o)) != 0)
+            return scalar(x, y, z, i, i + 8);
+    }
+    return scalar(x, y, z, i, n);
+}
+
+__attribute__((target("avx512f")))
+inline size_t avx512(const int32_t* x, const int32_t* y, int32_t* z, size_t n) {
+    size_t i = 0;
+    const __m512i zero = _mm512_setzero_si512();
+    for(; i + 16 <= n; i += 16) {
+        __m512i a = _mm512_loadu_si512(x + i);
+        __m512i b = _mm512_loadu_si512(y + i);
+        __m512i s = _mm512_add_epi32(a, b);
+        __m512i o = _mm512_and_si512(_mm512_xor_si512(a, s), _mm512_xor_si512(b, s));
+        _mm512_storeu_si512(z + i, s);
+        if(_mm512_cmplt_epi32_mask(o, zero) != 0)
+            return scalar(x, y, z, i, i + 16);
+    }
+    return scalar(x, y, z, i, n);
+}
+
+#elif defined(__aarch64__)
+
+inline size_t neon(const int32_t* x, const int32_t* y, int32_t* z, size_t n) {
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        int32x4_t a = vld1q_s32(x + i);
+        int32x4_t b = vld1q_s32(y + i);
+        int32x4_t s = vaddq_s32(a, b);
+        int32x4_t o = vandq_s32(veorq_s32(a, s), veorq_s32(b, s));
+        vst1q_s32(z + i, s);
+        if(vmaxvq_u32(vshrq_n_u32(vreinterpretq_u32_s32(o), 31)) != 0)
+            return scalar(x, y, z, i, i + 4);
+    }
+    return scalar(x, y, z, i, n);
+}
+
+#endif
+
+inline size_t portable(const int32_t* x, const int32_t* y, int32_t* z, size_t n) {
+    return scalar(x, y, z, 0, n);
+}
+
+using sum_fn = size_t (*)(const int32_t*, const int32_t*, int32_t*, size_t);
+
+inline sum_fn select() {
+#if defined(__x86_64__)
+    static const sum_fn s_fn = __builtin_cpu_supports("avx512f") ? &avx512
+                             : __builtin_cpu_supports("avx2")    ? &avx2
+                             : &portable;
+#elif defined(__aarch64__)
+    static const sum_fn s_fn = &neon;
+#else
+    static const sum_fn s_fn = &portable;
+#endif
+    return s_fn;
+}
+
+}
+
+/**
+ * @brief Computes z[i] = x[i] + y[i] for i in [0, n). If a sum
+ * overflows, stops and returns its index (the elements of z from this
+ * index on are unspecified); returns n otherwise.
+ *
+ * @param x First array.
+ * @param y Second array.
+ * @param z Result array (may be x or y).
+ * @param n Number of elements.
+ *
+ * @return the index of the first overflow, or n.
+ */
+inline size_t addInt32(const int32_t* x, const int32_t* y, int32_t* z, size_t n) {
+    return vectorsum::select()(x, y, z, n);
+}
+
+}
+
+#endif
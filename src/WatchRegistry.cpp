@@ -0,0 +1,198 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "WatchRegistry.hpp"
+#include "Timespec.hpp"
+
+#include <thallium/serialization/stl/string.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+#include <thallium/serialization/stl/pair.hpp>
+
+#include <algorithm>
+
+namespace mobject {
+
+namespace tl = thallium;
+
+WatchRegistry::WatchRegistry(const tl::engine& engine,
+                             const tl::pool& pool,
+                             std::chrono::milliseconds coalesce,
+                             size_t max_objects,
+                             VersionFn changed)
+: m_engine(engine)
+, m_pool(pool)
+, m_coalesce(coalesce)
+, m_max_objects(max_objects)
+, m_changed(std::move(changed)) {
+    m_dispatcher = pool.make_thread([this]() { dispatch(); });
+}
+
+WatchRegistry::~WatchRegistry() {
+    {
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        m_stopping = true;
+        m_cv.notify_all();
+    }
+    m_dispatcher->join();
+    {
+        std::unique_lock<tl::mutex> lock(m_mtx);
+        while(m_responding != 0)
+            m_cv.wait(lock);
+    }
+    RequestResult<Versions> none;
+    for(auto& p : m_deadlines)
+        if(not p.second->done) p.second->req.respond(none);
+}
+
+void WatchRegistry::watch(const tl::request& req,
+                          const UUID& sequencer_id,
+                          Versions&& objects,
+                          std::chrono::milliseconds timeout) {
+    if(objects.size() > m_max_objects) {
+        RequestResult<Versions> result;
+        result.success() = false;
+        result.error() = "Watch request lists " + std::to_string(objects.size())
+                       + " objects, more than the maximum of " + std::to_string(m_max_objects);
+        req.respond(result);
+        return;
+    }
+    auto waiter = std::make_shared<Waiter>();
+    waiter->req = req;
+    waiter->sequencer_id = sequencer_id;
+    waiter->objects = std::move(objects);
+    waiter->deadline = clock::now() + timeout;
+    // the waiter is registered before the versions are checked,
+    // so that a modification in between is not missed
+    {
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        auto& index = m_index[sequencer_id];
+        for(auto& object : waiter->objects)
+            index[object.first].push_back(waiter);
+        m_deadlines.emplace(waiter->deadline, waiter);
+        m_cv.notify_all();
+    }
+    auto result = m_changed(sequencer_id, waiter->objects);
+    if(result.success() && result.value().empty()) return;
+    {
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        if(waiter->done) return;
+        waiter->done = true;
+        remove(waiter);
+    }
+    req.respond(result);
+}
+
+void WatchRegistry::trigger(std::vector<WaiterPtr>& waiters) {
+    for(auto& waiter : waiters) {
+        if(waiter->triggered || waiter->done) continue;
+        waiter->triggered = true;
+        m_triggered.push_back(waiter);
+    }
+    waiters.clear();
+}
+
+void WatchRegistry::notify(const UUID& sequencer_id, const std::string& object) {
+    std::lock_guard<tl::mutex> lock(m_mtx);
+    auto seq = m_index.find(sequencer_id);
+    if(seq == m_index.end()) return;
+    auto it = seq->second.find(object);
+    if(it == seq->second.end()) return;
+    trigger(it->second);
+    seq->second.erase(it);
+    if(seq->second.empty()) m_index.erase(seq);
+    m_cv.notify_all();
+}
+
+void WatchRegistry::notify(const UUID& sequencer_id) {
+    std::lock_guard<tl::mutex> lock(m_mtx);
+    auto seq = m_index.find(sequencer_id);
+    if(seq == m_index.end()) return;
+    for(auto& p : seq->second)
+        trigger(p.second);
+    m_index.erase(seq);
+    m_cv.notify_all();
+}
+
+void WatchRegistry::remove(const WaiterPtr& waiter) {
+    auto seq = m_index.find(waiter->sequencer_id);
+    if(seq != m_index.end()) {
+        for(auto& object : waiter->objects) {
+            auto it = seq->second.find(object.first);
+            if(it == seq->second.end()) continue;
+            auto& waiters = it->second;
+            waiters.erase(std::remove(waiters.begin(), waiters.end(), waiter), waiters.end());
+            if(waiters.empty()) seq->second.erase(it);
+        }
+        if(seq->second.empty()) m_index.erase(seq);
+    }
+    auto range = m_deadlines.equal_range(waiter->deadline);
+    for(auto it = range.first; it != range.second; ++it) {
+        if(it->second == waiter) {
+            m_deadlines.erase(it);
+            break;
+        }
+    }
+}
+
+void WatchRegistry::respond(const WaiterPtr& waiter) {
+    auto result = m_changed(waiter->sequencer_id, waiter->objects);
+    waiter->req.respond(result);
+    std::lock_guard<tl::mutex> lock(m_mtx);
+    m_responding -= 1;
+    m_cv.notify_all();
+}
+
+void WatchRegistry::dispatch() {
+    std::unique_lock<tl::mutex> lock(m_mtx);
+    while(not m_stopping) {
+        if(m_triggered.empty()) {
+            // sleep until the next deadline, waking up at least every second;
+            // the wait is in nanoseconds so that a deadline less than a
+            // millisecond away is not rounded down to no wait at all
+            std::chrono::nanoseconds wait = std::chrono::seconds(1);
+            if(not m_deadlines.empty()) {
+                auto until_deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        m_deadlines.begin()->first - clock::now());
+                wait = std::max(std::chrono::nanoseconds(0), std::min(wait, until_deadline));
+            }
+            auto ts = timespecIn(wait);
+            if(wait.count() > 0) m_cv.wait_until(lock, &ts);
+            if(m_stopping) break;
+        }
+        if(not m_triggered.empty() && m_coalesce.count() > 0) {
+            // let the burst of modifications that triggered the waiters finish
+            lock.unlock();
+            tl::thread::sleep(m_engine, m_coalesce.count());
+            lock.lock();
+        }
+        std::vector<WaiterPtr> triggered, expired;
+        for(auto& waiter : m_triggered) {
+            if(waiter->done) continue; // already answered by watch()
+            waiter->done = true;
+            remove(waiter);
+            triggered.push_back(waiter);
+        }
+        m_triggered.clear();
+        m_responding += triggered.size();
+        auto now = clock::now();
+        while(not m_deadlines.empty() && m_deadlines.begin()->first <= now) {
+            auto waiter = m_deadlines.begin()->second;
+            m_deadlines.erase(m_deadlines.begin());
+            if(waiter->done) continue;
+            waiter->done = true;
+            remove(waiter);
+            expired.push_back(waiter);
+        }
+        lock.unlock();
+        for(auto& waiter : triggered)
+            m_pool.make_thread([this, waiter]() { respond(waiter); }, tl::anonymous());
+        RequestResult<Versions> none;
+        for(auto& waiter : expired)
+            waiter->req.respond(none);
+        lock.lock();
+    }
+}
+
+}
@@ -0,0 +1,133 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_WATCH_REGISTRY_HPP
+#define __MOBJECT_WATCH_REGISTRY_HPP
+
+#include <mobject/RequestResult.hpp>
+#include <mobject/UUID.hpp>
+
+#include <thallium.hpp>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mobject {
+
+/**
+ * @brief The WatchRegistry holds the pending watch requests of a
+ * provider (long polls). A watch request lists objects with the version
+ * the client knows; it is answered as soon as one of them has a
+ * different version, or when its timeout expires, with the objects
+ * whose version changed.
+ *
+ * Pending requests are parked (their handler returns without responding)
+ * rather than blocking a thread each. Modifications only mark the
+ * requests watching the modified object; after a short coalescing
+ * window, a dispatcher thread hands each of them to its own ULT in the
+ * pool, which looks up the versions and answers it, so a burst of
+ * modifications of the same objects results in a single notification
+ * per watcher and watchers are answered in parallel.
+ */
+class WatchRegistry {
+
+    public:
+
+    using Versions  = std::vector<std::pair<std::string, uint64_t>>;
+    using VersionFn = std::function<RequestResult<Versions>(const UUID&, const Versions&)>;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param engine Thallium engine.
+     * @param pool Pool in which to run the dispatcher thread
+     * and the ULTs answering the triggered requests.
+     * @param coalesce Delay between a modification and the notification.
+     * @param max_objects Maximum number of objects in a watch request.
+     * @param changed Function returning, among a list of objects of a
+     * sequencer with their known versions, those whose current version
+     * (0 for a missing object) is different.
+     */
+    WatchRegistry(const thallium::engine& engine,
+                  const thallium::pool& pool,
+                  std::chrono::milliseconds coalesce,
+                  size_t max_objects,
+                  VersionFn changed);
+
+    /**
+     * @brief Destructor. Waits for the triggered requests being
+     * answered and answers the pending requests with no change.
+     */
+    ~WatchRegistry();
+
+    /**
+     * @brief Registers a watch request. The request is answered
+     * immediately if one of the objects already changed, or with an
+     * error if it lists more than max_objects objects.
+     */
+    void watch(const thallium::request& req,
+               const UUID& sequencer_id,
+               Versions&& objects,
+               std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Notifies the requests watching an object that it changed.
+     */
+    void notify(const UUID& sequencer_id, const std::string& object);
+
+    /**
+     * @brief Notifies all the requests watching objects of a sequencer
+     * (e.g. when it is destroyed or migrated).
+     */
+    void notify(const UUID& sequencer_id);
+
+    private:
+
+    using clock = std::chrono::steady_clock;
+
+    struct Waiter {
+        thallium::request req;
+        UUID              sequencer_id;
+        Versions          objects;
+        clock::time_point deadline;
+        bool              triggered = false;
+        bool              done = false;
+    };
+
+    using WaiterPtr = std::shared_ptr<Waiter>;
+
+    thallium::engine                 m_engine;
+    thallium::pool                   m_pool;
+    std::chrono::milliseconds        m_coalesce;
+    size_t                           m_max_objects;
+    VersionFn                        m_changed;
+    // waiters indexed by sequencer and object
+    std::unordered_map<UUID, std::unordered_map<std::string, std::vector<WaiterPtr>>> m_index;
+    std::multimap<clock::time_point, WaiterPtr> m_deadlines;
+    std::vector<WaiterPtr>           m_triggered;
+    bool                             m_stopping = false;
+    size_t                           m_responding = 0; // ULTs answering triggered requests
+    thallium::mutex                  m_mtx;
+    thallium::condition_variable     m_cv;
+    thallium::managed<thallium::thread> m_dispatcher;
+
+    void trigger(std::vector<WaiterPtr>& waiters);
+
+    void remove(const WaiterPtr& waiter);
+
+    void respond(const WaiterPtr& waiter);
+
+    void dispatch();
+};
+
+}
+
+#endif
@@ -0,0 +1,452 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "WriteBackBackend.hpp"
+#include "Timespec.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace mobject {
+
+WriteBackBackend::WriteBackBackend(std::unique_ptr<Backend>&& backend,
+                                   const thallium::engine& engine,
+                                   const json& config)
+: m_backend(std::move(backend))
+, m_max_size(config.value("max_size", (size_t)4*1024*1024))
+, m_max_age(config.value("max_age_ms", (int64_t)1000))
+, m_alignment(config.value("alignment", (size_t)0)) {
+    // with a max_age of 0, every write is flushed right away
+    if(m_max_age.count() > 0)
+        m_flusher.reset(new thallium::managed<thallium::thread>(
+            engine.get_handler_pool().make_thread([this]() { runFlusher(); })));
+}
+
+WriteBackBackend::~WriteBackBackend() {
+    {
+        std::lock_guard<thallium::mutex> lock(m_mtx);
+        m_stop = true;
+        m_cv.notify_all();
+    }
+    if(m_flusher) (*m_flusher)->join();
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    auto result = flushAll();
+    if(not result.success())
+        spdlog::error("[write-back] Could not flush buffered data: {}", result.error());
+}
+
+void WriteBackBackend::sayHello() {
+    m_backend->sayHello();
+}
+
+RequestResult<int32_t> WriteBackBackend::computeSum(int32_t x, int32_t y) {
+    return m_backend->computeSum(x, y);
+}
+
+RequestResult<bool> WriteBackBackend::write(const std::string& object,
+                                            uint64_t offset,
+                                            const char* data,
+                                            size_t size) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    auto mark = m_reserved.find(object);
+    if(mark != m_reserved.end())
+        mark->second = std::max<uint64_t>(mark->second, offset + size);
+    if(size == 0 || size >= m_max_size) {
+        // large writes go directly to the underlying backend, after
+        // dropping the buffered data they overwrite
+        auto it = m_dirty.find(object);
+        if(it != m_dirty.end()) {
+            m_dirty_size -= trimExtents(it->second.extents, offset, size);
+            if(it->second.extents.empty()) m_dirty.erase(it);
+        }
+        return m_backend->write(object, offset, data, size);
+    }
+    auto& dirty = m_dirty[object];
+    if(dirty.extents.empty()) dirty.since = clock::now();
+    m_dirty_size += insertExtent(dirty.extents, offset, data, size);
+    if(not m_flusher || m_dirty_size > 2 * m_max_size)
+        // no flusher, or it is falling behind: the writer flushes
+        return flushIfNeeded();
+    if(m_dirty_size > m_max_size)
+        m_cv.notify_one();
+    return RequestResult<bool>();
+}
+
+RequestResult<size_t> WriteBackBackend::read(const std::string& object,
+                                             uint64_t offset,
+                                             char* data,
+                                             size_t size) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    auto it = m_dirty.find(object);
+    if(it == m_dirty.end()) return m_backend->read(object, offset, data, size);
+
+    auto result = readBackend(object, offset, data, size);
+    if(not result.success()) return result;
+    size_t backend_n = result.value();
+    size_t n = backend_n;
+
+    auto& extents = it->second.extents;
+    auto& last = *extents.rbegin();
+    uint64_t buffered_end = last.first + last.second.size();
+    if(buffered_end > offset)
+        n = std::max<size_t>(n, std::min<uint64_t>(size, buffered_end - offset));
+    if(n > backend_n)
+        std::memset(data + backend_n, 0, n - backend_n);
+
+    uint64_t end = offset + size;
+    auto e = extents.upper_bound(offset);
+    if(e != extents.begin()) {
+        auto p = std::prev(e);
+        if(p->first + p->second.size() > offset) e = p;
+    }
+    for(; e != extents.end() && e->first < end; ++e) {
+        uint64_t from = std::max(e->first, offset);
+        uint64_t to   = std::min<uint64_t>(e->first + e->second.size(), end);
+        std::memcpy(data + (from - offset), e->second.data() + (from - e->first), to - from);
+    }
+    result.value() = n;
+    return result;
+}
+
+RequestResult<bool> WriteBackBackend::remove(const std::string& object) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    m_reserved.erase(object);
+    bool buffered = false;
+    auto it = m_dirty.find(object);
+    if(it != m_dirty.end()) {
+        for(auto& e : it->second.extents) m_dirty_size -= e.second.size();
+        m_dirty.erase(it);
+        buffered = true;
+    }
+    auto result = m_backend->remove(object);
+    // the object may have existed only in the buffer
+    if(buffered) {
+        result.success() = true;
+        result.error().clear();
+    }
+    return result;
+}
+
+RequestResult<std::vector<std::string>> WriteBackBackend::listObjects(
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    auto result = m_backend->listObjects(prefix, start_after, max);
+    if(not result.success()) return result;
+    std::vector<std::string> buffered;
+    for(auto& p : m_dirty) {
+        auto& name = p.first;
+        if(name > start_after && name.compare(0, prefix.size(), prefix) == 0)
+            buffered.push_back(name);
+    }
+    if(buffered.empty()) return result;
+    std::sort(buffered.begin(), buffered.end());
+    std::vector<std::string> merged;
+    std::set_union(result.value().begin(), result.value().end(),
+                   buffered.begin(), buffered.end(),
+                   std::back_inserter(merged));
+    if(merged.size() > max) merged.resize(max);
+    result.value() = std::move(merged);
+    return result;
+}
+
+RequestResult<bool> WriteBackBackend::omapSet(
+        const std::string& object,
+        const std::vector<std::pair<std::string, std::string>>& entries) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    return m_backend->omapSet(object, entries);
+}
+
+RequestResult<std::vector<std::pair<std::string, std::string>>> WriteBackBackend::omapGet(
+        const std::string& object,
+        const std::vector<std::string>& keys) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    RequestResult<std::vector<std::pair<std::string, std::string>>> result;
+    auto r = flushObject(object);
+    if(not r.success()) {
+        result.success() = false;
+        result.error() = r.error();
+        return result;
+    }
+    return m_backend->omapGet(object, keys);
+}
+
+RequestResult<bool> WriteBackBackend::omapRemove(
+        const std::string& object,
+        const std::vector<std::string>& keys) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    auto result = flushObject(object);
+    if(not result.success()) return result;
+    return m_backend->omapRemove(object, keys);
+}
+
+RequestResult<std::vector<std::pair<std::string, std::string>>> WriteBackBackend::omapScan(
+        const std::string& object,
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    RequestResult<std::vector<std::pair<std::string, std::string>>> result;
+    auto r = flushObject(object);
+    if(not r.success()) {
+        result.success() = false;
+        result.error() = r.error();
+        return result;
+    }
+    return m_backend->omapScan(object, prefix, start_after, max);
+}
+
+RequestResult<uint64_t> WriteBackBackend::reserve(
+        const std::string& object,
+        size_t size) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    auto mark = m_reserved.find(object);
+    if(mark == m_reserved.end()) {
+        // an empty reservation returns the end known to the underlying
+        // backend (creating the object) without moving it
+        auto result = m_backend->reserve(object, 0);
+        if(not result.success()) return result;
+        uint64_t end = result.value();
+        auto it = m_dirty.find(object);
+        if(it != m_dirty.end() && not it->second.extents.empty()) {
+            auto& last = *it->second.extents.rbegin();
+            end = std::max<uint64_t>(end, last.first + last.second.size());
+        }
+        mark = m_reserved.emplace(object, end).first;
+    }
+    RequestResult<uint64_t> result;
+    result.value() = mark->second;
+    mark->second += size;
+    return result;
+}
+
+RequestResult<uint64_t> WriteBackBackend::execute(
+        const std::string& object,
+        const WriteOp& op) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    RequestResult<uint64_t> result;
+    auto r = flushObject(object);
+    if(not r.success()) {
+        result.success() = false;
+        result.error() = r.error();
+        return result;
+    }
+    result = m_backend->execute(object, op);
+    auto mark = m_reserved.find(object);
+    if(result.success() && mark != m_reserved.end()) {
+        // writes and truncations may extend the object past its mark,
+        // while a truncation below it leaves the mark where it is
+        for(auto& step : op.steps()) {
+            if(step.type == WriteOp::WRITE)
+                mark->second = std::max<uint64_t>(mark->second, step.offset + step.data.size());
+            else if(step.type == WriteOp::TRUNCATE)
+                mark->second = std::max<uint64_t>(mark->second, step.offset);
+        }
+    }
+    return result;
+}
+
+RequestResult<bool> WriteBackBackend::flush() {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    auto result = flushAll();
+    if(result.success())
+        result = m_backend->flush();
+    return result;
+}
+
+RequestResult<bool> WriteBackBackend::destroy() {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    m_dirty.clear();
+    m_dirty_size = 0;
+    m_reserved.clear();
+    return m_backend->destroy();
+}
+
+int64_t WriteBackBackend::insertExtent(std::map<uint64_t, std::string>& extents,
+                                       uint64_t offset, const char* data, size_t size) {
+    uint64_t end = offset + size;
+    int64_t before = 0;
+    std::map<uint64_t, std::string>::iterator cur;
+    auto it = extents.upper_bound(offset);
+    auto prev = it == extents.begin() ? extents.end() : std::prev(it);
+    if(prev != extents.end() && prev->first + prev->second.size() >= offset) {
+        // extend the preceding extent in place
+        cur = prev;
+        before += cur->second.size();
+        if(end - cur->first > cur->second.size())
+            cur->second.resize(end - cur->first);
+        std::memcpy(&cur->second[offset - cur->first], data, size);
+    } else {
+        cur = extents.emplace_hint(it, offset, std::string(data, size));
+    }
+    // absorb the following extents that overlap or touch the current one
+    uint64_t cur_end = cur->first + cur->second.size();
+    auto next = std::next(cur);
+    while(next != extents.end() && next->first <= cur_end) {
+        uint64_t next_end = next->first + next->second.size();
+        before += next->second.size();
+        if(next_end > cur_end) {
+            cur->second.append(next->second, cur_end - next->first, std::string::npos);
+            cur_end = next_end;
+        }
+        next = extents.erase(next);
+    }
+    return (int64_t)cur->second.size() - before;
+}
+
+size_t WriteBackBackend::trimExtents(std::map<uint64_t, std::string>& extents,
+                                     uint64_t offset, size_t size) {
+    uint64_t end = offset + size;
+    size_t removed = 0;
+    auto it = extents.upper_bound(offset);
+    if(it != extents.begin()) {
+        auto p = std::prev(it);
+        if(p->first + p->second.size() > offset) it = p;
+    }
+    while(it != extents.end() && it->first < end) {
+        uint64_t start = it->first;
+        uint64_t stop  = start + it->second.size();
+        std::string content = std::move(it->second);
+        it = extents.erase(it);
+        removed += content.size();
+        if(start < offset) {
+            extents.emplace(start, content.substr(0, offset - start));
+            removed -= offset - start;
+        }
+        if(stop > end) {
+            extents.emplace(end, content.substr(end - start));
+            removed -= stop - end;
+        }
+    }
+    return removed;
+}
+
+RequestResult<bool> WriteBackBackend::flushObject(const std::string& object, DirtyObject& dirty) {
+    RequestResult<bool> result;
+    auto align_down = [this](uint64_t x) {
+        return m_alignment ? x - x % m_alignment : x;
+    };
+    auto align_up = [this](uint64_t x) {
+        return m_alignment ? ((x + m_alignment - 1) / m_alignment) * m_alignment : x;
+    };
+    auto& extents = dirty.extents;
+    auto it = extents.begin();
+    while(it != extents.end()) {
+        // group the extents that touch once aligned into a single I/O
+        uint64_t start     = align_down(it->first);
+        uint64_t dirty_end = it->first + it->second.size();
+        uint64_t end       = align_up(dirty_end);
+        auto group_end = std::next(it);
+        while(group_end != extents.end() && align_down(group_end->first) <= end) {
+            dirty_end = group_end->first + group_end->second.size();
+            end = std::max(end, align_up(dirty_end));
+            ++group_end;
+        }
+        if(start == it->first && std::next(it) == group_end && end == dirty_end) {
+            result = m_backend->write(object, it->first, it->second.data(), it->second.size());
+        } else {
+            // fill the padding and gaps with the data already in the backend,
+            // without extending the object beyond its current or buffered size
+            std::string buffer(end - start, '\0');
+            auto r = readBackend(object, start, &buffer[0], buffer.size());
+            if(not r.success()) {
+                result.success() = false;
+                result.error() = r.error();
+                return result;
+            }
+            size_t n = r.value();
+            for(auto e = it; e != group_end; ++e)
+                std::memcpy(&buffer[e->first - start], e->second.data(), e->second.size());
+            size_t len = std::max<size_t>(n, dirty_end - start);
+            result = m_backend->write(object, start, buffer.data(), len);
+        }
+        if(not result.success()) return result;
+        for(auto e = it; e != group_end; ++e)
+            m_dirty_size -= e->second.size();
+        it = extents.erase(it, group_end);
+    }
+    return result;
+}
+
+RequestResult<size_t> WriteBackBackend::readBackend(const std::string& object,
+                                                    uint64_t offset,
+                                                    char* data,
+                                                    size_t size) {
+    auto result = m_backend->read(object, offset, data, size);
+    if(result.success()) return result;
+    // a buffered object may not exist in the underlying backend yet,
+    // in which case it reads as empty; any other error is reported
+    auto listed = m_backend->listObjects(object, "", 1);
+    if(listed.success() && (listed.value().empty() || listed.value()[0] != object)) {
+        result.success() = true;
+        result.error().clear();
+        result.value() = 0;
+    }
+    return result;
+}
+
+RequestResult<bool> WriteBackBackend::flushObject(const std::string& object) {
+    RequestResult<bool> result;
+    auto it = m_dirty.find(object);
+    if(it == m_dirty.end()) return result;
+    result = flushObject(it->first, it->second);
+    if(result.success()) m_dirty.erase(it);
+    return result;
+}
+
+RequestResult<bool> WriteBackBackend::flushIfNeeded() {
+    if(m_dirty_size > m_max_size)
+        return flushAll();
+    RequestResult<bool> result;
+    auto now = clock::now();
+    for(auto it = m_dirty.begin(); it != m_dirty.end();) {
+        if(now - it->second.since >= m_max_age) {
+            result = flushObject(it->first, it->second);
+            if(not result.success()) return result;
+            it = m_dirty.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return result;
+}
+
+void WriteBackBackend::runFlusher() {
+    std::unique_lock<thallium::mutex> lock(m_mtx);
+    while(not m_stop) {
+        auto now = clock::now();
+        auto next = now + m_max_age;
+        // woken up either when the oldest buffered write reaches max_age,
+        // or by a write that made the buffer exceed max_size
+        auto result = flushIfNeeded();
+        if(not result.success()) {
+            // retried after max_age rather than right away
+            spdlog::error("[write-back] Could not flush buffered data: {}", result.error());
+        } else {
+            for(auto& d : m_dirty)
+                next = std::min(next, d.second.since + m_max_age);
+        }
+        auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(next - now).count();
+        if(wait <= 0) continue;
+        auto ts = timespecIn(std::chrono::nanoseconds(wait));
+        m_cv.wait_until(lock, &ts);
+    }
+}
+
+RequestResult<bool> WriteBackBackend::flushAll() {
+    RequestResult<bool> result;
+    for(auto it = m_dirty.begin(); it != m_dirty.end();) {
+        result = flushObject(it->first, it->second);
+        if(not result.success()) return result;
+        it = m_dirty.erase(it);
+    }
+    return result;
+}
+
+}
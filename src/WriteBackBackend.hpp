@@ -0,0 +1,212 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_WRITE_BACK_BACKEND_HPP
+#define __MOBJECT_WRITE_BACK_BACKEND_HPP
+
+#include <mobject/Backend.hpp>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace mobject {
+
+/**
+ * @brief WriteBackBackend wraps another Backend and absorbs writes
+ * in memory. Adjacent and overlapping writes to the same object are
+ * merged into a single extent, and extents are written to the
+ * underlying backend as large I/Os when the amount of buffered data
+ * exceeds "max_size", when the oldest buffered write of an object is
+ * older than "max_age_ms" (checked by a background ULT, so that data
+ * buffered for an object that is no longer accessed is written too),
+ * or when flush() is called. If "alignment" is non-zero, flushed I/Os
+ * are extended to multiples of it, filling the padding with the data
+ * already present in the underlying backend. Reads are served from
+ * the underlying backend with the buffered data overlaid on top.
+ *
+ * The SequencerFactory wraps a backend in a WriteBackBackend when its
+ * configuration contains a "write_back" object, e.g.
+ * { "write_back" : { "max_size" : 4194304, "max_age_ms" : 500, "alignment" : 4096 } }
+ */
+class WriteBackBackend : public Backend {
+
+    using json = nlohmann::json;
+    using clock = std::chrono::steady_clock;
+
+    struct DirtyObject {
+        std::map<uint64_t, std::string> extents; // offset -> data, non-overlapping
+        clock::time_point               since;   // time of the oldest buffered write
+    };
+
+    std::unique_ptr<Backend>                     m_backend;
+    size_t                                       m_max_size;
+    std::chrono::milliseconds                    m_max_age;
+    size_t                                       m_alignment;
+    std::unordered_map<std::string, DirtyObject> m_dirty;
+    size_t                                       m_dirty_size = 0;
+    // reservation mark of the objects appended to: end of their last
+    // reservation, or of their data if it extends further
+    std::unordered_map<std::string, uint64_t>    m_reserved;
+    thallium::mutex                              m_mtx;
+    thallium::condition_variable                 m_cv;
+    bool                                         m_stop = false; // stops the flusher
+    // ULT flushing the objects whose buffered data is older than max_age
+    std::unique_ptr<thallium::managed<thallium::thread>> m_flusher;
+
+    public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param backend Underlying backend.
+     * @param engine Thallium engine, in whose handler pool the flusher runs.
+     * @param config "write_back" section of the sequencer configuration.
+     */
+    WriteBackBackend(std::unique_ptr<Backend>&& backend,
+                     const thallium::engine& engine,
+                     const json& config);
+
+    /**
+     * @brief Destructor. Stops the flusher and flushes any buffered data.
+     */
+    ~WriteBackBackend();
+
+    void sayHello() override;
+
+    RequestResult<int32_t> computeSum(int32_t x, int32_t y) override;
+
+    /**
+     * @brief Buffers the write, merging it with buffered writes
+     * it overlaps or is adjacent to. Writes larger than max_size
+     * bypass the buffer. A write that makes the buffer exceed max_size
+     * wakes the flusher up, and the writer flushes the buffer itself
+     * if it exceeds twice max_size.
+     */
+    RequestResult<bool> write(const std::string& object,
+                              uint64_t offset,
+                              const char* data,
+                              size_t size) override;
+
+    /**
+     * @brief Reserves the range in the write-back layer, so that appends
+     * are buffered like other writes. The reservation mark of an object
+     * starts at the end known to the underlying backend and then follows
+     * the reservations and the writes made through this layer.
+     */
+    RequestResult<uint64_t> reserve(const std::string& object,
+                                    size_t size) override;
+
+    /**
+     * @brief Reads from the underlying backend and overlays
+     * the buffered data, so that reads see prior writes.
+     * Errors of the underlying backend are reported, except
+     * for objects that so far only exist in the buffer.
+     */
+    RequestResult<size_t> read(const std::string& object,
+                               uint64_t offset,
+                               char* data,
+                               size_t size) override;
+
+    RequestResult<bool> remove(const std::string& object) override;
+
+    /**
+     * @brief Lists the objects of the underlying backend merged
+     * with the objects that so far only exist in the buffer.
+     */
+    RequestResult<std::vector<std::string>> listObjects(
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) override;
+
+    /**
+     * @brief Omap operations are forwarded to the underlying backend.
+     * Objects that only exist in the buffer are flushed first so that
+     * the underlying backend knows about them.
+     */
+    RequestResult<bool> omapSet(const std::string& object,
+                                const std::vector<std::pair<std::string, std::string>>& entries) override;
+
+    RequestResult<std::vector<std::pair<std::string, std::string>>> omapGet(
+            const std::string& object,
+            const std::vector<std::string>& keys) override;
+
+    RequestResult<bool> omapRemove(const std::string& object,
+                                   const std::vector<std::string>& keys) override;
+
+    RequestResult<std::vector<std::pair<std::string, std::string>>> omapScan(
+            const std::string& object,
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) override;
+
+    /**
+     * @brief Flushes the object's buffered data, then forwards the
+     * operation to the underlying backend, which applies it atomically.
+     */
+    RequestResult<uint64_t> execute(const std::string& object,
+                                    const WriteOp& op) override;
+
+    /**
+     * @brief Writes all the buffered data to the underlying backend.
+     */
+    RequestResult<bool> flush() override;
+
+    /**
+     * @brief Discards the buffered data, which would be destroyed
+     * along with the underlying backend anyway, and destroys it.
+     */
+    RequestResult<bool> destroy() override;
+
+    private:
+
+    /**
+     * @brief Inserts [offset, offset+size) into a set of extents,
+     * merging it with the extents it overlaps or touches.
+     * Returns the change in the number of buffered bytes.
+     */
+    static int64_t insertExtent(std::map<uint64_t, std::string>& extents,
+                                uint64_t offset, const char* data, size_t size);
+
+    /**
+     * @brief Removes [offset, offset+size) from a set of extents.
+     * Returns the number of bytes removed.
+     */
+    static size_t trimExtents(std::map<uint64_t, std::string>& extents,
+                              uint64_t offset, size_t size);
+
+    /**
+     * @brief Reads from the underlying backend, an object it does not
+     * know about reading as empty.
+     */
+    RequestResult<size_t> readBackend(const std::string& object,
+                                      uint64_t offset,
+                                      char* data,
+                                      size_t size);
+
+    RequestResult<bool> flushObject(const std::string& object, DirtyObject& dirty);
+
+    /**
+     * @brief Flushes the buffered data of a single object, if any.
+     */
+    RequestResult<bool> flushObject(const std::string& object);
+
+    RequestResult<bool> flushIfNeeded();
+
+    /**
+     * @brief Body of the flusher ULT: calls flushIfNeeded when the
+     * oldest buffered write reaches max_age or when notified by a
+     * write, until m_stop is set.
+     */
+    void runFlusher();
+
+    RequestResult<bool> flushAll();
+};
+
+}
+
+#endif
@@ -4,10 +4,16 @@
  * See COPYRIGHT in top-level directory.
  */
 #include "DummyBackend.hpp"
+#include "../Checksum.hpp"
 #include <iostream>
+#include <cstring>
+#include <algorithm>
 
 MOBJECT_REGISTER_BACKEND(dummy, DummySequencer);
 
+// definition of the constant, which std::min binds to a reference
+constexpr size_t DummySequencer::checksum_chunk_size;
+
 void DummySequencer::sayHello() {
     std::cout << "Hello World" << std::endl;
 }
@@ -18,6 +24,333 @@ mobject::RequestResult<int32_t> DummySequencer::computeSum(int32_t x, int32_t y)
     return result;
 }
 
+std::shared_ptr<DummySequencer::Object> DummySequencer::findObject(const std::string& object, bool create) {
+    std::lock_guard<thallium::mutex> lock(m_objects_mtx);
+    auto it = m_objects.find(object);
+    if(it != m_objects.end()) return it->second;
+    if(not create) return nullptr;
+    auto obj = std::make_shared<Object>();
+    m_objects.emplace(object, obj);
+    return obj;
+}
+
+mobject::RequestResult<bool> DummySequencer::write(const std::string& object,
+                                                   uint64_t offset,
+                                                   const char* data,
+                                                   size_t size) {
+    mobject::RequestResult<bool> result;
+    auto obj = findObject(object, true);
+    std::lock_guard<thallium::mutex> lock(obj->mutex);
+    writeData(*obj, offset, data, size);
+    obj->version += 1;
+    return result;
+}
+
+mobject::RequestResult<uint64_t> DummySequencer::reserve(const std::string& object,
+                                                         size_t size) {
+    mobject::RequestResult<uint64_t> result;
+    auto obj = findObject(object, true);
+    std::lock_guard<thallium::mutex> lock(obj->mutex);
+    uint64_t offset = std::max<uint64_t>(obj->reserved, obj->data.size());
+    obj->reserved = offset + size;
+    result.value() = offset;
+    return result;
+}
+
+mobject::RequestResult<size_t> DummySequencer::read(const std::string& object,
+                                                    uint64_t offset,
+                                                    char* data,
+                                                    size_t size) {
+    mobject::RequestResult<size_t> result;
+    auto obj = findObject(object, false);
+    if(not obj) {
+        result.success() = false;
+        result.error() = "Object " + object + " not found";
+        return result;
+    }
+    std::lock_guard<thallium::mutex> lock(obj->mutex);
+    if(offset >= obj->data.size()) {
+        result.value() = 0;
+        return result;
+    }
+    size_t n = std::min<size_t>(size, obj->data.size() - offset);
+    if(not verifyChecksums(*obj, offset, offset + n)) {
+        result.success() = false;
+        result.error() = "Checksum mismatch in object " + object;
+        return result;
+    }
+    std::memcpy(data, obj->data.data() + offset, n);
+    result.value() = n;
+    return result;
+}
+
+mobject::RequestResult<bool> DummySequencer::remove(const std::string& object) {
+    mobject::RequestResult<bool> result;
+    std::lock_guard<thallium::mutex> lock(m_objects_mtx);
+    if(m_objects.erase(object) == 0) {
+        result.success() = false;
+        result.error() = "Object " + object + " not found";
+    }
+    return result;
+}
+
+mobject::RequestResult<std::vector<std::string>> DummySequencer::listObjects(
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) {
+    mobject::RequestResult<std::vector<std::string>> result;
+    auto& names = result.value();
+    std::lock_guard<thallium::mutex> lock(m_objects_mtx);
+    auto it = start_after < prefix ? m_objects.lower_bound(prefix)
+                                   : m_objects.upper_bound(start_after);
+    for(; it != m_objects.end() && names.size() < max; ++it) {
+        if(it->first.compare(0, prefix.size(), prefix) != 0) break;
+        names.push_back(it->first);
+    }
+    return result;
+}
+
+namespace {
+
+using OmapEntry = std::pair<std::string, std::string>;
+
+bool keyLess(const OmapEntry& entry, const std::string& key) {
+    return entry.first < key;
+}
+
+}
+
+mobject::RequestResult<bool> DummySequencer::omapSet(
+        const std::string& object,
+        const std::vector<OmapEntry>& entries) {
+    mobject::RequestResult<bool> result;
+    auto obj = findObject(object, true);
+    std::lock_guard<thallium::mutex> lock(obj->mutex);
+    setOmap(*obj, entries);
+    obj->version += 1;
+    return result;
+}
+
+mobject::RequestResult<std::vector<OmapEntry>> DummySequencer::omapGet(
+        const std::string& object,
+        const std::vector<std::string>& keys) {
+    mobject::RequestResult<std::vector<OmapEntry>> result;
+    std::vector<std::string> sorted_keys(keys);
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+    sorted_keys.erase(std::unique(sorted_keys.begin(), sorted_keys.end()), sorted_keys.end());
+    auto obj = findObject(object, false);
+    if(not obj) {
+        result.success() = false;
+        result.error() = "Object " + object + " not found";
+        return result;
+    }
+    std::lock_guard<thallium::mutex> lock(obj->mutex);
+    auto& omap = obj->omap;
+    auto it = omap.begin();
+    for(auto& key : sorted_keys) {
+        it = std::lower_bound(it, omap.end(), key, keyLess);
+        if(it == omap.end()) break;
+        if(it->first == key) result.value().push_back(*it);
+    }
+    return result;
+}
+
+mobject::RequestResult<bool> DummySequencer::omapRemove(
+        const std::string& object,
+        const std::vector<std::string>& keys) {
+    mobject::RequestResult<bool> result;
+    auto obj = findObject(object, false);
+    if(not obj) {
+        result.success() = false;
+        result.error() = "Object " + object + " not found";
+        return result;
+    }
+    std::lock_guard<thallium::mutex> lock(obj->mutex);
+    removeOmap(*obj, keys);
+    obj->version += 1;
+    return result;
+}
+
+mobject::RequestResult<std::vector<OmapEntry>> DummySequencer::omapScan(
+        const std::string& object,
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) {
+    mobject::RequestResult<std::vector<OmapEntry>> result;
+    auto obj = findObject(object, false);
+    if(not obj) {
+        result.success() = false;
+        result.error() = "Object " + object + " not found";
+        return result;
+    }
+    std::lock_guard<thallium::mutex> lock(obj->mutex);
+    auto& omap = obj->omap;
+    auto it = start_after < prefix
+        ? std::lower_bound(omap.begin(), omap.end(), prefix, keyLess)
+        : std::upper_bound(omap.begin(), omap.end(), start_after,
+            [](const std::string& key, const OmapEntry& entry) { return key < entry.first; });
+    for(; it != omap.end() && result.value().size() < max; ++it) {
+        if(it->first.compare(0, prefix.size(), prefix) != 0) break;
+        result.value().push_back(*it);
+    }
+    return result;
+}
+
+mobject::RequestResult<uint64_t> DummySequencer::execute(
+        const std::string& object,
+        const mobject::WriteOp& op) {
+    mobject::RequestResult<uint64_t> result;
+    // a new object is only inserted in the map once the operation
+    // succeeded, so the map's lock is held while it is being created
+    std::unique_lock<thallium::mutex> map_lock(m_objects_mtx);
+    std::shared_ptr<Object> obj;
+    bool created = false;
+    auto it = m_objects.find(object);
+    if(it != m_objects.end()) {
+        obj = it->second;
+        map_lock.unlock();
+    } else if(op.creates()) {
+        obj = std::make_shared<Object>();
+        created = true;
+    } else {
+        result.success() = false;
+        result.error() = "Object " + object + " not found";
+        return result;
+    }
+    std::lock_guard<thallium::mutex> lock(obj->mutex);
+    if(op.exclusive() && not created) {
+        result.success() = false;
+        result.error() = "Object " + object + " already exists";
+        return result;
+    }
+    if(op.assertsVersion() && op.version() != obj->version) {
+        result.success() = false;
+        result.error() = "Version mismatch on object " + object
+                       + " (expected " + std::to_string(op.version())
+                       + ", found " + std::to_string(obj->version) + ")";
+        return result;
+    }
+    // the operation is atomic: an invalid step fails it before any is applied
+    for(auto& step : op.steps()) {
+        switch(step.type) {
+        case mobject::WriteOp::WRITE:
+        case mobject::WriteOp::TRUNCATE:
+        case mobject::WriteOp::OMAP_SET:
+        case mobject::WriteOp::OMAP_REMOVE:
+            break;
+        default:
+            result.success() = false;
+            result.error() = "Unknown step type " + std::to_string(step.type)
+                           + " in operation on object " + object;
+            return result;
+        }
+    }
+    for(auto& step : op.steps()) {
+        switch(step.type) {
+        case mobject::WriteOp::WRITE:
+            writeData(*obj, step.offset, step.data.data(), step.data.size());
+            break;
+        case mobject::WriteOp::TRUNCATE:
+            truncateData(*obj, step.offset);
+            break;
+        case mobject::WriteOp::OMAP_SET:
+            setOmap(*obj, step.entries);
+            break;
+        case mobject::WriteOp::OMAP_REMOVE:
+            removeOmap(*obj, step.keys);
+            break;
+        }
+    }
+    if(op.setsVersion())
+        obj->version = op.newVersion();
+    else if(created || not op.steps().empty())
+        obj->version += 1;
+    if(created)
+        m_objects.emplace(object, obj);
+    result.value() = obj->version;
+    return result;
+}
+
+void DummySequencer::writeData(Object& obj, uint64_t offset, const char* data, size_t size) {
+    uint64_t old_size = obj.data.size();
+    if(old_size < offset + size)
+        obj.data.resize(offset + size, '\0');
+    std::memcpy(&obj.data[offset], data, size);
+    // the zero-filled gap between the old end and offset changed too
+    updateChecksums(obj, std::min(offset, old_size), offset + size);
+}
+
+void DummySequencer::truncateData(Object& obj, uint64_t size) {
+    uint64_t old_size = obj.data.size();
+    obj.data.resize(size, '\0');
+    // the reservation mark is left as is: appends that reserved a range
+    // past the new end may not have written it yet, so the next append
+    // starts after their ranges rather than at the new end
+    // the last chunk kept may have changed, as well as any new chunk
+    uint64_t first = std::min(size, old_size);
+    first -= first % checksum_chunk_size;
+    updateChecksums(obj, first, size);
+}
+
+void DummySequencer::setOmap(Object& obj, const std::vector<OmapEntry>& entries) {
+    // sort the batch (stable, so that the last value of a key wins)
+    // and merge it with the object's omap in a single pass
+    std::vector<OmapEntry> batch(entries);
+    std::stable_sort(batch.begin(), batch.end(),
+        [](const OmapEntry& a, const OmapEntry& b) { return a.first < b.first; });
+    auto& omap = obj.omap;
+    std::vector<OmapEntry> merged;
+    merged.reserve(omap.size() + batch.size());
+    auto it = omap.begin();
+    for(size_t i = 0; i < batch.size(); i++) {
+        if(i + 1 < batch.size() && batch[i+1].first == batch[i].first)
+            continue;
+        for(; it != omap.end() && it->first < batch[i].first; ++it)
+            merged.push_back(std::move(*it));
+        if(it != omap.end() && it->first == batch[i].first)
+            ++it;
+        merged.push_back(std::move(batch[i]));
+    }
+    for(; it != omap.end(); ++it)
+        merged.push_back(std::move(*it));
+    omap = std::move(merged);
+}
+
+void DummySequencer::removeOmap(Object& obj, const std::vector<std::string>& keys) {
+    std::vector<std::string> sorted_keys(keys);
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+    auto& omap = obj.omap;
+    auto key = sorted_keys.begin();
+    auto last = std::remove_if(omap.begin(), omap.end(),
+        [&](const OmapEntry& entry) {
+            key = std::lower_bound(key, sorted_keys.end(), entry.first);
+            return key != sorted_keys.end() && *key == entry.first;
+        });
+    omap.erase(last, omap.end());
+}
+
+void DummySequencer::updateChecksums(Object& obj, uint64_t start, uint64_t end) {
+    size_t size = obj.data.size();
+    obj.checksums.resize((size + checksum_chunk_size - 1) / checksum_chunk_size);
+    if(end <= start) return;
+    for(uint64_t c = start / checksum_chunk_size; c <= (end - 1) / checksum_chunk_size; c++) {
+        uint64_t chunk_start = c * checksum_chunk_size;
+        size_t   chunk_size  = std::min<uint64_t>(checksum_chunk_size, size - chunk_start);
+        obj.checksums[c] = mobject::crc32c(obj.data.data() + chunk_start, chunk_size);
+    }
+}
+
+bool DummySequencer::verifyChecksums(const Object& obj, uint64_t start, uint64_t end) {
+    size_t size = obj.data.size();
+    for(uint64_t c = start / checksum_chunk_size; c <= (end - 1) / checksum_chunk_size; c++) {
+        uint64_t chunk_start = c * checksum_chunk_size;
+        size_t   chunk_size  = std::min<uint64_t>(checksum_chunk_size, size - chunk_start);
+        if(obj.checksums[c] != mobject::crc32c(obj.data.data() + chunk_start, chunk_size))
+            return false;
+    }
+    return true;
+}
+
 mobject::RequestResult<bool> DummySequencer::destroy() {
     mobject::RequestResult<bool> result;
     result.value() = true;
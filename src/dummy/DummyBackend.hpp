@@ -7,6 +7,10 @@
 #define __DUMMY_BACKEND_HPP
 
 #include <mobject/Backend.hpp>
+#include <string>
+#include <map>
+#include <memory>
+#include <vector>
 
 using json = nlohmann::json;
 
@@ -14,8 +18,44 @@ using json = nlohmann::json;
  * Dummy implementation of an mobject Backend.
  */
 class DummySequencer : public mobject::Backend {
-   
-    json m_config;
+
+    /**
+     * In-memory object. Its content is protected by one CRC32C
+     * checksum per chunk of checksum_chunk_size bytes, updated on
+     * writes and verified on reads. Its omap is kept as a vector
+     * sorted by key, which is compact and fast to scan for the small
+     * number of attributes objects typically have. Each object has
+     * its own mutex, so that operations on different objects do not
+     * contend, and a version incremented by every modification.
+     */
+    struct Object {
+        thallium::mutex       mutex;
+        uint64_t              version = 0;
+        uint64_t              reserved = 0; // end of the last reservation
+        std::string           data;
+        std::vector<uint32_t> checksums;
+        std::vector<std::pair<std::string, std::string>> omap;
+    };
+
+    static constexpr size_t checksum_chunk_size = 4096;
+
+    json                                           m_config;
+    std::map<std::string, std::shared_ptr<Object>> m_objects; // ordered, for listing
+    thallium::mutex                                m_objects_mtx; // protects the map only
+
+    std::shared_ptr<Object> findObject(const std::string& object, bool create);
+
+    static void writeData(Object& obj, uint64_t offset, const char* data, size_t size);
+
+    static void truncateData(Object& obj, uint64_t size);
+
+    static void setOmap(Object& obj, const std::vector<std::pair<std::string, std::string>>& entries);
+
+    static void removeOmap(Object& obj, const std::vector<std::string>& keys);
+
+    static void updateChecksums(Object& obj, uint64_t start, uint64_t end);
+
+    static bool verifyChecksums(const Object& obj, uint64_t start, uint64_t end);
 
     public:
 
@@ -26,24 +66,24 @@ class DummySequencer : public mobject::Backend {
     : m_config(config) {}
 
     /**
-     * @brief Move-constructor.
+     * @brief Move-constructor is deleted.
      */
-    DummySequencer(DummySequencer&&) = default;
+    DummySequencer(DummySequencer&&) = delete;
 
     /**
-     * @brief Copy-constructor.
+     * @brief Copy-constructor is deleted.
      */
-    DummySequencer(const DummySequencer&) = default;
+    DummySequencer(const DummySequencer&) = delete;
 
     /**
-     * @brief Move-assignment operator.
+     * @brief Move-assignment operator is deleted.
      */
-    DummySequencer& operator=(DummySequencer&&) = default;
+    DummySequencer& operator=(DummySequencer&&) = delete;
 
     /**
-     * @brief Copy-assignment operator.
+     * @brief Copy-assignment operator is deleted.
      */
-    DummySequencer& operator=(const DummySequencer&) = default;
+    DummySequencer& operator=(const DummySequencer&) = delete;
 
     /**
      * @brief Destructor.
@@ -65,6 +105,108 @@ class DummySequencer : public mobject::Backend {
      */
     mobject::RequestResult<int32_t> computeSum(int32_t x, int32_t y) override;
 
+    /**
+     * @brief Writes data into an in-memory object.
+     *
+     * @param object Name of the object.
+     * @param offset Offset at which to write.
+     * @param data Data to write.
+     * @param size Size of the data.
+     *
+     * @return a RequestResult<bool> indicating success.
+     */
+    mobject::RequestResult<bool> write(const std::string& object,
+                                       uint64_t offset,
+                                       const char* data,
+                                       size_t size) override;
+
+    /**
+     * @brief Reserves a range at the end of an in-memory object.
+     *
+     * @param object Name of the object.
+     * @param size Number of bytes to reserve.
+     *
+     * @return a RequestResult containing the offset of the reserved range.
+     */
+    mobject::RequestResult<uint64_t> reserve(const std::string& object,
+                                             size_t size) override;
+
+    /**
+     * @brief Reads data from an in-memory object.
+     *
+     * @param object Name of the object.
+     * @param offset Offset at which to read.
+     * @param data Buffer in which to place the data.
+     * @param size Size of the buffer.
+     *
+     * @return a RequestResult containing the number of bytes read.
+     */
+    mobject::RequestResult<size_t> read(const std::string& object,
+                                        uint64_t offset,
+                                        char* data,
+                                        size_t size) override;
+
+    /**
+     * @brief Removes an in-memory object.
+     *
+     * @param object Name of the object.
+     *
+     * @return a RequestResult<bool> indicating success.
+     */
+    mobject::RequestResult<bool> remove(const std::string& object) override;
+
+    /**
+     * @brief Lists the in-memory objects whose name starts with a prefix.
+     *
+     * @param prefix Prefix of the names to list.
+     * @param start_after Only list names strictly greater than this one.
+     * @param max Maximum number of names to return.
+     *
+     * @return a RequestResult containing the names.
+     */
+    mobject::RequestResult<std::vector<std::string>> listObjects(
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) override;
+
+    /**
+     * @brief Sets key/value pairs in the omap of an in-memory object.
+     */
+    mobject::RequestResult<bool> omapSet(
+            const std::string& object,
+            const std::vector<std::pair<std::string, std::string>>& entries) override;
+
+    /**
+     * @brief Gets key/value pairs from the omap of an in-memory object.
+     */
+    mobject::RequestResult<std::vector<std::pair<std::string, std::string>>> omapGet(
+            const std::string& object,
+            const std::vector<std::string>& keys) override;
+
+    /**
+     * @brief Removes keys from the omap of an in-memory object.
+     */
+    mobject::RequestResult<bool> omapRemove(
+            const std::string& object,
+            const std::vector<std::string>& keys) override;
+
+    /**
+     * @brief Lists key/value pairs from the omap of an in-memory object.
+     */
+    mobject::RequestResult<std::vector<std::pair<std::string, std::string>>> omapScan(
+            const std::string& object,
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) override;
+
+    /**
+     * @brief Applies a WriteOp to an in-memory object while holding
+     * the object's lock.
+     */
+    mobject::RequestResult<uint64_t> execute(
+            const std::string& object,
+            const mobject::WriteOp& op) override;
+
     /**
      * @brief Destroys the underlying sequencer.
      *
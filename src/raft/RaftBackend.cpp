@@ -0,0 +1,961 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "RaftBackend.hpp"
+#include "../Timespec.hpp"
+#include <mobject/Exception.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <functional>
+
+namespace tl = thallium;
+
+MOBJECT_REGISTER_BACKEND(raft, RaftSequencer);
+
+const std::string RaftSequencer::not_leader_error = "Not the leader of the Raft group";
+const std::string RaftSequencer::leadership_lost_error = "Leadership lost before the operation was committed";
+
+/**
+ * @brief Validates the configuration of a Raft member and returns
+ * the provider id of its Raft RPCs.
+ */
+static uint16_t raftProviderId(const json& config) {
+    if(not config.is_object() || not config.contains("members") || not config.contains("self"))
+        throw mobject::Exception("Raft sequencer requires \"members\" and \"self\" in its configuration");
+    auto& members = config["members"];
+    auto self = config["self"].get<size_t>();
+    if(not members.is_array() || self >= members.size())
+        throw mobject::Exception("Invalid \"self\" index in Raft sequencer configuration");
+    if(config.value("heartbeat_ms", 50) <= 0
+    || config.value("election_timeout_ms", 300) <= 2*config.value("heartbeat_ms", 50))
+        throw mobject::Exception("election_timeout_ms should be more than twice heartbeat_ms");
+    if(config.value("max_batch_size", 256) <= 0 || config.value("max_in_flight", 4) <= 0)
+        throw mobject::Exception("max_batch_size and max_in_flight should be strictly positive");
+    if(config.value("max_remembered_proposals", 1024) <= 0
+    || config.value("max_remembered_proposers", 64) <= 0)
+        throw mobject::Exception("max_remembered_proposals and max_remembered_proposers should be strictly positive");
+    if(config.value("max_log_entries", 4096) < 2)
+        throw mobject::Exception("max_log_entries should be at least 2");
+    return members[self].at("provider_id").get<uint16_t>();
+}
+
+static std::unique_ptr<mobject::Backend> makeStateMachine(const tl::engine& engine, const json& config) {
+    std::string type = "dummy";
+    json sm_config = json::object();
+    if(config.contains("state_machine")) {
+        type = config["state_machine"].value("type", type);
+        if(config["state_machine"].contains("config"))
+            sm_config = config["state_machine"]["config"];
+    }
+    if(type == "raft")
+        throw mobject::Exception("The state machine of a Raft sequencer cannot be a Raft sequencer");
+    auto backend = mobject::SequencerFactory::createSequencer(type, engine, sm_config);
+    if(not backend)
+        throw mobject::Exception("Unknown state machine type " + type);
+    return backend;
+}
+
+static std::vector<tl::provider_handle> lookupMembers(const tl::engine& engine, const json& config) {
+    std::vector<tl::provider_handle> members;
+    for(auto& member : config["members"]) {
+        members.emplace_back(engine.lookup(member.at("address").get<std::string>()),
+                             member.at("provider_id").get<uint16_t>());
+    }
+    return members;
+}
+
+static mobject::RequestResult<bool> toBool(const mobject::RequestResult<uint64_t>& r) {
+    mobject::RequestResult<bool> result;
+    result.success() = r.success();
+    result.error() = r.error();
+    return result;
+}
+
+template<typename T>
+static mobject::RequestResult<T> failure(const std::string& error) {
+    mobject::RequestResult<T> result;
+    result.success() = false;
+    result.error() = error;
+    return result;
+}
+
+RaftSequencer::RaftSequencer(const tl::engine& engine, const json& config, bool learner)
+: tl::provider<RaftSequencer>(engine, raftProviderId(config))
+, m_config(config)
+, m_engine(engine)
+, m_pool(engine.get_handler_pool())
+, m_state_machine(makeStateMachine(engine, config))
+, m_members(lookupMembers(engine, config))
+, m_self(config["self"].get<int32_t>())
+, m_heartbeat(config.value("heartbeat_ms", 50))
+, m_election_timeout(config.value("election_timeout_ms", 300))
+, m_proposal_timeout(config.value("proposal_timeout_ms", 5000))
+, m_max_batch_size(config.value("max_batch_size", (size_t)256))
+, m_max_in_flight(config.value("max_in_flight", (size_t)4))
+, m_max_remembered_proposals(config.value("max_remembered_proposals", (size_t)1024))
+, m_max_remembered_proposers(config.value("max_remembered_proposers", (size_t)64))
+, m_max_log_entries(config.value("max_log_entries", (size_t)4096))
+, m_append_entries(define("mobject_raft_append_entries", &RaftSequencer::onAppendEntries, m_pool))
+, m_request_vote(define("mobject_raft_request_vote", &RaftSequencer::onRequestVote, m_pool))
+, m_propose(define("mobject_raft_propose", &RaftSequencer::onPropose, m_pool))
+, m_read_index(define("mobject_raft_read_index", &RaftSequencer::onReadIndex, m_pool))
+, m_install_snapshot(define("mobject_raft_install_snapshot", &RaftSequencer::onInstallSnapshot, m_pool))
+, m_learner(learner)
+, m_log(1)
+, m_followers(m_members.size())
+, m_last_heard(clock::now())
+, m_rng(std::random_device{}() + m_self)
+{
+    std::random_device rd;
+    m_proposer_id = ((uint64_t)rd() << 32) | rd();
+    resetElectionDeadline();
+    m_ticker = m_pool.make_thread([this]() { tick(); });
+}
+
+RaftSequencer::~RaftSequencer() {
+    m_append_entries.deregister();
+    m_request_vote.deregister();
+    m_propose.deregister();
+    m_read_index.deregister();
+    m_install_snapshot.deregister();
+    {
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        m_stopping = true;
+        m_cv.notify_all();
+    }
+    m_ticker->join();
+    std::unique_lock<tl::mutex> lock(m_mtx);
+    while(m_outstanding != 0)
+        m_cv.wait(lock);
+}
+
+void RaftSequencer::spawn(std::function<void()>&& f) {
+    m_outstanding += 1;
+    m_pool.make_thread([this, f=std::move(f)]() {
+        f();
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        m_outstanding -= 1;
+        m_cv.notify_all();
+    }, tl::anonymous());
+}
+
+bool RaftSequencer::enter() {
+    std::lock_guard<tl::mutex> lock(m_mtx);
+    if(m_stopping) return false;
+    m_outstanding += 1;
+    return true;
+}
+
+void RaftSequencer::leave() {
+    std::lock_guard<tl::mutex> lock(m_mtx);
+    m_outstanding -= 1;
+    m_cv.notify_all();
+}
+
+void RaftSequencer::tick() {
+    std::unique_lock<tl::mutex> lock(m_mtx);
+    while(not m_stopping) {
+        lock.unlock();
+        tl::thread::sleep(m_engine, m_heartbeat.count());
+        lock.lock();
+        if(m_stopping) break;
+        if(m_role == Role::LEADER) {
+            for(size_t i = 0; i < m_members.size(); i++)
+                if(m_followers[i].in_flight == 0) sendAppendEntries(i, true);
+        } else if(clock::now() >= m_election_deadline && not m_learner) {
+            startElection();
+        }
+    }
+}
+
+void RaftSequencer::resetElectionDeadline() {
+    std::uniform_int_distribution<long> dist(m_election_timeout.count(), 2*m_election_timeout.count());
+    m_election_deadline = clock::now() + std::chrono::milliseconds(dist(m_rng));
+}
+
+void RaftSequencer::becomeFollower(uint64_t term) {
+    if(term > m_term) {
+        m_term = term;
+        m_voted_for = -1;
+        m_leader = -1;
+    }
+    m_role = Role::FOLLOWER;
+    m_cv.notify_all();
+}
+
+void RaftSequencer::startElection() {
+    m_term += 1;
+    m_role = Role::CANDIDATE;
+    m_voted_for = m_self;
+    m_votes = 1;
+    m_leader = -1;
+    resetElectionDeadline();
+    spdlog::trace("[raft:{}] Starting election for term {}", m_self, m_term);
+    if(m_votes >= majority()) {
+        becomeLeader();
+        return;
+    }
+    VoteArgs args;
+    args.term = m_term;
+    args.candidate = m_self;
+    args.last_index = lastIndex();
+    args.last_term = m_log.back().term;
+    for(size_t i = 0; i < m_members.size(); i++) {
+        if((int32_t)i == m_self) continue;
+        spawn([this, i, args]() {
+            VoteReply reply;
+            try {
+                reply = m_request_vote.on(m_members[i]).timed(m_election_timeout, args);
+            } catch(const std::exception&) {
+                return;
+            }
+            std::lock_guard<tl::mutex> lock(m_mtx);
+            if(m_stopping) return;
+            if(reply.term > m_term) {
+                becomeFollower(reply.term);
+            } else if(m_role == Role::CANDIDATE && m_term == args.term && reply.granted) {
+                m_votes += 1;
+                if(m_votes >= majority()) becomeLeader();
+            }
+        });
+    }
+}
+
+void RaftSequencer::becomeLeader() {
+    m_role = Role::LEADER;
+    m_leader = m_self;
+    for(auto& f : m_followers) {
+        f.next = lastIndex() + 1;
+        f.match = 0;
+        f.last_ack = clock::time_point();
+    }
+    // committing an entry of the new term commits the previous ones
+    RaftEntry noop;
+    noop.term = m_term;
+    m_log.push_back(std::move(noop));
+    m_term_start = lastIndex();
+    spdlog::trace("[raft:{}] Became leader for term {}", m_self, m_term);
+    for(size_t i = 0; i < m_members.size(); i++)
+        sendAppendEntries(i, true);
+    advanceCommit();
+    m_cv.notify_all();
+}
+
+void RaftSequencer::sendAppendEntries(size_t i, bool heartbeat) {
+    if((int32_t)i == m_self) return;
+    auto& f = m_followers[i];
+    if(f.in_flight >= m_max_in_flight) return;
+    if(not heartbeat && f.next > lastIndex()) return;
+    f.next = std::min(f.next, lastIndex() + 1);
+    if(f.next <= m_log_start) {
+        // the entries the follower needs were discarded
+        sendSnapshot(i);
+        return;
+    }
+    AppendArgs args;
+    args.term = m_term;
+    args.leader = m_self;
+    args.prev_index = f.next - 1;
+    args.prev_term = entryAt(args.prev_index).term;
+    uint64_t end = std::min<uint64_t>(lastIndex() + 1, f.next + m_max_batch_size);
+    args.entries.assign(m_log.begin() + (f.next - m_log_start), m_log.begin() + (end - m_log_start));
+    args.commit = m_commit;
+    // the next batch is sent without waiting for this one to be acknowledged
+    f.next = end;
+    f.in_flight += 1;
+    auto sent_at = clock::now();
+    spawn([this, i, args, sent_at]() {
+        AppendReply reply;
+        bool ok = true;
+        try {
+            reply = m_append_entries.on(m_members[i]).timed(m_election_timeout, args);
+        } catch(const std::exception&) {
+            ok = false;
+        }
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        auto& f = m_followers[i];
+        f.in_flight -= 1;
+        if(m_stopping) return;
+        if(ok && reply.term > m_term) {
+            becomeFollower(reply.term);
+            return;
+        }
+        if(m_role != Role::LEADER || m_term != args.term) return;
+        if(not ok) {
+            // retransmit from the last known match at the next heartbeat
+            f.next = f.match + 1;
+            return;
+        }
+        if(reply.success) {
+            f.match = std::max(f.match, reply.last_index);
+            f.next = std::max(f.next, f.match + 1);
+            f.last_ack = std::max(f.last_ack, sent_at);
+            advanceCommit();
+        } else {
+            // the follower's log diverges or misses entries (e.g. batches
+            // arrived out of order): go back to where it is known to match
+            f.next = std::max(f.match + 1, std::min(reply.last_index + 1, args.prev_index));
+        }
+        sendAppendEntries(i, false);
+    });
+}
+
+void RaftSequencer::advanceCommit() {
+    if(m_role != Role::LEADER) return;
+    std::vector<uint64_t> matches;
+    for(size_t i = 0; i < m_members.size(); i++)
+        matches.push_back((int32_t)i == m_self ? lastIndex() : m_followers[i].match);
+    std::sort(matches.begin(), matches.end(), std::greater<uint64_t>());
+    uint64_t n = matches[majority() - 1];
+    // only entries of the current term are committed by counting replicas
+    if(n > m_commit && entryAt(n).term == m_term) {
+        m_commit = n;
+        applyCommitted();
+    }
+}
+
+void RaftSequencer::applyCommitted() {
+    while(m_applied < m_commit) {
+        m_applied += 1;
+        auto& entry = entryAt(m_applied);
+        mobject::RequestResult<uint64_t> result;
+        // a proposal retried after a failure may be in the log twice
+        std::map<uint64_t, mobject::RequestResult<uint64_t>>* proposals = nullptr;
+        bool duplicate = false;
+        if(entry.seq != 0) {
+            auto& proposer = m_proposals[entry.proposer];
+            proposer.last_index = m_applied;
+            proposals = &proposer.results;
+            auto it = proposals->find(entry.seq);
+            if(it != proposals->end()) {
+                result = it->second;
+                duplicate = true;
+            }
+        }
+        if(not duplicate) {
+            switch(entry.type) {
+                case RaftEntry::RESERVE:
+                    result = m_state_machine->reserve(entry.object, entry.size);
+                    if(result.success())
+                        m_reserved[entry.object] = result.value() + entry.size;
+                    break;
+                case RaftEntry::REMOVE: {
+                    auto r = m_state_machine->remove(entry.object);
+                    m_reserved.erase(entry.object);
+                    result.success() = r.success();
+                    result.error() = r.error();
+                    break;
+                }
+                case RaftEntry::EXECUTE:
+                    result = m_state_machine->execute(entry.object, entry.op);
+                    break;
+                default:
+                    break;
+            }
+            if(proposals) {
+                (*proposals)[entry.seq] = result;
+                if(proposals->size() > m_max_remembered_proposals)
+                    proposals->erase(proposals->begin());
+            }
+        }
+        if(m_proposals.size() > m_max_remembered_proposers) {
+            // forget the proposer whose proposals were applied least
+            // recently, typically a member instance that went away
+            auto oldest = std::min_element(m_proposals.begin(), m_proposals.end(),
+                [](const std::pair<const uint64_t, RaftProposerResults>& a,
+                   const std::pair<const uint64_t, RaftProposerResults>& b) {
+                    return a.second.last_index < b.second.last_index;
+                });
+            m_proposals.erase(oldest);
+        }
+        if(m_waiting.count(m_applied))
+            m_results[m_applied] = std::move(result);
+    }
+    compactLog();
+    m_cv.notify_all();
+}
+
+void RaftSequencer::compactLog() {
+    if(m_log.size() <= m_max_log_entries) return;
+    // the last half of the entries are kept, so that a follower slightly
+    // behind gets entries rather than a snapshot
+    uint64_t index = std::min<uint64_t>(m_applied, lastIndex() - m_max_log_entries / 2);
+    if(index <= m_log_start) return;
+    m_log.erase(m_log.begin(), m_log.begin() + (index - m_log_start));
+    m_log_start = index;
+    // only the term of the new sentinel is needed
+    RaftEntry sentinel;
+    sentinel.term = m_log[0].term;
+    m_log[0] = std::move(sentinel);
+}
+
+mobject::RequestResult<std::vector<RaftObjectState>> RaftSequencer::takeSnapshot() {
+    using Result = std::vector<RaftObjectState>;
+    mobject::RequestResult<Result> result;
+    auto& objects = result.value();
+    std::string start_after;
+    while(true) {
+        auto page = m_state_machine->listObjects("", start_after, 1024);
+        if(not page.success()) return failure<Result>(page.error());
+        if(page.value().empty()) break;
+        for(auto& name : page.value()) {
+            RaftObjectState state;
+            state.name = name;
+            auto version = m_state_machine->execute(name, mobject::WriteOp());
+            if(not version.success()) return failure<Result>(version.error());
+            state.version = version.value();
+            auto reserved = m_reserved.find(name);
+            if(reserved != m_reserved.end()) state.reserved = reserved->second;
+            while(true) {
+                size_t offset = state.data.size();
+                state.data.resize(offset + snapshot_chunk_size);
+                auto r = m_state_machine->read(name, offset, &state.data[offset], snapshot_chunk_size);
+                if(not r.success()) return failure<Result>(r.error());
+                state.data.resize(offset + r.value());
+                if(r.value() < snapshot_chunk_size) break;
+            }
+            std::string omap_after;
+            while(true) {
+                auto r = m_state_machine->omapScan(name, "", omap_after, 1024);
+                if(not r.success()) return failure<Result>(r.error());
+                if(r.value().empty()) break;
+                omap_after = r.value().back().first;
+                state.omap.insert(state.omap.end(), r.value().begin(), r.value().end());
+            }
+            objects.push_back(std::move(state));
+        }
+        start_after = page.value().back();
+    }
+    return result;
+}
+
+mobject::RequestResult<bool> RaftSequencer::installSnapshot(const SnapshotArgs& args) {
+    mobject::RequestResult<bool> result;
+    // the state machine already reflects the entries of the snapshot
+    if(args.index <= m_applied) return result;
+    while(true) {
+        auto page = m_state_machine->listObjects("", "", 1024);
+        if(not page.success()) return failure<bool>(page.error());
+        if(page.value().empty()) break;
+        for(auto& name : page.value()) {
+            auto r = m_state_machine->remove(name);
+            if(not r.success()) return r;
+        }
+    }
+    m_reserved.clear();
+    for(auto& state : m_incoming) {
+        // reserving first on the new object sets its reservation mark
+        // exactly, whether it is before or after the end of the data
+        if(state.reserved != 0) {
+            auto r = m_state_machine->reserve(state.name, state.reserved);
+            if(not r.success()) return failure<bool>(r.error());
+            m_reserved[state.name] = state.reserved;
+        }
+        auto w = m_state_machine->write(state.name, 0, state.data.data(), state.data.size());
+        if(not w.success()) return w;
+        mobject::WriteOp op;
+        op.create().setVersion(state.version);
+        if(not state.omap.empty()) op.omapSet(state.omap);
+        auto r = m_state_machine->execute(state.name, op);
+        if(not r.success()) return failure<bool>(r.error());
+    }
+    m_proposals = args.proposals;
+    // the entries that follow the snapshot are kept if the log agrees
+    // with it, and the log starts over after it otherwise
+    if(args.index >= m_log_start && args.index < lastIndex()
+    && entryAt(args.index).term == args.last_term) {
+        m_log.erase(m_log.begin(), m_log.begin() + (args.index - m_log_start));
+    } else {
+        m_log.resize(1);
+    }
+    RaftEntry sentinel;
+    sentinel.term = args.last_term;
+    m_log[0] = std::move(sentinel);
+    m_log_start = args.index;
+    m_applied = args.index;
+    m_commit = std::max(m_commit, args.index);
+    spdlog::trace("[raft:{}] Installed snapshot at index {}", m_self, args.index);
+    applyCommitted();
+    return result;
+}
+
+void RaftSequencer::sendSnapshot(size_t i) {
+    auto& f = m_followers[i];
+    if(f.installing || clock::now() < f.snapshot_after) return;
+    auto snapshot = takeSnapshot();
+    if(not snapshot.success()) {
+        spdlog::error("[raft:{}] Could not take a snapshot for member {}: {}", m_self, i, snapshot.error());
+        return;
+    }
+    f.installing = true;
+    SnapshotArgs header;
+    header.term = m_term;
+    header.leader = m_self;
+    header.index = m_applied;
+    header.last_term = entryAt(m_applied).term;
+    auto sent_at = clock::now();
+    spawn([this, i, header, sent_at,
+           objects=std::move(snapshot.value()), proposals=m_proposals]() {
+        SnapshotReply reply;
+        bool ok = true;
+        size_t next = 0;
+        do {
+            SnapshotArgs args = header;
+            args.first = next == 0;
+            size_t bytes = 0;
+            while(next < objects.size() && (args.objects.empty() || bytes < snapshot_chunk_size)) {
+                bytes += objects[next].data.size();
+                args.objects.push_back(objects[next++]);
+            }
+            args.done = next == objects.size();
+            if(args.done) args.proposals = proposals;
+            try {
+                reply = m_install_snapshot.on(m_members[i]).timed(m_proposal_timeout, args);
+                ok = reply.success;
+            } catch(const std::exception&) {
+                ok = false;
+            }
+        } while(ok && next < objects.size());
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        auto& f = m_followers[i];
+        f.installing = false;
+        if(m_stopping) return;
+        if(reply.term > m_term) {
+            becomeFollower(reply.term);
+            return;
+        }
+        if(not ok) {
+            // retried at a heartbeat, without taking a snapshot for
+            // every heartbeat while the follower is unreachable
+            f.snapshot_after = clock::now() + m_election_timeout;
+            return;
+        }
+        if(m_role != Role::LEADER || m_term != header.term) return;
+        f.match = std::max(f.match, header.index);
+        f.next = std::max(f.next, f.match + 1);
+        f.last_ack = std::max(f.last_ack, sent_at);
+        advanceCommit();
+        sendAppendEntries(i, false);
+    });
+}
+
+bool RaftSequencer::leaseValid() const {
+    if(m_role != Role::LEADER) return false;
+    auto now = clock::now();
+    std::vector<clock::time_point> acks;
+    for(size_t i = 0; i < m_members.size(); i++)
+        acks.push_back((int32_t)i == m_self ? now : m_followers[i].last_ack);
+    std::sort(acks.begin(), acks.end(), std::greater<clock::time_point>());
+    // followers do not vote for another candidate within an election
+    // timeout of hearing from the leader; keep a margin for clock drift
+    return now < acks[majority() - 1] + m_election_timeout * 9 / 10;
+}
+
+mobject::RequestResult<uint64_t> RaftSequencer::proposeLocal(std::unique_lock<tl::mutex>& lock,
+                                                             RaftEntry&& entry) {
+    entry.term = m_term;
+    m_log.push_back(std::move(entry));
+    uint64_t index = lastIndex();
+    uint64_t term = m_term;
+    m_waiting.insert(index);
+    for(size_t i = 0; i < m_members.size(); i++)
+        sendAppendEntries(i, false);
+    advanceCommit();
+
+    mobject::RequestResult<uint64_t> result;
+    auto deadline = mobject::timespecIn(m_proposal_timeout);
+    bool timed_out = false;
+    while(true) {
+        auto it = m_results.find(index);
+        if(it != m_results.end()) {
+            result = std::move(it->second);
+            m_results.erase(it);
+            break;
+        }
+        if(m_stopping) {
+            result = failure<uint64_t>("Raft sequencer is shutting down");
+            break;
+        }
+        // the entry may also have been discarded with the log that
+        // a snapshot replaced, without being applied locally
+        if(lastIndex() < index || index <= m_log_start || entryAt(index).term != term) {
+            result = failure<uint64_t>(leadership_lost_error);
+            break;
+        }
+        if(timed_out) {
+            result = failure<uint64_t>("Timed out waiting for the operation to be committed");
+            break;
+        }
+        timed_out = not m_cv.wait_until(lock, &deadline);
+    }
+    m_waiting.erase(index);
+    return result;
+}
+
+mobject::RequestResult<uint64_t> RaftSequencer::submit(RaftEntry&& entry) {
+    auto give_up = clock::now() + m_proposal_timeout;
+    {
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        entry.proposer = m_proposer_id;
+        entry.seq = ++m_next_seq;
+    }
+    // the entry may have been appended to the log by a leader that
+    // failed to answer; retrying it is safe since applyCommitted only
+    // applies the first copy of a proposal that gets committed
+    while(true) {
+        std::unique_lock<tl::mutex> lock(m_mtx);
+        if(m_stopping)
+            return failure<uint64_t>("Raft sequencer is shutting down");
+        if(m_role == Role::LEADER) {
+            auto result = proposeLocal(lock, RaftEntry(entry));
+            if(result.success() || result.error() != leadership_lost_error)
+                return result;
+            lock.unlock();
+        } else {
+            int32_t leader = m_leader;
+            lock.unlock();
+            if(leader >= 0) {
+                try {
+                    mobject::RequestResult<uint64_t> result =
+                        m_propose.on(m_members[leader]).timed(m_proposal_timeout, entry);
+                    if(result.success() || (result.error() != not_leader_error
+                                         && result.error() != leadership_lost_error))
+                        return result;
+                } catch(const tl::timeout&) {
+                    // the attempt used up the time given to the proposal
+                    return failure<uint64_t>("Timed out forwarding the operation to the leader");
+                } catch(const std::exception&) {
+                    // the leader is unreachable; wait for a new one to be elected
+                }
+            }
+        }
+        if(clock::now() >= give_up)
+            return failure<uint64_t>("No leader available in the Raft group");
+        tl::thread::sleep(m_engine, m_heartbeat.count());
+    }
+}
+
+mobject::RequestResult<uint64_t> RaftSequencer::readIndexLocal(std::unique_lock<tl::mutex>& lock) {
+    if(leaseValid() && m_commit >= m_term_start) {
+        mobject::RequestResult<uint64_t> result;
+        result.value() = m_commit;
+        return result;
+    }
+    // without a lease, confirm leadership by committing an entry
+    auto result = proposeLocal(lock, RaftEntry());
+    if(result.success()) result.value() = m_applied;
+    return result;
+}
+
+mobject::RequestResult<bool> RaftSequencer::readBarrier() {
+    auto give_up = clock::now() + m_proposal_timeout;
+    while(true) {
+        std::unique_lock<tl::mutex> lock(m_mtx);
+        if(m_stopping)
+            return failure<bool>("Raft sequencer is shutting down");
+        if(m_role == Role::LEADER)
+            return toBool(readIndexLocal(lock));
+        int32_t leader = m_leader;
+        lock.unlock();
+        if(leader >= 0) {
+            mobject::RequestResult<uint64_t> index;
+            try {
+                index = m_read_index.on(m_members[leader]).timed(m_proposal_timeout);
+            } catch(const std::exception&) {
+                index = failure<uint64_t>(not_leader_error);
+            }
+            if(index.success()) {
+                // serve the read once the leader's commit index is applied locally
+                lock.lock();
+                auto deadline = mobject::timespecIn(m_proposal_timeout);
+                while(m_applied < index.value() && not m_stopping) {
+                    if(not m_cv.wait_until(lock, &deadline))
+                        return failure<bool>("Timed out waiting for the Raft log to be applied");
+                }
+                return mobject::RequestResult<bool>();
+            }
+            if(index.error() != not_leader_error)
+                return toBool(index);
+        }
+        if(clock::now() >= give_up)
+            return failure<bool>("No leader available in the Raft group");
+        tl::thread::sleep(m_engine, m_heartbeat.count());
+    }
+}
+
+void RaftSequencer::onAppendEntries(const tl::request& req, const AppendArgs& args) {
+    AppendReply reply;
+    if(not enter()) {
+        req.respond(reply);
+        return;
+    }
+    {
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        if(args.term < m_term) {
+            reply.term = m_term;
+            reply.last_index = lastIndex();
+        } else {
+            if(args.term > m_term || m_role != Role::FOLLOWER)
+                becomeFollower(args.term);
+            m_leader = args.leader;
+            m_last_heard = clock::now();
+            resetElectionDeadline();
+            reply.term = m_term;
+            // the entries discarded from the log were committed, so
+            // they match those of any leader
+            if(args.prev_index > lastIndex()
+            || (args.prev_index >= m_log_start && entryAt(args.prev_index).term != args.prev_term)) {
+                reply.last_index = std::min(lastIndex(), args.prev_index - 1);
+            } else {
+                uint64_t index = args.prev_index;
+                for(auto& entry : args.entries) {
+                    index += 1;
+                    if(index <= m_log_start) continue;
+                    if(index <= lastIndex()) {
+                        if(entryAt(index).term == entry.term) continue;
+                        m_log.resize(index - m_log_start); // drop the conflicting suffix
+                    }
+                    m_log.push_back(entry);
+                }
+                reply.success = true;
+                reply.last_index = index;
+                uint64_t commit = std::min(args.commit, index);
+                if(commit > m_commit) {
+                    m_commit = commit;
+                    applyCommitted();
+                }
+                // a learner votes again once its log holds the leader's
+                // commit index, and that index is in the leader's term
+                // (so that the entries committed by previous leaders
+                // that this one did not know about are included)
+                if(m_learner && args.commit > m_log_start && m_commit >= args.commit
+                && entryAt(args.commit).term == args.term) {
+                    m_learner = false;
+                    spdlog::trace("[raft:{}] Caught up at index {}, no longer a learner", m_self, m_commit);
+                }
+            }
+            m_cv.notify_all();
+        }
+    }
+    req.respond(reply);
+    leave();
+}
+
+void RaftSequencer::onRequestVote(const tl::request& req, const VoteArgs& args) {
+    VoteReply reply;
+    if(not enter()) {
+        req.respond(reply);
+        return;
+    }
+    {
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        // ignore candidates while the current leader is alive, so that its
+        // lease holds and a partitioned member cannot disrupt the group
+        bool leader_alive = m_role == Role::FOLLOWER && m_leader != -1
+                         && clock::now() < m_last_heard + m_election_timeout;
+        if(args.term > m_term && not leader_alive)
+            becomeFollower(args.term);
+        bool up_to_date = args.last_term > m_log.back().term
+                      || (args.last_term == m_log.back().term && args.last_index >= lastIndex());
+        if(args.term == m_term && not leader_alive && up_to_date && not m_learner
+        && (m_voted_for == -1 || m_voted_for == args.candidate)) {
+            m_voted_for = args.candidate;
+            reply.granted = true;
+            resetElectionDeadline();
+        }
+        reply.term = m_term;
+    }
+    req.respond(reply);
+    leave();
+}
+
+void RaftSequencer::onPropose(const tl::request& req, const RaftEntry& entry) {
+    mobject::RequestResult<uint64_t> result;
+    if(not enter()) {
+        req.respond(failure<uint64_t>("Raft sequencer is shutting down"));
+        return;
+    }
+    {
+        std::unique_lock<tl::mutex> lock(m_mtx);
+        if(m_role != Role::LEADER)
+            result = failure<uint64_t>(not_leader_error);
+        else
+            result = proposeLocal(lock, RaftEntry(entry));
+    }
+    req.respond(result);
+    leave();
+}
+
+void RaftSequencer::onReadIndex(const tl::request& req) {
+    mobject::RequestResult<uint64_t> result;
+    if(not enter()) {
+        req.respond(failure<uint64_t>("Raft sequencer is shutting down"));
+        return;
+    }
+    {
+        std::unique_lock<tl::mutex> lock(m_mtx);
+        if(m_role != Role::LEADER)
+            result = failure<uint64_t>(not_leader_error);
+        else
+            result = readIndexLocal(lock);
+    }
+    req.respond(result);
+    leave();
+}
+
+void RaftSequencer::onInstallSnapshot(const tl::request& req, const SnapshotArgs& args) {
+    SnapshotReply reply;
+    if(not enter()) {
+        req.respond(reply);
+        return;
+    }
+    {
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        if(args.term >= m_term) {
+            if(args.term > m_term || m_role != Role::FOLLOWER)
+                becomeFollower(args.term);
+            m_leader = args.leader;
+            m_last_heard = clock::now();
+            resetElectionDeadline();
+            if(args.first) {
+                m_incoming.clear();
+                m_incoming_index = args.index;
+            }
+            // chunks of an older snapshot are rejected
+            if(args.index == m_incoming_index) {
+                m_incoming.insert(m_incoming.end(), args.objects.begin(), args.objects.end());
+                reply.success = true;
+                if(args.done) {
+                    auto result = installSnapshot(args);
+                    if(not result.success()) {
+                        spdlog::error("[raft:{}] Could not install snapshot: {}", m_self, result.error());
+                        reply.success = false;
+                    }
+                    m_incoming.clear();
+                    m_incoming_index = 0;
+                }
+            }
+        }
+        reply.term = m_term;
+    }
+    req.respond(reply);
+    leave();
+}
+
+void RaftSequencer::sayHello() {
+    m_state_machine->sayHello();
+}
+
+mobject::RequestResult<int32_t> RaftSequencer::computeSum(int32_t x, int32_t y) {
+    return m_state_machine->computeSum(x, y);
+}
+
+mobject::RequestResult<bool> RaftSequencer::write(const std::string& object,
+                                                  uint64_t offset,
+                                                  const char* data,
+                                                  size_t size) {
+    RaftEntry entry;
+    entry.type = RaftEntry::EXECUTE;
+    entry.object = object;
+    entry.op.create().write(offset, data, size);
+    return toBool(submit(std::move(entry)));
+}
+
+mobject::RequestResult<uint64_t> RaftSequencer::reserve(const std::string& object,
+                                                        size_t size) {
+    RaftEntry entry;
+    entry.type = RaftEntry::RESERVE;
+    entry.object = object;
+    entry.size = size;
+    return submit(std::move(entry));
+}
+
+mobject::RequestResult<size_t> RaftSequencer::read(const std::string& object,
+                                                   uint64_t offset,
+                                                   char* data,
+                                                   size_t size) {
+    auto barrier = readBarrier();
+    if(not barrier.success()) return failure<size_t>(barrier.error());
+    return m_state_machine->read(object, offset, data, size);
+}
+
+mobject::RequestResult<bool> RaftSequencer::remove(const std::string& object) {
+    RaftEntry entry;
+    entry.type = RaftEntry::REMOVE;
+    entry.object = object;
+    return toBool(submit(std::move(entry)));
+}
+
+mobject::RequestResult<std::vector<std::string>> RaftSequencer::listObjects(
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) {
+    auto barrier = readBarrier();
+    if(not barrier.success()) return failure<std::vector<std::string>>(barrier.error());
+    return m_state_machine->listObjects(prefix, start_after, max);
+}
+
+mobject::RequestResult<bool> RaftSequencer::omapSet(const std::string& object,
+                                                    const KeyValues& entries) {
+    RaftEntry entry;
+    entry.type = RaftEntry::EXECUTE;
+    entry.object = object;
+    entry.op.create().omapSet(entries);
+    return toBool(submit(std::move(entry)));
+}
+
+mobject::RequestResult<RaftSequencer::KeyValues> RaftSequencer::omapGet(
+        const std::string& object,
+        const std::vector<std::string>& keys) {
+    auto barrier = readBarrier();
+    if(not barrier.success()) return failure<KeyValues>(barrier.error());
+    return m_state_machine->omapGet(object, keys);
+}
+
+mobject::RequestResult<bool> RaftSequencer::omapRemove(const std::string& object,
+                                                       const std::vector<std::string>& keys) {
+    RaftEntry entry;
+    entry.type = RaftEntry::EXECUTE;
+    entry.object = object;
+    entry.op.omapRemove(keys);
+    return toBool(submit(std::move(entry)));
+}
+
+mobject::RequestResult<RaftSequencer::KeyValues> RaftSequencer::omapScan(
+        const std::string& object,
+        const std::string& prefix,
+        const std::string& start_after,
+        size_t max) {
+    auto barrier = readBarrier();
+    if(not barrier.success()) return failure<KeyValues>(barrier.error());
+    return m_state_machine->omapScan(object, prefix, start_after, max);
+}
+
+mobject::RequestResult<uint64_t> RaftSequencer::execute(const std::string& object,
+                                                        const mobject::WriteOp& op) {
+    if(op.steps().empty() && not op.creates() && not op.setsVersion()) {
+        // only checks preconditions and returns the version: a read
+        auto barrier = readBarrier();
+        if(not barrier.success()) return failure<uint64_t>(barrier.error());
+        return m_state_machine->execute(object, op);
+    }
+    RaftEntry entry;
+    entry.type = RaftEntry::EXECUTE;
+    entry.object = object;
+    entry.op = op;
+    return submit(std::move(entry));
+}
+
+mobject::RequestResult<bool> RaftSequencer::destroy() {
+    return m_state_machine->destroy();
+}
+
+std::unique_ptr<mobject::Backend> RaftSequencer::create(const tl::engine& engine, const json& config) {
+    return std::unique_ptr<mobject::Backend>(new RaftSequencer(engine, config, false));
+}
+
+std::unique_ptr<mobject::Backend> RaftSequencer::open(const tl::engine& engine, const json& config) {
+    return std::unique_ptr<mobject::Backend>(new RaftSequencer(engine, config, true));
+}
@@ -0,0 +1,490 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __RAFT_BACKEND_HPP
+#define __RAFT_BACKEND_HPP
+
+#include <mobject/Backend.hpp>
+#include <thallium.hpp>
+#include <thallium/serialization/stl/map.hpp>
+#include <thallium/serialization/stl/pair.hpp>
+#include <thallium/serialization/stl/string.hpp>
+#include <thallium/serialization/stl/unordered_map.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include <vector>
+
+using json = nlohmann::json;
+
+/**
+ * @brief Entry of the replicated log of a RaftSequencer.
+ */
+struct RaftEntry {
+
+    enum Type : uint8_t {
+        NOOP    = 0, // appended by a new leader to commit the entries of previous terms
+        RESERVE = 1,
+        REMOVE  = 2,
+        EXECUTE = 3
+    };
+
+    uint64_t         term = 0;
+    uint8_t          type = NOOP;
+    uint64_t         proposer = 0; // identifies the member instance that proposed the entry
+    uint64_t         seq = 0;      // number of the proposal for that proposer, 0 for NOOPs
+    std::string      object;
+    uint64_t         size = 0; // size of a RESERVE
+    mobject::WriteOp op;       // operation of an EXECUTE
+
+    template<typename Archive>
+    void serialize(Archive& a) {
+        a & term;
+        a & type;
+        a & proposer;
+        a & seq;
+        a & object;
+        a & size;
+        a & op;
+    }
+};
+
+/**
+ * @brief State of an object in a snapshot of the state machine of a
+ * RaftSequencer, sent to the members that need entries no longer in
+ * the leader's log.
+ */
+struct RaftObjectState {
+
+    std::string                                      name;
+    uint64_t                                         version = 0;
+    uint64_t                                         reserved = 0; // end of the last reservation
+    std::string                                      data;
+    std::vector<std::pair<std::string, std::string>> omap;
+
+    template<typename Archive>
+    void serialize(Archive& a) {
+        a & name;
+        a & version;
+        a & reserved;
+        a & data;
+        a & omap;
+    }
+};
+
+/**
+ * @brief Results of the last proposals of a proposer applied to the
+ * state machine of a RaftSequencer.
+ */
+struct RaftProposerResults {
+
+    uint64_t                                             last_index = 0; // index of the last one
+    std::map<uint64_t, mobject::RequestResult<uint64_t>> results;        // by sequence number
+
+    template<typename Archive>
+    void serialize(Archive& a) {
+        a & last_index;
+        a & results;
+    }
+};
+
+/**
+ * Implementation of an mobject Backend whose state is replicated on
+ * several providers (typically 3 or 5) using the Raft consensus
+ * protocol, so that it survives the failure of a minority of them and
+ * never hands out the same reserved range twice. Every modification
+ * (reservation, write, removal, omap update, WriteOp) is an entry of
+ * a replicated log, applied in order by every member to a local state
+ * machine, which is another backend (dummy by default).
+ *
+ * Each member is created with the same configuration except for
+ * "self", its index in "members", e.g.
+ * {
+ *   "self" : 0,
+ *   "members" : [ { "address" : "na+sm://...", "provider_id" : 100 }, ... ],
+ *   "heartbeat_ms" : 50,
+ *   "election_timeout_ms" : 300,
+ *   "max_batch_size" : 256,
+ *   "max_in_flight" : 4,
+ *   "max_remembered_proposals" : 1024,
+ *   "max_remembered_proposers" : 64,
+ *   "max_log_entries" : 4096,
+ *   "proposal_timeout_ms" : 5000,
+ *   "state_machine" : { "type" : "dummy", "config" : {} }
+ * }
+ * The provider_id of a member identifies the Raft RPCs of that member;
+ * it must not be used by another Raft member on the same engine.
+ *
+ * The leader appends the entries proposed while an AppendEntries RPC
+ * is in flight to the next one (batching), and keeps up to
+ * "max_in_flight" AppendEntries outstanding per follower (pipelining).
+ * Followers forward modifications to the leader, retrying with the
+ * next leader if the leader fails or loses its leadership. Since a
+ * proposal may then end up in the log more than once, each one carries
+ * the identifier of the member instance that proposed it (drawn at
+ * random when the member is created) and a sequence number, and the
+ * state machine skips the copies of a proposal it already applied,
+ * answering them with the result of the first one. The last
+ * "max_remembered_proposals" (1024 by default) results of each proposer
+ * are kept for this, for the "max_remembered_proposers" (64 by default)
+ * proposers whose proposals were applied most recently. Reads are served
+ * locally by the leader while it holds a lease (a majority acknowledged
+ * a heartbeat less than an election timeout ago, and followers do not
+ * vote during that time), and by followers once they have applied the
+ * leader's commit index (read index).
+ *
+ * Once the log holds more than "max_log_entries" entries (4096 by
+ * default), each member discards the entries it applied, except for
+ * the last half of them. A follower that needs entries the leader
+ * discarded receives a snapshot of the leader's state machine instead
+ * (the state of every object, including the end of its last
+ * reservation, and the results remembered for the proposers), in
+ * chunks of InstallSnapshot RPCs, and replaces its state with it.
+ *
+ * The log and the state are kept in memory. A member that restarts
+ * rejoins the group by being opened (rather than created) with the
+ * same configuration: it then starts with an empty log and a new
+ * proposer identifier, as a learner that neither votes nor stands for
+ * election until it has received the log of a leader up to that
+ * leader's commit index. Otherwise, having forgotten the entries it
+ * acknowledged, it could elect a candidate missing committed entries,
+ * which would hand out reserved offsets again. A group in which a
+ * majority of the members restarted at the same time has lost its
+ * state and elects no leader; it must be destroyed and created again.
+ */
+class RaftSequencer : public mobject::Backend,
+                      public thallium::provider<RaftSequencer> {
+
+    using KeyValues = std::vector<std::pair<std::string, std::string>>;
+    using clock     = std::chrono::steady_clock;
+
+    enum class Role { FOLLOWER, CANDIDATE, LEADER };
+
+    struct AppendArgs {
+        uint64_t               term = 0;
+        int32_t                leader = -1;
+        uint64_t               prev_index = 0;
+        uint64_t               prev_term = 0;
+        std::vector<RaftEntry> entries;
+        uint64_t               commit = 0;
+
+        template<typename Archive>
+        void serialize(Archive& a) {
+            a & term;
+            a & leader;
+            a & prev_index;
+            a & prev_term;
+            a & entries;
+            a & commit;
+        }
+    };
+
+    struct AppendReply {
+        uint64_t term = 0;
+        bool     success = false;
+        uint64_t last_index = 0; // last index matching the leader, or a hint on failure
+
+        template<typename Archive>
+        void serialize(Archive& a) {
+            a & term;
+            a & success;
+            a & last_index;
+        }
+    };
+
+    struct VoteArgs {
+        uint64_t term = 0;
+        int32_t  candidate = -1;
+        uint64_t last_index = 0;
+        uint64_t last_term = 0;
+
+        template<typename Archive>
+        void serialize(Archive& a) {
+            a & term;
+            a & candidate;
+            a & last_index;
+            a & last_term;
+        }
+    };
+
+    struct VoteReply {
+        uint64_t term = 0;
+        bool     granted = false;
+
+        template<typename Archive>
+        void serialize(Archive& a) {
+            a & term;
+            a & granted;
+        }
+    };
+
+    struct SnapshotArgs {
+        uint64_t                     term = 0;
+        int32_t                      leader = -1;
+        uint64_t                     index = 0;     // last index covered by the snapshot
+        uint64_t                     last_term = 0; // term of the entry at that index
+        bool                         first = false; // first chunk of the snapshot
+        bool                         done = false;  // last chunk of the snapshot
+        std::vector<RaftObjectState> objects;
+        std::unordered_map<uint64_t, RaftProposerResults> proposals; // sent with the last chunk
+
+        template<typename Archive>
+        void serialize(Archive& a) {
+            a & term;
+            a & leader;
+            a & index;
+            a & last_term;
+            a & first;
+            a & done;
+            a & objects;
+            a & proposals;
+        }
+    };
+
+    struct SnapshotReply {
+        uint64_t term = 0;
+        bool     success = false;
+
+        template<typename Archive>
+        void serialize(Archive& a) {
+            a & term;
+            a & success;
+        }
+    };
+
+    struct Follower {
+        uint64_t          next = 1;
+        uint64_t          match = 0;
+        size_t            in_flight = 0;
+        bool              installing = false; // a snapshot is being sent to it
+        clock::time_point snapshot_after;     // no snapshot sent before, after a failed one
+        clock::time_point last_ack; // send time of the last acknowledged AppendEntries
+    };
+
+    // amount of object data sent per InstallSnapshot RPC
+    static constexpr size_t snapshot_chunk_size = 1024*1024;
+
+    static const std::string not_leader_error;
+    static const std::string leadership_lost_error;
+
+    json                                   m_config;
+    thallium::engine                       m_engine;
+    thallium::pool                         m_pool;
+    std::unique_ptr<mobject::Backend>      m_state_machine;
+    std::vector<thallium::provider_handle> m_members;
+    int32_t                                m_self;
+    std::chrono::milliseconds              m_heartbeat;
+    std::chrono::milliseconds              m_election_timeout;
+    std::chrono::milliseconds              m_proposal_timeout;
+    size_t                                 m_max_batch_size;
+    size_t                                 m_max_in_flight;
+    size_t                                 m_max_remembered_proposals;
+    size_t                                 m_max_remembered_proposers;
+    size_t                                 m_max_log_entries;
+
+    thallium::remote_procedure             m_append_entries;
+    thallium::remote_procedure             m_request_vote;
+    thallium::remote_procedure             m_propose;
+    thallium::remote_procedure             m_read_index;
+    thallium::remote_procedure             m_install_snapshot;
+
+    // Raft state, protected by m_mtx
+    thallium::mutex                        m_mtx;
+    thallium::condition_variable           m_cv;
+    Role                                   m_role = Role::FOLLOWER;
+    uint64_t                               m_term = 0;
+    int32_t                                m_voted_for = -1;
+    bool                                   m_learner; // rejoining after a restart (see onAppendEntries)
+    int32_t                                m_leader = -1;
+    size_t                                 m_votes = 0;
+    std::vector<RaftEntry>                 m_log; // m_log[0] is a sentinel, at index m_log_start
+    uint64_t                               m_log_start = 0; // last index discarded from the log
+    uint64_t                               m_commit = 0;
+    uint64_t                               m_applied = 0;
+    uint64_t                               m_term_start = 0; // index of the leader's first entry
+    std::vector<Follower>                  m_followers;
+    clock::time_point                      m_last_heard;
+    clock::time_point                      m_election_deadline;
+    std::unordered_set<uint64_t>           m_waiting; // indices of local proposals
+    std::unordered_map<uint64_t, mobject::RequestResult<uint64_t>> m_results;
+    uint64_t                               m_proposer_id;
+    uint64_t                               m_next_seq = 0;
+    // results of the last proposals applied, by proposer
+    std::unordered_map<uint64_t, RaftProposerResults> m_proposals;
+    // end of the last reservation of the objects of the state machine
+    std::unordered_map<std::string, uint64_t> m_reserved;
+    // chunks received so far of a snapshot being installed
+    uint64_t                               m_incoming_index = 0;
+    std::vector<RaftObjectState>           m_incoming;
+    std::mt19937                           m_rng;
+    bool                                   m_stopping = false;
+    size_t                                 m_outstanding = 0; // background threads and running handlers
+    thallium::managed<thallium::thread>    m_ticker;
+
+    uint64_t lastIndex() const { return m_log_start + m_log.size() - 1; }
+
+    RaftEntry& entryAt(uint64_t index) { return m_log[index - m_log_start]; }
+
+    size_t majority() const { return m_members.size() / 2 + 1; }
+
+    void tick();
+
+    void resetElectionDeadline();
+
+    void becomeFollower(uint64_t term);
+
+    void becomeLeader();
+
+    void startElection();
+
+    void sendAppendEntries(size_t i, bool heartbeat);
+
+    void advanceCommit();
+
+    void applyCommitted();
+
+    void compactLog();
+
+    mobject::RequestResult<std::vector<RaftObjectState>> takeSnapshot();
+
+    mobject::RequestResult<bool> installSnapshot(const SnapshotArgs& args);
+
+    void sendSnapshot(size_t i);
+
+    bool leaseValid() const;
+
+    void spawn(std::function<void()>&& f);
+
+    bool enter();
+
+    void leave();
+
+    mobject::RequestResult<uint64_t> proposeLocal(std::unique_lock<thallium::mutex>& lock,
+                                                  RaftEntry&& entry);
+
+    mobject::RequestResult<uint64_t> submit(RaftEntry&& entry);
+
+    mobject::RequestResult<uint64_t> readIndexLocal(std::unique_lock<thallium::mutex>& lock);
+
+    mobject::RequestResult<bool> readBarrier();
+
+    void onAppendEntries(const thallium::request& req, const AppendArgs& args);
+
+    void onRequestVote(const thallium::request& req, const VoteArgs& args);
+
+    void onPropose(const thallium::request& req, const RaftEntry& entry);
+
+    void onReadIndex(const thallium::request& req);
+
+    void onInstallSnapshot(const thallium::request& req, const SnapshotArgs& args);
+
+    public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param engine Thallium engine.
+     * @param config Configuration of the member.
+     * @param learner Whether the member rejoins a group it was part of,
+     * in which case it does not vote until it has caught up.
+     */
+    RaftSequencer(const thallium::engine& engine, const json& config, bool learner);
+
+    /**
+     * @brief Move-constructor is deleted.
+     */
+    RaftSequencer(RaftSequencer&&) = delete;
+
+    /**
+     * @brief Copy-constructor is deleted.
+     */
+    RaftSequencer(const RaftSequencer&) = delete;
+
+    /**
+     * @brief Move-assignment operator is deleted.
+     */
+    RaftSequencer& operator=(RaftSequencer&&) = delete;
+
+    /**
+     * @brief Copy-assignment operator is deleted.
+     */
+    RaftSequencer& operator=(const RaftSequencer&) = delete;
+
+    /**
+     * @brief Destructor. Stops the background thread and waits
+     * for the RPCs it issued.
+     */
+    virtual ~RaftSequencer();
+
+    void sayHello() override;
+
+    mobject::RequestResult<int32_t> computeSum(int32_t x, int32_t y) override;
+
+    mobject::RequestResult<bool> write(const std::string& object,
+                                       uint64_t offset,
+                                       const char* data,
+                                       size_t size) override;
+
+    /**
+     * @brief Reserves a range at the end of an object. The reservation
+     * is committed to the replicated log before being returned, so no
+     * range is ever handed out twice, even across leader changes, as
+     * long as a majority of the members keep their log.
+     */
+    mobject::RequestResult<uint64_t> reserve(const std::string& object,
+                                             size_t size) override;
+
+    mobject::RequestResult<size_t> read(const std::string& object,
+                                        uint64_t offset,
+                                        char* data,
+                                        size_t size) override;
+
+    mobject::RequestResult<bool> remove(const std::string& object) override;
+
+    mobject::RequestResult<std::vector<std::string>> listObjects(
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) override;
+
+    mobject::RequestResult<bool> omapSet(const std::string& object,
+                                         const KeyValues& entries) override;
+
+    mobject::RequestResult<KeyValues> omapGet(
+            const std::string& object,
+            const std::vector<std::string>& keys) override;
+
+    mobject::RequestResult<bool> omapRemove(const std::string& object,
+                                            const std::vector<std::string>& keys) override;
+
+    mobject::RequestResult<KeyValues> omapScan(
+            const std::string& object,
+            const std::string& prefix,
+            const std::string& start_after,
+            size_t max) override;
+
+    mobject::RequestResult<uint64_t> execute(const std::string& object,
+                                             const mobject::WriteOp& op) override;
+
+    mobject::RequestResult<bool> destroy() override;
+
+    /**
+     * @brief Creates a member of a Raft group.
+     */
+    static std::unique_ptr<mobject::Backend> create(const thallium::engine& engine, const json& config);
+
+    /**
+     * @brief Opens a member of a Raft group after a restart. Since the
+     * log is kept in memory, the member starts with an empty log, as a
+     * learner.
+     */
+    static std::unique_ptr<mobject::Backend> open(const thallium::engine& engine, const json& config);
+};
+
+#endif
@@ -4,7 +4,10 @@
  * See COPYRIGHT in top-level directory.
  */
 #include <mobject/Admin.hpp>
+#include <mobject/Client.hpp>
+#include <mobject/Provider.hpp>
 #include <cppunit/extensions/HelperMacros.h>
+#include <nlohmann/json.hpp>
 
 extern thallium::engine engine;
 extern std::string sequencer_type;
@@ -13,6 +16,10 @@ class AdminTest : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE( AdminTest );
     CPPUNIT_TEST( testAdminCreateSequencer );
+    CPPUNIT_TEST( testAdminPromoteSequencer );
+    CPPUNIT_TEST( testAdminMigrateReplicated );
+    CPPUNIT_TEST( testAdminReplicationTimeout );
+    CPPUNIT_TEST( testAdminLanes );
     CPPUNIT_TEST_SUITE_END();
 
     static constexpr const char* sequencer_config = "{ \"path\" : \"mydb\" }";
@@ -46,5 +53,159 @@ class AdminTest : public CppUnit::TestFixture
             admin.destroySequencer(addr, 0, bad_id),
             mobject::Exception);
     }
+    void testAdminPromoteSequencer() {
+        mobject::Admin admin(engine);
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+        mobject::Provider backup_provider(engine, 1);
+
+        std::string config = "{ \"path\" : \"mydb\", \"replication\" : { \"backups\" : "
+                             "[ { \"address\" : \"" + addr + "\", \"provider_id\" : 1 } ] } }";
+        mobject::UUID sequencer_id;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE("admin.createSequencer should succeed with a backup",
+                sequencer_id = admin.createSequencer(addr, 0, sequencer_type, config));
+
+        auto primary = client.makeSequencerHandle(addr, 0, sequencer_id);
+        std::string data = "Hello World";
+        primary.write("myobject", 0, data.data(), data.size());
+        primary.omapSet("myobject", {{"key", "value"}});
+        uint64_t version = primary.execute("myobject", mobject::WriteOp().omapSet({{"other", "x"}}));
+        primary.write("removed", 0, data.data(), data.size());
+        primary.remove("removed");
+        uint64_t offset = 0;
+        primary.append("log", data.data(), data.size());
+        primary.append("log", data.data(), data.size(), &offset);
+
+        auto stats = nlohmann::json::parse(admin.getStatistics(addr, 0));
+        auto& replication = stats["replication"][sequencer_id.to_string()];
+        CPPUNIT_ASSERT_EQUAL(1, replication["backups"].get<int>());
+        CPPUNIT_ASSERT_EQUAL(0, replication["dropped_backups"].get<int>());
+
+        // the replica is not visible to clients until it is promoted
+        CPPUNIT_ASSERT_THROW_MESSAGE("replicas should not be accessible",
+                client.makeSequencerHandle(addr, 1, sequencer_id),
+                mobject::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE("admin.promoteSequencer should throw on a primary",
+                admin.promoteSequencer(addr, 0, sequencer_id),
+                mobject::Exception);
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE("admin.promoteSequencer should succeed on a replica",
+                admin.promoteSequencer(addr, 1, sequencer_id));
+
+        auto promoted = client.makeSequencerHandle(addr, 1, sequencer_id);
+        std::string buffer(64, '\0');
+        size_t bytes_read = 0;
+        promoted.read("myobject", 0, &buffer[0], buffer.size(), &bytes_read);
+        buffer.resize(bytes_read);
+        CPPUNIT_ASSERT_EQUAL(data, buffer);
+        auto values = promoted.omapGet("myobject", {"key", "other"});
+        CPPUNIT_ASSERT_EQUAL((size_t)2, values.size());
+        CPPUNIT_ASSERT_EQUAL(version, promoted.execute("myobject", mobject::WriteOp()));
+        CPPUNIT_ASSERT_EQUAL((size_t)2, promoted.listObjects().size());
+        // the promoted replica continues the log after the primary's reservations
+        uint64_t next = 0;
+        promoted.append("log", data.data(), data.size(), &next);
+        CPPUNIT_ASSERT_EQUAL(offset + data.size(), next);
+
+        admin.destroySequencer(addr, 1, sequencer_id);
+        admin.destroySequencer(addr, 0, sequencer_id);
+    }
+
+    void testAdminMigrateReplicated() {
+        mobject::Admin admin(engine);
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+        mobject::Provider backup_provider(engine, 1);
+        mobject::Provider dest_provider(engine, 2);
+
+        std::string config = "{ \"path\" : \"mydb\", \"replication\" : { \"backups\" : "
+                             "[ { \"address\" : \"" + addr + "\", \"provider_id\" : 1 } ] } }";
+        auto sequencer_id = admin.createSequencer(addr, 0, sequencer_type, config);
+        auto sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+        std::string data = "Hello World";
+        sequencer.write("before", 0, data.data(), data.size());
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE("admin.migrateSequencer should succeed on a replicated sequencer",
+                admin.migrateSequencer(addr, 0, sequencer_id, addr, 2));
+        // the destination replicates to the backup of the source
+        sequencer.write("after", 0, data.data(), data.size());
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE("admin.promoteSequencer should succeed on the replica",
+                admin.promoteSequencer(addr, 1, sequencer_id));
+        auto promoted = client.makeSequencerHandle(addr, 1, sequencer_id);
+        for(auto& object : {"before", "after"}) {
+            std::string buffer(64, '\0');
+            size_t bytes_read = 0;
+            promoted.read(object, 0, &buffer[0], buffer.size(), &bytes_read);
+            buffer.resize(bytes_read);
+            CPPUNIT_ASSERT_EQUAL(data, buffer);
+        }
+
+        admin.destroySequencer(addr, 1, sequencer_id);
+        admin.destroySequencer(addr, 2, sequencer_id);
+    }
+
+    void testAdminReplicationTimeout() {
+        mobject::Admin admin(engine);
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        // the backup creates its replica on its admin lane, but its other
+        // RPCs run on a pool without xstream, so it never applies a batch
+        auto pool = thallium::pool::create(thallium::pool::access::mpmc);
+        std::vector<thallium::managed<thallium::xstream>> xstreams;
+        {
+            mobject::Provider backup_provider(engine, 1,
+                    "{ \"lanes\" : { \"admin\" : { \"xstreams\" : 1 } } }", *pool);
+
+            std::string config = "{ \"path\" : \"mydb\", \"replication\" : { \"backups\" : "
+                                 "[ { \"address\" : \"" + addr + "\", \"provider_id\" : 1 } ], "
+                                 "\"timeout_ms\" : 200 } }";
+            auto sequencer_id = admin.createSequencer(addr, 0, sequencer_type, config);
+            auto primary = client.makeSequencerHandle(addr, 0, sequencer_id);
+
+            // the write completes once the backup has been dropped
+            std::string data = "Hello World";
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE("writes should succeed when a backup times out",
+                    primary.write("myobject", 0, data.data(), data.size()));
+            auto stats = nlohmann::json::parse(admin.getStatistics(addr, 0));
+            auto& replication = stats["replication"][sequencer_id.to_string()];
+            CPPUNIT_ASSERT_EQUAL(0, replication["backups"].get<int>());
+            CPPUNIT_ASSERT_EQUAL(1, replication["dropped_backups"].get<int>());
+
+            // later mutations are no longer replicated
+            CPPUNIT_ASSERT_NO_THROW(primary.write("other", 0, data.data(), data.size()));
+
+            xstreams.push_back(thallium::xstream::create(
+                thallium::scheduler::predef::basic_wait, *pool));
+            admin.destroySequencer(addr, 1, sequencer_id);
+            admin.destroySequencer(addr, 0, sequencer_id);
+        }
+    }
+
+    void testAdminLanes() {
+        mobject::Admin admin(engine);
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        CPPUNIT_ASSERT_THROW_MESSAGE("a provider should not accept an unknown lane",
+                mobject::Provider(engine, 3, "{ \"lanes\" : { \"other\" : {} } }"),
+                mobject::Exception);
+
+        // admin and data RPCs run on their own xstreams
+        mobject::Provider provider(engine, 3,
+                "{ \"lanes\" : { \"admin\" : { \"xstreams\" : 1, \"priority\" : 0 },"
+                "                \"data\"  : { \"xstreams\" : 1, \"priority\" : 1 } } }");
+        mobject::UUID sequencer_id;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE("admin.createSequencer should succeed with dedicated lanes",
+                sequencer_id = admin.createSequencer(addr, 3, sequencer_type, sequencer_config));
+        auto sequencer = client.makeSequencerHandle(addr, 3, sequencer_id);
+        std::string data = "Hello World";
+        sequencer.write("myobject", 0, data.data(), data.size());
+        std::string buffer(data.size(), '\0');
+        sequencer.read("myobject", 0, &buffer[0], buffer.size());
+        CPPUNIT_ASSERT_EQUAL(data, buffer);
+        admin.destroySequencer(addr, 3, sequencer_id);
+    }
+
 };
 CPPUNIT_TEST_SUITE_REGISTRATION( AdminTest );
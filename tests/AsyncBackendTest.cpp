@@ -0,0 +1,254 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <mobject/Client.hpp>
+#include <mobject/Admin.hpp>
+#include <mobject/Provider.hpp>
+#include <mobject/Backend.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+extern thallium::engine engine;
+extern std::string sequencer_type;
+
+using json = nlohmann::json;
+
+/**
+ * Backend that executes its operations on an inner backend (of the
+ * "inner" type of its configuration) but completes the asynchronous
+ * ones "delay_ms" later, from a std::thread, the way an I/O library
+ * calls its completion callbacks from its own threads.
+ */
+class DeferredBackend : public mobject::Backend {
+
+    std::unique_ptr<mobject::Backend> m_inner;
+    std::chrono::milliseconds         m_delay;
+    std::mutex                        m_threads_mtx;
+    std::vector<std::thread>          m_threads;
+
+    template<typename T>
+    void completeLater(mobject::Completion<T> done, mobject::RequestResult<T> result) {
+        s_started += 1;
+        std::lock_guard<std::mutex> lock(m_threads_mtx);
+        m_threads.emplace_back([done, result, delay=m_delay]() {
+            std::this_thread::sleep_for(delay);
+            done(result);
+        });
+    }
+
+    public:
+
+    // number of asynchronous operations started by all the instances
+    static std::atomic<size_t> s_started;
+
+    DeferredBackend(std::unique_ptr<mobject::Backend>&& inner, std::chrono::milliseconds delay)
+    : m_inner(std::move(inner))
+    , m_delay(delay) {}
+
+    ~DeferredBackend() {
+        for(auto& t : m_threads) t.join();
+    }
+
+    void sayHello() override {
+        m_inner->sayHello();
+    }
+
+    mobject::RequestResult<int32_t> computeSum(int32_t x, int32_t y) override {
+        return m_inner->computeSum(x, y);
+    }
+
+    mobject::RequestResult<bool> write(const std::string& object, uint64_t offset,
+                                       const char* data, size_t size) override {
+        return m_inner->write(object, offset, data, size);
+    }
+
+    mobject::RequestResult<uint64_t> reserve(const std::string& object, size_t size) override {
+        return m_inner->reserve(object, size);
+    }
+
+    mobject::RequestResult<size_t> read(const std::string& object, uint64_t offset,
+                                        char* data, size_t size) override {
+        return m_inner->read(object, offset, data, size);
+    }
+
+    mobject::RequestResult<bool> remove(const std::string& object) override {
+        return m_inner->remove(object);
+    }
+
+    mobject::RequestResult<std::vector<std::string>> listObjects(
+            const std::string& prefix, const std::string& start_after, size_t max) override {
+        return m_inner->listObjects(prefix, start_after, max);
+    }
+
+    mobject::RequestResult<bool> omapSet(const std::string& object,
+            const std::vector<std::pair<std::string, std::string>>& entries) override {
+        return m_inner->omapSet(object, entries);
+    }
+
+    mobject::RequestResult<std::vector<std::pair<std::string, std::string>>> omapGet(
+            const std::string& object, const std::vector<std::string>& keys) override {
+        return m_inner->omapGet(object, keys);
+    }
+
+    mobject::RequestResult<bool> omapRemove(const std::string& object,
+            const std::vector<std::string>& keys) override {
+        return m_inner->omapRemove(object, keys);
+    }
+
+    mobject::RequestResult<std::vector<std::pair<std::string, std::string>>> omapScan(
+            const std::string& object, const std::string& prefix,
+            const std::string& start_after, size_t max) override {
+        return m_inner->omapScan(object, prefix, start_after, max);
+    }
+
+    mobject::RequestResult<uint64_t> execute(const std::string& object,
+                                             const mobject::WriteOp& op) override {
+        return m_inner->execute(object, op);
+    }
+
+    mobject::RequestResult<bool> flush() override {
+        return m_inner->flush();
+    }
+
+    // the operations run on the caller's ULT, since the inner backend
+    // may need one, and only their completion is deferred
+
+    void writeAsync(const std::string& object, uint64_t offset, const char* data, size_t size,
+                    mobject::Completion<bool> done) override {
+        completeLater(std::move(done), m_inner->write(object, offset, data, size));
+    }
+
+    void readAsync(const std::string& object, uint64_t offset, char* data, size_t size,
+                   mobject::Completion<size_t> done) override {
+        completeLater(std::move(done), m_inner->read(object, offset, data, size));
+    }
+
+    void executeAsync(const std::string& object, const mobject::WriteOp& op,
+                      mobject::Completion<uint64_t> done) override {
+        completeLater(std::move(done), m_inner->execute(object, op));
+    }
+
+    void flushAsync(mobject::Completion<bool> done) override {
+        completeLater(std::move(done), m_inner->flush());
+    }
+
+    mobject::RequestResult<bool> destroy() override {
+        return m_inner->destroy();
+    }
+
+    static std::unique_ptr<mobject::Backend> create(const thallium::engine& engine, const json& config) {
+        auto inner = mobject::SequencerFactory::createSequencer(config["inner"].get<std::string>(), engine, config);
+        return std::unique_ptr<mobject::Backend>(new DeferredBackend(
+            std::move(inner), std::chrono::milliseconds(config.value("delay_ms", 10))));
+    }
+
+    static std::unique_ptr<mobject::Backend> open(const thallium::engine& engine, const json& config) {
+        auto inner = mobject::SequencerFactory::openSequencer(config["inner"].get<std::string>(), engine, config);
+        return std::unique_ptr<mobject::Backend>(new DeferredBackend(
+            std::move(inner), std::chrono::milliseconds(config.value("delay_ms", 10))));
+    }
+};
+
+std::atomic<size_t> DeferredBackend::s_started(0);
+
+MOBJECT_REGISTER_BACKEND(deferred, DeferredBackend);
+
+class AsyncBackendTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( AsyncBackendTest );
+    CPPUNIT_TEST( testDeferredCompletions );
+    CPPUNIT_TEST( testProviderWaitsForCompletions );
+    CPPUNIT_TEST_SUITE_END();
+
+    mobject::UUID sequencer_id;
+
+    std::string makeConfig(const std::string& path, int delay_ms) {
+        return "{ \"inner\" : \"" + sequencer_type + "\", \"path\" : \"" + path + "\", "
+               "\"delay_ms\" : " + std::to_string(delay_ms) + " }";
+    }
+
+    public:
+
+    void setUp() {
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        sequencer_id = admin.createSequencer(addr, 0, "deferred", makeConfig("mydb-deferred", 10));
+    }
+
+    void tearDown() {
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        admin.destroySequencer(addr, 0, sequencer_id);
+    }
+
+    void testDeferredCompletions() {
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+
+        // concurrent writes all complete, from the backend's threads
+        const size_t num_objects = 16;
+        std::vector<std::string> data(num_objects);
+        std::vector<mobject::AsyncRequest> requests(num_objects);
+        for(size_t i = 0; i < num_objects; i++) {
+            data[i] = "content of object-" + std::to_string(100 + i);
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "my_sequencer.write() should not throw.",
+                    my_sequencer.write("object-" + std::to_string(100 + i), 0,
+                                       data[i].data(), data[i].size(), &requests[i]));
+        }
+        for(auto& request : requests)
+            CPPUNIT_ASSERT_NO_THROW(request.wait());
+
+        for(size_t i = 0; i < num_objects; i++) {
+            std::string buffer(data[i].size(), '\0');
+            size_t bytes_read = 0;
+            my_sequencer.read("object-" + std::to_string(100 + i), 0,
+                              &buffer[0], buffer.size(), &bytes_read);
+            CPPUNIT_ASSERT_EQUAL(data[i].size(), bytes_read);
+            CPPUNIT_ASSERT_EQUAL(data[i], buffer);
+        }
+
+        uint64_t version = my_sequencer.execute("object-100", mobject::WriteOp());
+        mobject::WriteOp op;
+        op.assertVersion(version).omapSet({{"key", "value"}});
+        CPPUNIT_ASSERT_EQUAL(version + 1, my_sequencer.execute("object-100", op));
+        CPPUNIT_ASSERT_NO_THROW(my_sequencer.flush());
+
+        for(size_t i = 0; i < num_objects; i++)
+            my_sequencer.remove("object-" + std::to_string(100 + i));
+    }
+
+    void testProviderWaitsForCompletions() {
+        mobject::Client client(engine);
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+
+        const size_t num_writes = 8;
+        std::string data = "content";
+        std::vector<mobject::AsyncRequest> requests(num_writes);
+        {
+            mobject::Provider other_provider(engine, 3);
+            auto other_id = admin.createSequencer(addr, 3, "deferred", makeConfig("mydb-deferred-3", 200));
+            auto other_sequencer = client.makeSequencerHandle(addr, 3, other_id);
+            size_t started = DeferredBackend::s_started;
+            for(size_t i = 0; i < num_writes; i++) {
+                other_sequencer.write("object-" + std::to_string(i), 0,
+                                      data.data(), data.size(), &requests[i]);
+            }
+            while(DeferredBackend::s_started < started + num_writes)
+                thallium::thread::sleep(engine, 1);
+            // the provider goes away while its backend still has to
+            // complete the writes, which must still be answered
+        }
+        for(auto& request : requests)
+            CPPUNIT_ASSERT_NO_THROW(request.wait());
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( AsyncBackendTest );
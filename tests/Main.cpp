@@ -48,8 +48,8 @@ int main(int argc, char** argv) {
     // Initialize the thallium server
     engine = tl::engine("na+sm", THALLIUM_SERVER_MODE);
 
-    // Initialize the Sonata provider
-    mobject::Provider provider(engine);
+    // Initialize the Mobject provider
+    mobject::Provider provider(engine, 0, "{ \"cache\" : { \"capacity\" : 1048576 } }");
 
     // Run the tests.
     bool wasSucessful = runner.run();
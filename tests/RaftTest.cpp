@@ -0,0 +1,181 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <mobject/Client.hpp>
+#include <mobject/Admin.hpp>
+#include <mobject/Provider.hpp>
+#include <algorithm>
+#include <memory>
+
+extern thallium::engine engine;
+
+class RaftTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( RaftTest );
+    CPPUNIT_TEST( testReplicatedWrites );
+    CPPUNIT_TEST( testReserve );
+    CPPUNIT_TEST( testFailover );
+    CPPUNIT_TEST( testRestart );
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr size_t num_members = 3;
+    // mobject providers holding the members (0 is created by Main.cpp)
+    std::vector<std::unique_ptr<mobject::Provider>> providers;
+    std::vector<mobject::UUID> sequencer_ids;
+    std::vector<std::string> configs;
+    std::vector<bool> alive;
+
+    public:
+
+    // small enough for the log to be compacted during the tests
+    static constexpr size_t max_log_entries = 16;
+
+    void setUp() {
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        for(size_t i = 1; i < num_members; i++)
+            providers.emplace_back(new mobject::Provider(engine, i));
+        std::string members;
+        for(size_t i = 0; i < num_members; i++) {
+            if(i != 0) members += ",";
+            members += "{ \"address\" : \"" + addr + "\", \"provider_id\" : "
+                     + std::to_string(100 + i) + " }";
+        }
+        for(size_t i = 0; i < num_members; i++) {
+            std::string config = "{ \"self\" : " + std::to_string(i) + ", \"members\" : ["
+                               + members + "], \"heartbeat_ms\" : 20, \"election_timeout_ms\" : 150, "
+                               "\"max_log_entries\" : " + std::to_string(max_log_entries) + " }";
+            sequencer_ids.push_back(admin.createSequencer(addr, i, "raft", config));
+            configs.push_back(config);
+            alive.push_back(true);
+        }
+    }
+
+    void tearDown() {
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        for(size_t i = 0; i < num_members; i++)
+            if(alive[i]) admin.destroySequencer(addr, i, sequencer_ids[i]);
+        sequencer_ids.clear();
+        configs.clear();
+        alive.clear();
+        providers.clear();
+    }
+
+    mobject::SequencerHandle member(size_t i) {
+        mobject::Client client(engine);
+        return client.makeSequencerHandle(engine.self(), i, sequencer_ids[i]);
+    }
+
+    void testReplicatedWrites() {
+        std::string data = "Hello Raft";
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "write() should be forwarded to the leader.",
+                member(0).write("myobject", 0, data.data(), data.size()));
+        member(1).omapSet("myobject", {{"key", "value"}});
+
+        // every member reads the committed state
+        for(size_t i = 0; i < num_members; i++) {
+            auto h = member(i);
+            std::string buffer(64, '\0');
+            size_t bytes_read = 0;
+            h.read("myobject", 0, &buffer[0], buffer.size(), &bytes_read);
+            buffer.resize(bytes_read);
+            CPPUNIT_ASSERT_EQUAL(data, buffer);
+            auto values = h.omapGet("myobject", {"key"});
+            CPPUNIT_ASSERT_EQUAL((size_t)1, values.size());
+            CPPUNIT_ASSERT_EQUAL(std::string("value"), values[0].second);
+            CPPUNIT_ASSERT_EQUAL((uint64_t)2, h.execute("myobject", mobject::WriteOp()));
+        }
+
+        member(2).remove("myobject");
+        CPPUNIT_ASSERT_EQUAL((size_t)0, member(0).listObjects().size());
+    }
+
+    void testReserve() {
+        // concurrent appends through all the members get disjoint ranges
+        const size_t num_records = 24;
+        std::string record = "0123456789";
+        std::vector<uint64_t> offsets(num_records);
+        std::vector<mobject::AsyncRequest> requests(num_records);
+        std::vector<mobject::SequencerHandle> handles;
+        for(size_t i = 0; i < num_members; i++)
+            handles.push_back(member(i));
+        for(size_t i = 0; i < num_records; i++)
+            handles[i % num_members].append("ids", record.data(), record.size(),
+                                            &offsets[i], &requests[i]);
+        for(auto& request : requests)
+            request.wait();
+        std::sort(offsets.begin(), offsets.end());
+        for(size_t i = 0; i < num_records; i++)
+            CPPUNIT_ASSERT_EQUAL((uint64_t)(i * record.size()), offsets[i]);
+    }
+
+    void testFailover() {
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        std::string data = "before";
+        member(1).write("myobject", 0, data.data(), data.size());
+        uint64_t offset = 0;
+        member(2).append("ids", data.data(), data.size(), &offset);
+
+        // losing any one member (possibly the leader) keeps the group available
+        admin.destroySequencer(addr, 0, sequencer_ids[0]);
+        alive[0] = false;
+
+        std::string buffer(data.size(), '\0');
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "read() should succeed after losing a member.",
+                member(2).read("myobject", 0, &buffer[0], buffer.size()));
+        CPPUNIT_ASSERT_EQUAL(data, buffer);
+        uint64_t next_offset = 0;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "append() should succeed after losing a member.",
+                member(1).append("ids", data.data(), data.size(), &next_offset));
+        CPPUNIT_ASSERT(next_offset > offset);
+    }
+
+    void testRestart() {
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        std::string record = "0123456789";
+        uint64_t last = 0;
+        for(size_t i = 0; i < 2 * max_log_entries; i++) {
+            uint64_t offset = 0;
+            member(i % num_members).append("ids", record.data(), record.size(), &offset);
+            last = std::max(last, offset);
+        }
+        member(0).omapSet("ids", {{"key", "value"}});
+        uint64_t version = member(2).execute("ids", mobject::WriteOp());
+
+        // member 1 restarts with an empty log and, the entries it needs
+        // having been discarded, catches up from a snapshot as a learner
+        admin.closeSequencer(addr, 1, sequencer_ids[1]);
+        sequencer_ids[1] = admin.openSequencer(addr, 1, "raft", configs[1]);
+        std::string buffer(record.size(), '\0');
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "read() should succeed on a restarted member.",
+                member(1).read("ids", last, &buffer[0], buffer.size()));
+        CPPUNIT_ASSERT_EQUAL(record, buffer);
+        auto values = member(1).omapGet("ids", {"key"});
+        CPPUNIT_ASSERT_EQUAL((size_t)1, values.size());
+        CPPUNIT_ASSERT_EQUAL(version, member(1).execute("ids", mobject::WriteOp()));
+
+        // once member 0 is gone, the group is made of the restarted member
+        // and member 2, which must not hand out the same offsets again
+        admin.destroySequencer(addr, 0, sequencer_ids[0]);
+        alive[0] = false;
+        for(size_t i = 0; i < 4; i++) {
+            uint64_t offset = 0;
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "append() should succeed after the restart.",
+                    member(1 + i % 2).append("ids", record.data(), record.size(), &offset));
+            CPPUNIT_ASSERT(offset > last);
+            last = offset;
+        }
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( RaftTest );
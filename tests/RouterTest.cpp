@@ -0,0 +1,132 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <mobject/Client.hpp>
+#include <mobject/Admin.hpp>
+#include <mobject/Router.hpp>
+#include <map>
+
+extern thallium::engine engine;
+extern std::string sequencer_type;
+
+class RouterTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( RouterTest );
+    CPPUNIT_TEST( testMakeRouter );
+    CPPUNIT_TEST( testBalance );
+    CPPUNIT_TEST( testAddMember );
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr const char* sequencer_config = "{ \"path\" : \"mydb\" }";
+    std::vector<mobject::UUID> sequencer_ids;
+
+    public:
+
+    void setUp() {
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        for(int i = 0; i < 5; i++)
+            sequencer_ids.push_back(admin.createSequencer(addr, 0, sequencer_type, sequencer_config));
+    }
+
+    void tearDown() {
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        for(auto& id : sequencer_ids)
+            admin.destroySequencer(addr, 0, id);
+        sequencer_ids.clear();
+    }
+
+    std::string makeConfig(size_t num_members) {
+        std::string addr = engine.self();
+        std::string members;
+        for(size_t i = 0; i < num_members; i++) {
+            if(i != 0) members += ",";
+            members += "{ \"address\" : \"" + addr + "\", \"provider_id\" : 0, "
+                       "\"sequencer_id\" : \"" + sequencer_ids[i].to_string() + "\" }";
+        }
+        return "{ \"virtual_nodes\" : 128, \"members\" : [" + members + "] }";
+    }
+
+    void testMakeRouter() {
+        mobject::Client client(engine);
+
+        mobject::Router router;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "Router constructor should not throw with a valid configuration.",
+                router = mobject::Router(client, makeConfig(3)));
+        CPPUNIT_ASSERT_EQUAL((size_t)3, router.numMembers());
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "addMember() should throw for a sequencer that is already a member.",
+                router.addMember(engine.self(), 0, sequencer_ids[0]),
+                mobject::Exception);
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "Router constructor should throw for an invalid sequencer.",
+                mobject::Router(client,
+                    "{ \"members\" : [ { \"address\" : \"" + std::string(engine.self()) + "\","
+                    "\"sequencer_id\" : \"" + mobject::UUID::generate().to_string() + "\" } ] }"),
+                mobject::Exception);
+
+        mobject::Router empty(client, "{}");
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "route() should throw on a Router without members.",
+                empty.route("myobject"),
+                mobject::Exception);
+    }
+
+    void testBalance() {
+        mobject::Client client(engine);
+        mobject::Router router(client, makeConfig(4));
+
+        std::map<std::string, int> counts;
+        for(int i = 0; i < 1000; i++) {
+            auto name = "object-" + std::to_string(i);
+            auto handle = router.route(name);
+            CPPUNIT_ASSERT(static_cast<bool>(handle));
+            handle.write(name, 0, name.data(), name.size());
+        }
+        // every object can be read back through the router, and each
+        // member holds a reasonable share of the objects
+        for(auto& id : sequencer_ids) {
+            auto h = client.makeSequencerHandle(engine.self(), 0, id);
+            counts[id.to_string()] = h.listObjects("", "", 1000).size();
+        }
+        for(size_t i = 0; i < 4; i++) {
+            int c = counts[sequencer_ids[i].to_string()];
+            CPPUNIT_ASSERT_MESSAGE("member should hold between 15% and 35% of the objects",
+                                   c >= 150 && c <= 350);
+        }
+        CPPUNIT_ASSERT_EQUAL(0, counts[sequencer_ids[4].to_string()]);
+    }
+
+    void testAddMember() {
+        mobject::Client client(engine);
+        mobject::Router router(client, makeConfig(4));
+
+        std::vector<mobject::UUID> before;
+        for(int i = 0; i < 1000; i++)
+            before.push_back(router.locate("object-" + std::to_string(i)));
+
+        router.addMember(engine.self(), 0, sequencer_ids[4]);
+
+        // only objects that now belong to the new member have moved
+        int moved = 0;
+        for(int i = 0; i < 1000; i++) {
+            auto after = router.locate("object-" + std::to_string(i));
+            if(after == before[i]) continue;
+            moved += 1;
+            CPPUNIT_ASSERT(after == sequencer_ids[4]);
+        }
+        CPPUNIT_ASSERT_MESSAGE("about a fifth of the objects should move", moved > 100 && moved < 350);
+
+        router.removeMember(sequencer_ids[4]);
+        for(int i = 0; i < 1000; i++)
+            CPPUNIT_ASSERT(router.locate("object-" + std::to_string(i)) == before[i]);
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( RouterTest );
@@ -6,6 +6,9 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <mobject/Client.hpp>
 #include <mobject/Admin.hpp>
+#include <mobject/Provider.hpp>
+#include <algorithm>
+#include <limits>
 
 extern thallium::engine engine;
 extern std::string sequencer_type;
@@ -16,6 +19,28 @@ class SequencerTest : public CppUnit::TestFixture
     CPPUNIT_TEST( testMakeSequencerHandle );
     CPPUNIT_TEST( testSayHello );
     CPPUNIT_TEST( testComputeSum );
+    CPPUNIT_TEST( testComputeSumArray );
+    CPPUNIT_TEST( testWriteRead );
+    CPPUNIT_TEST( testWriteBack );
+    CPPUNIT_TEST( testListObjects );
+    CPPUNIT_TEST( testOmap );
+    CPPUNIT_TEST( testWriteOp );
+    CPPUNIT_TEST( testAppend );
+    CPPUNIT_TEST( testTruncatedAppend );
+    CPPUNIT_TEST( testRetriedAppend );
+    CPPUNIT_TEST( testGappedAppend );
+    CPPUNIT_TEST( testGappedContended );
+    CPPUNIT_TEST( testMigrate );
+    CPPUNIT_TEST( testWatch );
+    CPPUNIT_TEST( testTimestamps );
+    CPPUNIT_TEST( testTimeouts );
+    CPPUNIT_TEST( testExpiredRequest );
+    CPPUNIT_TEST( testRetries );
+    CPPUNIT_TEST( testHedgedRead );
+    CPPUNIT_TEST( testAdmission );
+    CPPUNIT_TEST( testPriorities );
+    CPPUNIT_TEST( testTenants );
+    CPPUNIT_TEST( testPosted );
     CPPUNIT_TEST_SUITE_END();
 
     static constexpr const char* sequencer_config = "{ \"path\" : \"mydb\" }";
@@ -103,5 +128,1119 @@ class SequencerTest : public CppUnit::TestFixture
                 request.wait());
     }
 
+    void testComputeSumArray() {
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+
+        // an odd size, so that the kernels also handle a partial vector
+        const size_t count = 1001;
+        std::vector<int32_t> x(count), y(count), result(count, 0);
+        for(size_t i = 0; i < count; i++) {
+            x[i] = static_cast<int32_t>(i * 7) - 3000;
+            y[i] = 42 - static_cast<int32_t>(i);
+        }
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_sequencer.computeSumArray() should not throw.",
+                my_sequencer.computeSumArray(x.data(), y.data(), result.data(), count));
+        for(size_t i = 0; i < count; i++)
+            CPPUNIT_ASSERT_EQUAL(x[i] + y[i], result[i]);
+
+        std::fill(result.begin(), result.end(), 0);
+        mobject::AsyncRequest request;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_sequencer.computeSumArray() should not throw when called asynchronously.",
+                my_sequencer.computeSumArray(x.data(), y.data(), result.data(), count, &request));
+        CPPUNIT_ASSERT_NO_THROW(request.wait());
+        CPPUNIT_ASSERT_EQUAL(x[count-1] + y[count-1], result[count-1]);
+
+        x[count/2] = std::numeric_limits<int32_t>::max();
+        y[count/2] = 1;
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "my_sequencer.computeSumArray() should throw when a sum overflows.",
+                my_sequencer.computeSumArray(x.data(), y.data(), result.data(), count),
+                mobject::Exception);
+    }
+
+    void testWriteRead() {
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+
+        std::string data = "Hello World";
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_sequencer.write() should not throw.",
+                my_sequencer.write("myobject", 0, data.data(), data.size()));
+
+        // read twice, the second read should be served by the provider's cache
+        for(int i = 0; i < 2; i++) {
+            std::string buffer(64, '\0');
+            size_t bytes_read = 0;
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "my_sequencer.read() should not throw.",
+                    my_sequencer.read("myobject", 0, &buffer[0], buffer.size(), &bytes_read));
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(
+                    "read should be short at the end of the object",
+                    data.size(), bytes_read);
+            buffer.resize(bytes_read);
+            CPPUNIT_ASSERT_EQUAL(data, buffer);
+        }
+
+        // overwrite part of the object, the cache must not return stale data
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_sequencer.write() should not throw.",
+                my_sequencer.write("myobject", 6, "Mochi", 5));
+        std::string buffer(11, '\0');
+        mobject::AsyncRequest request;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_sequencer.read() should not throw when called asynchronously.",
+                my_sequencer.read("myobject", 0, &buffer[0], buffer.size(), nullptr, &request));
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "request.wait() should not throw.",
+                request.wait());
+        CPPUNIT_ASSERT_EQUAL(std::string("Hello Mochi"), buffer);
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_sequencer.remove() should not throw.",
+                my_sequencer.remove("myobject"));
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "my_sequencer.read() should throw on a removed object.",
+                my_sequencer.read("myobject", 0, &buffer[0], buffer.size()),
+                mobject::Exception);
+
+        // a provider that rejects requests of more than 8 bytes, and whose
+        // cache is smaller than its number of shards
+        mobject::Admin admin(engine);
+        mobject::Provider limited_provider(engine, 2,
+            "{ \"limits\" : { \"max_request_size\" : 8 },"
+            "  \"cache\" : { \"capacity\" : 4, \"block_size\" : 4, \"shards\" : 16 } }");
+        auto limited_id = admin.createSequencer(addr, 2, sequencer_type, sequencer_config);
+        auto limited = client.makeSequencerHandle(addr, 2, limited_id);
+        CPPUNIT_ASSERT_NO_THROW(limited.write("myobject", 0, "Mochi", 5));
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "writes larger than max_request_size should be rejected.",
+                limited.write("myobject", 0, "Hello Mochi", 11),
+                mobject::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "reads larger than max_request_size should be rejected.",
+                limited.read("myobject", 0, &buffer[0], buffer.size()),
+                mobject::Exception);
+        for(int i = 0; i < 2; i++) {
+            std::string small(5, '\0');
+            CPPUNIT_ASSERT_NO_THROW(limited.read("myobject", 0, &small[0], small.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("Mochi"), small);
+        }
+        admin.destroySequencer(addr, 2, limited_id);
+    }
+
+    void testWriteBack() {
+        mobject::Admin admin(engine);
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        auto buffered_id = admin.createSequencer(addr, 0, sequencer_type,
+            "{ \"write_back\" : { \"max_size\" : 65536, \"max_age_ms\" : 60000 } }");
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, buffered_id);
+
+        // many small sequential writes, absorbed by the write-back buffer
+        std::string expected;
+        for(int i = 0; i < 100; i++) {
+            std::string record = "record" + std::to_string(i) + ";";
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "my_sequencer.write() should not throw.",
+                    my_sequencer.write("log", expected.size(), record.data(), record.size()));
+            expected += record;
+        }
+
+        // read-after-write must see the buffered data
+        std::string buffer(expected.size(), '\0');
+        size_t bytes_read = 0;
+        my_sequencer.read("log", 0, &buffer[0], buffer.size(), &bytes_read);
+        CPPUNIT_ASSERT_EQUAL(expected.size(), bytes_read);
+        CPPUNIT_ASSERT_EQUAL(expected, buffer);
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_sequencer.flush() should not throw.",
+                my_sequencer.flush());
+
+        std::string after_flush(expected.size(), '\0');
+        my_sequencer.read("log", 0, &after_flush[0], after_flush.size(), &bytes_read);
+        CPPUNIT_ASSERT_EQUAL(expected, after_flush);
+
+        admin.destroySequencer(addr, 0, buffered_id);
+    }
+
+    void testListObjects() {
+        mobject::Client client(engine);
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        // a provider returning at most 3 names per RPC, and a sequencer
+        // of its own so that no other test's objects get listed
+        mobject::Provider list_provider(engine, 2, "{ \"limits\" : { \"max_list_page\" : 3 } }");
+        auto list_id = admin.createSequencer(addr, 2, sequencer_type, sequencer_config);
+
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 2, list_id);
+
+        for(int i = 9; i >= 0; i--) {
+            std::string name = "dir/obj" + std::to_string(i);
+            my_sequencer.write(name, 0, name.data(), name.size());
+        }
+        my_sequencer.write("other", 0, "x", 1);
+
+        // page through the "dir/" prefix 4 names at a time
+        std::vector<std::string> all, page;
+        std::string last;
+        do {
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "my_sequencer.listObjects() should not throw.",
+                    page = my_sequencer.listObjects("dir/", last, 4));
+            CPPUNIT_ASSERT(page.size() <= 4);
+            all.insert(all.end(), page.begin(), page.end());
+            if(!page.empty()) last = page.back();
+        } while(!page.empty());
+
+        CPPUNIT_ASSERT_EQUAL((size_t)10, all.size());
+        for(int i = 0; i < 10; i++)
+            CPPUNIT_ASSERT_EQUAL("dir/obj" + std::to_string(i), all[i]);
+
+        all = my_sequencer.listObjects();
+        CPPUNIT_ASSERT_EQUAL((size_t)11, all.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("other"), all.back());
+
+        admin.destroySequencer(addr, 2, list_id);
+    }
+
+    void testOmap() {
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+
+        using Entries = std::vector<std::pair<std::string, std::string>>;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_sequencer.omapSet() should not throw.",
+                my_sequencer.omapSet("myobject", Entries{
+                    {"owner", "alice"}, {"attr.b", "2"}, {"attr.a", "1"}, {"attr.c", "3"}}));
+        my_sequencer.omapSet("myobject", Entries{{"owner", "bob"}});
+
+        Entries values = my_sequencer.omapGet("myobject", {"owner", "missing", "attr.a"});
+        CPPUNIT_ASSERT((values == Entries{{"attr.a", "1"}, {"owner", "bob"}}));
+
+        Entries scan = my_sequencer.omapScan("myobject", "attr.", "attr.a", 10);
+        CPPUNIT_ASSERT((scan == Entries{{"attr.b", "2"}, {"attr.c", "3"}}));
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_sequencer.omapRemove() should not throw.",
+                my_sequencer.omapRemove("myobject", {"attr.b", "owner"}));
+        scan = my_sequencer.omapScan("myobject");
+        CPPUNIT_ASSERT((scan == Entries{{"attr.a", "1"}, {"attr.c", "3"}}));
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "my_sequencer.omapGet() should throw on an unknown object.",
+                my_sequencer.omapGet("unknown", {"owner"}),
+                mobject::Exception);
+    }
+
+    void testWriteOp() {
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+
+        mobject::WriteOp create_op;
+        create_op.create(true)
+                 .write(0, "Hello World")
+                 .omapSet({{"state", "new"}});
+        uint64_t version = 0;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_sequencer.execute() should not throw.",
+                version = my_sequencer.execute("myobject", create_op));
+        CPPUNIT_ASSERT_EQUAL((uint64_t)1, version);
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "exclusive create should fail on an existing object.",
+                my_sequencer.execute("myobject", create_op),
+                mobject::Exception);
+
+        // compare-and-set: only the update based on the current version succeeds
+        mobject::WriteOp update_op;
+        update_op.assertVersion(version)
+                 .truncate(5)
+                 .write(5, " Mochi")
+                 .omapSet({{"state", "updated"}});
+        CPPUNIT_ASSERT_EQUAL((uint64_t)2, my_sequencer.execute("myobject", update_op));
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "execute() should fail on a version mismatch.",
+                my_sequencer.execute("myobject", update_op),
+                mobject::Exception);
+
+        std::string buffer(64, '\0');
+        size_t bytes_read = 0;
+        my_sequencer.read("myobject", 0, &buffer[0], buffer.size(), &bytes_read);
+        buffer.resize(bytes_read);
+        CPPUNIT_ASSERT_EQUAL(std::string("Hello Mochi"), buffer);
+        auto values = my_sequencer.omapGet("myobject", {"state"});
+        CPPUNIT_ASSERT_EQUAL((size_t)1, values.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("updated"), values[0].second);
+
+        my_sequencer.remove("myobject");
+    }
+
+    void testAppend() {
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+
+        // concurrent appenders each get their own, non-overlapping range
+        const size_t num_records = 16;
+        std::vector<std::string> records(num_records);
+        std::vector<uint64_t> offsets(num_records);
+        std::vector<mobject::AsyncRequest> requests(num_records);
+        for(size_t i = 0; i < num_records; i++) {
+            records[i] = "record-" + std::to_string(100 + i) + ";";
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "my_sequencer.append() should not throw.",
+                    my_sequencer.append("log", records[i].data(), records[i].size(),
+                                        &offsets[i], &requests[i]));
+        }
+        for(auto& request : requests)
+            request.wait();
+
+        std::vector<uint64_t> sorted(offsets);
+        std::sort(sorted.begin(), sorted.end());
+        for(size_t i = 0; i < num_records; i++)
+            CPPUNIT_ASSERT_EQUAL((uint64_t)(i * records[0].size()), sorted[i]);
+
+        for(size_t i = 0; i < num_records; i++) {
+            std::string buffer(records[i].size(), '\0');
+            my_sequencer.read("log", offsets[i], &buffer[0], buffer.size());
+            CPPUNIT_ASSERT_EQUAL(records[i], buffer);
+        }
+
+        my_sequencer.remove("log");
+    }
+
+    void testTruncatedAppend() {
+        mobject::Admin admin(engine);
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        // offsets handed out before a truncation are never handed out
+        // again, whether appends go straight to the backend, through the
+        // write-back buffer, or through per-xstream ranges
+        std::vector<std::string> configs = {
+            "{}",
+            "{ \"write_back\" : { \"max_size\" : 65536, \"max_age_ms\" : 60000 } }",
+            "{ \"gapped\" : { \"range_size\" : 64 } }"
+        };
+        std::string record = "record;";
+        for(auto& config : configs) {
+            auto id = admin.createSequencer(addr, 0, sequencer_type, config);
+            mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, id);
+
+            uint64_t first = 0, second = 0, third = 0;
+            my_sequencer.append("log", record.data(), record.size(), &first);
+            my_sequencer.append("log", record.data(), record.size(), &second);
+            my_sequencer.execute("log", mobject::WriteOp().truncate(first));
+            my_sequencer.append("log", record.data(), record.size(), &third);
+            CPPUNIT_ASSERT(third >= second + record.size());
+
+            // the truncated record is gone and the new one is readable
+            std::string buffer(record.size(), '\0');
+            size_t bytes_read = 1;
+            my_sequencer.read("log", second, &buffer[0], buffer.size(), &bytes_read);
+            CPPUNIT_ASSERT(bytes_read < record.size() || buffer != record);
+            my_sequencer.read("log", third, &buffer[0], buffer.size(), &bytes_read);
+            CPPUNIT_ASSERT_EQUAL(record.size(), bytes_read);
+            CPPUNIT_ASSERT_EQUAL(record, buffer);
+
+            admin.destroySequencer(addr, 0, id);
+        }
+    }
+
+    void testRetriedAppend() {
+        mobject::Client client(engine);
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        mobject::Provider other_provider(engine, 1);
+
+        // attempts time out while the provider is still executing them,
+        // so that retries arrive both after and during the execution of
+        // the original request, and after the sequencer migrated
+        client.setTimeout(std::chrono::milliseconds(30000));
+        client.setRetryPolicy(1000, std::chrono::milliseconds(2), std::chrono::milliseconds(1));
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+
+        const size_t num_records = 32;
+        const size_t record_size = 256 * 1024;
+        std::vector<std::string> records(num_records);
+        std::vector<uint64_t> offsets(num_records);
+        std::vector<mobject::AsyncRequest> requests(num_records);
+        for(size_t i = 0; i < num_records; i++) {
+            records[i] = std::string(record_size, (char)('a' + i % 26));
+            records[i].replace(0, 4, std::to_string(1000 + i));
+            my_sequencer.append("log", records[i].data(), record_size,
+                                &offsets[i], &requests[i]);
+            if(i == num_records / 2)
+                admin.migrateSequencer(addr, 0, sequencer_id, addr, 1);
+        }
+        std::vector<bool> succeeded(num_records, false);
+        for(size_t i = 0; i < num_records; i++) {
+            try {
+                requests[i].wait();
+                succeeded[i] = true;
+            } catch(const mobject::Exception&) {}
+        }
+
+        // each record is in the log at most once, and the records whose
+        // append succeeded are at the offset they were given
+        std::string log((num_records + 1) * record_size, '\0');
+        size_t bytes_read = 0;
+        my_sequencer.read("log", 0, &log[0], log.size(), &bytes_read);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, bytes_read % record_size);
+        CPPUNIT_ASSERT(bytes_read <= num_records * record_size);
+        std::vector<size_t> copies(num_records, 0);
+        for(size_t offset = 0; offset < bytes_read; offset += record_size) {
+            size_t i = std::stoul(log.substr(offset, 4)) - 1000;
+            CPPUNIT_ASSERT(i < num_records);
+            CPPUNIT_ASSERT(log.compare(offset, record_size, records[i]) == 0);
+            copies[i] += 1;
+        }
+        for(size_t i = 0; i < num_records; i++) {
+            CPPUNIT_ASSERT(copies[i] <= 1);
+            if(succeeded[i]) {
+                CPPUNIT_ASSERT_EQUAL((size_t)1, copies[i]);
+                CPPUNIT_ASSERT(log.compare(offsets[i], record_size, records[i]) == 0);
+            }
+        }
+
+        // move the sequencer back so that tearDown() can destroy it
+        admin.migrateSequencer(addr, 1, sequencer_id, addr, 0);
+        my_sequencer.remove("log");
+    }
+
+    void testGappedAppend() {
+        mobject::Client client(engine);
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+
+        auto gapped_id = admin.createSequencer(addr, 0, sequencer_type,
+                "{ \"gapped\" : { \"range_size\" : 64 } }");
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, gapped_id);
+
+        // ranges are unique but may leave holes between them
+        const size_t num_records = 32;
+        std::vector<std::string> records(num_records);
+        std::vector<uint64_t> offsets(num_records);
+        std::vector<mobject::AsyncRequest> requests(num_records);
+        for(size_t i = 0; i < num_records; i++) {
+            records[i] = "record-" + std::to_string(100 + i) + ";";
+            my_sequencer.append("log", records[i].data(), records[i].size(),
+                                &offsets[i], &requests[i]);
+        }
+        for(auto& request : requests)
+            request.wait();
+
+        std::vector<uint64_t> sorted(offsets);
+        std::sort(sorted.begin(), sorted.end());
+        for(size_t i = 1; i < num_records; i++)
+            CPPUNIT_ASSERT(sorted[i] >= sorted[i-1] + records[0].size());
+
+        for(size_t i = 0; i < num_records; i++) {
+            std::string buffer(records[i].size(), '\0');
+            my_sequencer.read("log", offsets[i], &buffer[0], buffer.size());
+            CPPUNIT_ASSERT_EQUAL(records[i], buffer);
+        }
+
+        // after a removal, the object starts over from 0
+        my_sequencer.remove("log");
+        uint64_t offset = 1;
+        my_sequencer.append("log", records[0].data(), records[0].size(), &offset);
+        CPPUNIT_ASSERT_EQUAL((uint64_t)0, offset);
+
+        admin.destroySequencer(addr, 0, gapped_id);
+    }
+
+    void testGappedContended() {
+        mobject::Client client(engine);
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        // appends are served by several xstreams, hence from several slots
+        mobject::Provider gapped_provider(engine, 2,
+                "{ \"lanes\" : { \"data\" : { \"xstreams\" : 4 } } }");
+        auto gapped_id = admin.createSequencer(addr, 2, sequencer_type,
+                "{ \"gapped\" : { \"range_size\" : 64 } }");
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 2, gapped_id);
+
+        const size_t num_records = 256;
+        std::string record = "record;";
+        std::vector<uint64_t> offsets(num_records);
+        std::vector<mobject::AsyncRequest> requests(num_records);
+        for(size_t i = 0; i < num_records; i++)
+            my_sequencer.append("log", record.data(), record.size(), &offsets[i], &requests[i]);
+        for(auto& request : requests)
+            request.wait();
+        std::sort(offsets.begin(), offsets.end());
+        for(size_t i = 1; i < num_records; i++)
+            CPPUNIT_ASSERT(offsets[i] >= offsets[i-1] + record.size());
+
+        // removals racing with appends on all the xstreams
+        for(int round = 0; round < 8; round++) {
+            auto remover = thallium::xstream::self().make_thread([&my_sequencer]() {
+                my_sequencer.remove("log");
+            });
+            for(size_t i = 0; i < num_records; i++)
+                my_sequencer.append("log", record.data(), record.size(), &offsets[i], &requests[i]);
+            for(auto& request : requests)
+                request.wait();
+            remover->join();
+        }
+
+        // no range obtained before the last removal survives it
+        my_sequencer.remove("log");
+        uint64_t offset = 1;
+        my_sequencer.append("log", record.data(), record.size(), &offset);
+        CPPUNIT_ASSERT_EQUAL((uint64_t)0, offset);
+
+        admin.destroySequencer(addr, 2, gapped_id);
+    }
+
+    void testMigrate() {
+        mobject::Client client(engine);
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        mobject::Provider other_provider(engine, 1);
+
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+
+        const size_t num_objects = 32;
+        for(size_t i = 0; i < num_objects; i++) {
+            std::string name = "object-" + std::to_string(100 + i);
+            std::string data = "content of " + name;
+            my_sequencer.write(name, 0, data.data(), data.size());
+        }
+        my_sequencer.omapSet("object-100", {{"key", "value"}});
+        uint64_t version = my_sequencer.execute("object-100", mobject::WriteOp());
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "admin.migrateSequencer() should not throw.",
+                admin.migrateSequencer(addr, 0, sequencer_id, addr, 1));
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "admin.migrateSequencer() should throw on a sequencer that moved.",
+                admin.migrateSequencer(addr, 0, sequencer_id, addr, 1),
+                mobject::Exception);
+
+        // the handle created before the migration follows the redirection
+        CPPUNIT_ASSERT_EQUAL(num_objects, my_sequencer.listObjects("object-").size());
+        for(size_t i = 0; i < num_objects; i++) {
+            std::string name = "object-" + std::to_string(100 + i);
+            std::string buffer(64, '\0');
+            size_t bytes_read = 0;
+            my_sequencer.read(name, 0, &buffer[0], buffer.size(), &bytes_read);
+            buffer.resize(bytes_read);
+            CPPUNIT_ASSERT_EQUAL("content of " + name, buffer);
+        }
+        auto values = my_sequencer.omapGet("object-100", {"key"});
+        CPPUNIT_ASSERT_EQUAL((size_t)1, values.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("value"), values[0].second);
+
+        // versions are preserved, so compare-and-set keeps working
+        mobject::WriteOp op;
+        op.assertVersion(version).omapSet({{"key", "new value"}});
+        CPPUNIT_ASSERT_EQUAL(version + 1, my_sequencer.execute("object-100", op));
+
+        // move the sequencer back so that tearDown() can destroy it
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "admin.migrateSequencer() should not throw.",
+                admin.migrateSequencer(addr, 1, sequencer_id, addr, 0));
+        values = my_sequencer.omapGet("object-100", {"key"});
+        CPPUNIT_ASSERT_EQUAL(std::string("new value"), values[0].second);
+
+        for(size_t i = 0; i < num_objects; i++)
+            my_sequencer.remove("object-" + std::to_string(100 + i));
+    }
+
+    void testWatch() {
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+
+        std::string data = "Hello Mochi";
+        my_sequencer.write("myobject", 0, data.data(), data.size());
+        uint64_t version = my_sequencer.execute("myobject", mobject::WriteOp());
+
+        // nothing changes: the call times out with no result
+        auto changed = my_sequencer.watch({{"myobject", version}}, 50);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, changed.size());
+
+        // an outdated version is reported immediately
+        changed = my_sequencer.watch({{"myobject", version - 1}, {"otherobject", 0}}, 10000);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, changed.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("myobject"), changed[0].first);
+        CPPUNIT_ASSERT_EQUAL(version, changed[0].second);
+
+        // a modification made while waiting wakes up the watcher
+        auto writer = thallium::xstream::self().make_thread([&my_sequencer]() {
+            thallium::thread::sleep(engine, 20);
+            my_sequencer.omapSet("otherobject", {{"key", "value"}});
+        });
+        changed = my_sequencer.watch({{"myobject", version}, {"otherobject", 0}}, 10000);
+        writer->join();
+        CPPUNIT_ASSERT_EQUAL((size_t)1, changed.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("otherobject"), changed[0].first);
+        CPPUNIT_ASSERT(changed[0].second != 0);
+
+        // a short timeout expires without the dispatcher spinning
+        changed = my_sequencer.watch({{"myobject", version}}, 1);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, changed.size());
+
+        // the number of objects in a watch request is bounded
+        std::vector<std::pair<std::string, uint64_t>> many;
+        for(size_t i = 0; i < 1025; i++)
+            many.emplace_back("object-" + std::to_string(i), 0);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "my_sequencer.watch() should throw with too many objects.",
+                my_sequencer.watch(many, 10),
+                mobject::Exception);
+
+        my_sequencer.remove("myobject");
+        my_sequencer.remove("otherobject");
+    }
+
+    void testTimestamps() {
+        mobject::Client client(engine);
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+
+        // the sequencer created by setUp() is not a timestamp oracle
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "my_sequencer.timestamps() should throw on a sequencer without \"timestamps\".",
+                my_sequencer.timestamps(),
+                mobject::Exception);
+
+        auto oracle_id = admin.createSequencer(addr, 0, sequencer_type,
+                "{ \"timestamps\" : { \"window_ms\" : 100 } }");
+        mobject::SequencerHandle oracle = client.makeSequencerHandle(addr, 0, oracle_id);
+
+        // timestamps keep increasing, including across bound updates
+        uint64_t last = 0;
+        for(size_t i = 0; i < 64; i++) {
+            size_t count = 1 + (i % 4) * 1000;
+            uint64_t first = 0;
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "oracle.timestamps() should not throw.",
+                    first = oracle.timestamps(count));
+            CPPUNIT_ASSERT(first > last);
+            last = first + count - 1;
+            if(i % 16 == 0) thallium::thread::sleep(engine, 50);
+        }
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "oracle.timestamps(0) should throw.",
+                oracle.timestamps(0),
+                mobject::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "oracle.timestamps() should throw above max_count.",
+                oracle.timestamps(SIZE_MAX),
+                mobject::Exception);
+
+        // the object holding the bound is hidden and protected
+        CPPUNIT_ASSERT_EQUAL((size_t)0, oracle.listObjects().size());
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "oracle.remove() should throw on the oracle's object.",
+                oracle.remove("__timestamp_oracle__"),
+                mobject::Exception);
+        uint64_t after = oracle.timestamps();
+        CPPUNIT_ASSERT(after > last);
+
+        admin.destroySequencer(addr, 0, oracle_id);
+    }
+
+    void testTimeouts() {
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        // requests complete normally when they meet their deadline,
+        // including retried appends, which must not be executed twice
+        client.setTimeout(std::chrono::milliseconds(5000));
+        client.setRetryPolicy(3, std::chrono::milliseconds(2000));
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+
+        std::string record = "record;";
+        uint64_t offset0 = 1, offset1 = 0;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_sequencer.append() should not throw.",
+                my_sequencer.append("log", record.data(), record.size(), &offset0));
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_sequencer.append() should not throw.",
+                my_sequencer.append("log", record.data(), record.size(), &offset1));
+        CPPUNIT_ASSERT_EQUAL((uint64_t)0, offset0);
+        CPPUNIT_ASSERT_EQUAL((uint64_t)record.size(), offset1);
+
+        auto short_lived = my_sequencer.withTimeout(std::chrono::milliseconds(1000));
+        std::string buffer(record.size(), '\0');
+        size_t bytes_read = 0;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "short_lived.read() should not throw.",
+                short_lived.read("log", offset1, &buffer[0], buffer.size(), &bytes_read));
+        CPPUNIT_ASSERT_EQUAL(record.size(), bytes_read);
+        CPPUNIT_ASSERT_EQUAL(record, buffer);
+
+        my_sequencer.remove("log");
+    }
+
+    void testExpiredRequest() {
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+
+        mobject::SequencerHandle my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+
+        // the deadline of the append has passed when the provider is done
+        // pulling its data, so the provider drops it instead of applying it
+        std::string record(64 * 1024 * 1024, 'x');
+        auto expired = my_sequencer.withTimeout(std::chrono::milliseconds(1));
+        mobject::AsyncRequest request;
+        expired.append("log", record.data(), record.size(), nullptr, &request);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "request.wait() should throw on an expired append.",
+                request.wait(),
+                mobject::Exception);
+        thallium::thread::sleep(engine, 1000);
+
+        uint64_t offset = 1;
+        my_sequencer.append("log", "record;", 7, &offset);
+        CPPUNIT_ASSERT_EQUAL((uint64_t)0, offset);
+
+        my_sequencer.remove("log");
+    }
+
+    void testRetries() {
+        mobject::Admin admin(engine);
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+        using clock = std::chrono::steady_clock;
+
+        // a provider whose data lane runs on a pool without xstream never
+        // answers, so that every attempt times out; each scenario runs for
+        // its own tenant, so that its attempts can be counted once the
+        // pool is served
+        auto pool = thallium::pool::create(thallium::pool::access::mpmc);
+        std::vector<thallium::managed<thallium::xstream>> xstreams;
+        {
+            mobject::Provider slow_provider(engine, 2,
+                "{ \"lanes\" : { \"admin\" : { \"xstreams\" : 1 }, \"control\" : { \"xstreams\" : 1 } },"
+                "  \"admission\" : { \"tenants\" : { \"single\" : {}, \"retried\" : {}, \"bounded\" : {} } } }",
+                *pool);
+            auto slow_id = admin.createSequencer(addr, 2, sequencer_type, sequencer_config);
+            auto slow_sequencer = client.makeSequencerHandle(addr, 2, slow_id, false);
+            client.setTimeout(std::chrono::milliseconds(10000));
+
+            // without retries, the call fails after its single attempt
+            client.setTenant("single");
+            client.setRetryPolicy(0, std::chrono::milliseconds(200), std::chrono::milliseconds(1));
+            auto start = clock::now();
+            CPPUNIT_ASSERT_THROW(slow_sequencer.computeSum(1, 2, nullptr), mobject::Exception);
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start);
+            CPPUNIT_ASSERT(elapsed.count() >= 200);
+
+            // with 2 retries, after its third attempt
+            client.setTenant("retried");
+            client.setRetryPolicy(2, std::chrono::milliseconds(200), std::chrono::milliseconds(1));
+            start = clock::now();
+            CPPUNIT_ASSERT_THROW(slow_sequencer.computeSum(1, 2, nullptr), mobject::Exception);
+            elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start);
+            CPPUNIT_ASSERT(elapsed.count() >= 600);
+
+            // retries and their backoff stop at the deadline of the call,
+            // which leaves room for 2 or 3 attempts out of 101
+            client.setTenant("bounded");
+            client.setTimeout(std::chrono::milliseconds(500));
+            client.setRetryPolicy(100, std::chrono::milliseconds(200), std::chrono::milliseconds(50));
+            start = clock::now();
+            CPPUNIT_ASSERT_THROW(slow_sequencer.computeSum(1, 2, nullptr), mobject::Exception);
+            elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start);
+            CPPUNIT_ASSERT(elapsed.count() >= 400);
+
+            // serve the attempts that piled up (the provider only sets their
+            // deadlines when it gets to them), then a call that comes after
+            // all of them in the pool
+            xstreams.push_back(thallium::xstream::create(
+                thallium::scheduler::predef::basic_wait, *pool));
+            client.setTenant("");
+            client.setTimeout(std::chrono::milliseconds(10000));
+            client.setRetryPolicy(0, std::chrono::milliseconds(0), std::chrono::milliseconds(1));
+            CPPUNIT_ASSERT_NO_THROW(slow_sequencer.computeSum(1, 2, nullptr));
+
+            auto stats = nlohmann::json::parse(admin.getStatistics(addr, 2));
+            auto& tenants = stats["admission"]["tenants"];
+            CPPUNIT_ASSERT_EQUAL(1, tenants["single"]["admitted"].get<int>());
+            CPPUNIT_ASSERT_EQUAL(3, tenants["retried"]["admitted"].get<int>());
+            auto bounded = tenants["bounded"]["admitted"].get<int>();
+            CPPUNIT_ASSERT(bounded >= 2 && bounded <= 3);
+
+            admin.destroySequencer(addr, 2, slow_id);
+        }
+    }
+
+    void testHedgedRead() {
+        mobject::Admin admin(engine);
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+        mobject::Provider backup_provider(engine, 1);
+
+        std::string config = "{ \"path\" : \"mydb\", \"replication\" : { \"backups\" : "
+                             "[ { \"address\" : \"" + addr + "\", \"provider_id\" : 1 } ] } }";
+        auto replicated_id = admin.createSequencer(addr, 0, sequencer_type, config);
+        auto primary = client.makeSequencerHandle(addr, 0, replicated_id);
+        std::string data = "Hello World";
+        primary.write("myobject", 0, data.data(), data.size());
+
+        // the backup serves reads from its replica
+        auto replica = client.makeSequencerHandle(addr, 1, replicated_id, false);
+        std::string buffer(data.size(), '\0');
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "replica.read() should not throw.",
+                replica.read("myobject", 0, &buffer[0], buffer.size()));
+        CPPUNIT_ASSERT_EQUAL(data, buffer);
+
+        // with a delay of 0, reads are hedged as soon as enough
+        // latencies have been observed, and must return the same data
+        client.setHedgingPolicy(50, std::chrono::milliseconds(0));
+        auto hedged = primary.withReplicas({{addr, 1}});
+        for(unsigned i = 0; i < 64; i++) {
+            std::string buffer(data.size(), '\0');
+            size_t bytes_read = 0;
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "hedged.read() should not throw.",
+                    hedged.read("myobject", 0, &buffer[0], buffer.size(), &bytes_read));
+            CPPUNIT_ASSERT_EQUAL(data.size(), bytes_read);
+            CPPUNIT_ASSERT_EQUAL(data, buffer);
+        }
+
+        // reads sent to a provider that never answers (its pool has no
+        // xstream) only complete, before the deadline of the call, if they
+        // are hedged and served by the replica
+        auto pool = thallium::pool::create(thallium::pool::access::mpmc);
+        std::vector<thallium::managed<thallium::xstream>> xstreams;
+        {
+            mobject::Provider slow_provider(engine, 2, "", *pool);
+            auto slow = client.makeSequencerHandle(addr, 2, replicated_id, false).withReplicas({{addr, 1}});
+            client.setTimeout(std::chrono::milliseconds(5000));
+            for(unsigned i = 0; i < 4; i++) {
+                std::string buffer(data.size(), '\0');
+                size_t bytes_read = 0;
+                CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                        "reads from a slow provider should be served by the replica.",
+                        slow.read("myobject", 0, &buffer[0], buffer.size(), &bytes_read));
+                CPPUNIT_ASSERT_EQUAL(data.size(), bytes_read);
+                CPPUNIT_ASSERT_EQUAL(data, buffer);
+            }
+
+            // once served, the provider answers the reads it was sent
+            // (it does not have the sequencer) before the one sent last
+            xstreams.push_back(thallium::xstream::create(
+                thallium::scheduler::predef::basic_wait, *pool));
+            client.setHedgingPolicy(0);
+            std::string buffer(data.size(), '\0');
+            CPPUNIT_ASSERT_THROW(
+                    slow.read("myobject", 0, &buffer[0], buffer.size()),
+                    mobject::Exception);
+        }
+
+        admin.destroySequencer(addr, 0, replicated_id);
+    }
+
+    void testAdmission() {
+        mobject::Admin admin(engine);
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+        // a provider that executes one request at a time and queues one
+        mobject::Provider busy_provider(engine, 2,
+            "{ \"admission\" : { \"max_in_flight\" : 1, \"max_queued\" : 1, \"retry_after_ms\" : 5 } }");
+
+        auto busy_id = admin.createSequencer(addr, 2, sequencer_type, sequencer_config);
+        auto my_sequencer = client.makeSequencerHandle(addr, 2, busy_id);
+
+        // requests rejected because the provider is busy are sent
+        // again by the client, and eventually all succeed
+        const size_t num_records = 16;
+        std::vector<std::string> records(num_records);
+        std::vector<mobject::AsyncRequest> requests(num_records);
+        for(size_t i = 0; i < num_records; i++) {
+            records[i] = "record-" + std::to_string(100 + i) + ";";
+            my_sequencer.append("log", records[i].data(), records[i].size(),
+                                nullptr, &requests[i]);
+        }
+        for(auto& request : requests) {
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "appends should succeed despite the admission limits.",
+                    request.wait());
+        }
+        std::string buffer(num_records * records[0].size(), '\0');
+        size_t bytes_read = 0;
+        my_sequencer.read("log", 0, &buffer[0], buffer.size(), &bytes_read);
+        CPPUNIT_ASSERT_EQUAL(buffer.size(), bytes_read);
+
+        // each append waits for its data transfer while holding its slot,
+        // so that some of the others found the queue full
+        auto stats = nlohmann::json::parse(admin.getStatistics(addr, 2));
+        CPPUNIT_ASSERT(stats["admission"]["tenants"]["default"]["rejected"].get<int>() > 0);
+
+        admin.destroySequencer(addr, 2, busy_id);
+    }
+
+    void testPriorities() {
+        mobject::Admin admin(engine);
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+        // a provider that executes one request at a time, earliest deadline first
+        mobject::Provider edf_provider(engine, 2,
+            "{ \"admission\" : { \"max_in_flight\" : 1, \"policy\" : \"edf\" } }");
+
+        auto edf_id = admin.createSequencer(addr, 2, sequencer_type, sequencer_config);
+        auto interactive = client.makeSequencerHandle(addr, 2, edf_id)
+                                 .withPriority(mobject::Priority::INTERACTIVE);
+        auto batch = interactive.withPriority(mobject::Priority::BATCH)
+                                .withTimeout(std::chrono::milliseconds(10000));
+
+        // requests of all classes and deadlines complete
+        const size_t num_records = 16;
+        std::vector<std::string> records(num_records);
+        std::vector<mobject::AsyncRequest> requests(num_records);
+        for(size_t i = 0; i < num_records; i++) {
+            records[i] = "record-" + std::to_string(100 + i) + ";";
+            auto& handle = i % 2 ? batch : interactive;
+            handle.append("log", records[i].data(), records[i].size(),
+                          nullptr, &requests[i]);
+        }
+        for(auto& request : requests) {
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "appends of all priority classes should succeed.",
+                    request.wait());
+        }
+        std::string buffer(num_records * records[0].size(), '\0');
+        size_t bytes_read = 0;
+        batch.read("log", 0, &buffer[0], buffer.size(), &bytes_read);
+        CPPUNIT_ASSERT_EQUAL(buffer.size(), bytes_read);
+
+        // a provider whose data lane only starts once batch appends and
+        // then an interactive one are waiting in its pool: the first batch
+        // append holds the only slot during its data transfer, the others
+        // queue, and the interactive append, whose deadline is earlier, is
+        // the next one to run
+        auto pool = thallium::pool::create(thallium::pool::access::mpmc);
+        std::vector<thallium::managed<thallium::xstream>> xstreams;
+        {
+            mobject::Provider queued_provider(engine, 3,
+                "{ \"lanes\" : { \"admin\" : { \"xstreams\" : 1 }, \"control\" : { \"xstreams\" : 1 } },"
+                "  \"admission\" : { \"max_in_flight\" : 1, \"policy\" : \"edf\", \"max_queue_ms\" : 10000,"
+                "                    \"budgets_ms\" : { \"interactive\" : 10, \"batch\" : 5000 } } }",
+                *pool);
+            auto queued_id = admin.createSequencer(addr, 3, sequencer_type, sequencer_config);
+            auto queued_interactive = client.makeSequencerHandle(addr, 3, queued_id)
+                                            .withPriority(mobject::Priority::INTERACTIVE);
+            auto queued_batch = queued_interactive.withPriority(mobject::Priority::BATCH)
+                                                  .withTimeout(std::chrono::milliseconds(10000));
+
+            const size_t num_batch = 8;
+            std::string record = "record;";
+            std::vector<uint64_t> offsets(num_batch + 1);
+            std::vector<mobject::AsyncRequest> queued(num_batch + 1);
+            for(size_t i = 0; i < num_batch; i++) {
+                queued_batch.append("log", record.data(), record.size(), &offsets[i], &queued[i]);
+            }
+            queued_interactive.append("log", record.data(), record.size(),
+                                      &offsets[num_batch], &queued[num_batch]);
+            while(pool->total_size() < num_batch + 1)
+                thallium::thread::sleep(engine, 1);
+            xstreams.push_back(thallium::xstream::create(
+                thallium::scheduler::predef::basic_wait, *pool));
+            for(auto& request : queued)
+                CPPUNIT_ASSERT_NO_THROW(request.wait());
+
+            size_t served_before = std::count_if(offsets.begin(), offsets.begin() + num_batch,
+                    [&offsets](uint64_t offset) { return offset < offsets[num_batch]; });
+            CPPUNIT_ASSERT_EQUAL((size_t)1, served_before);
+
+            admin.destroySequencer(addr, 3, queued_id);
+        }
+
+        CPPUNIT_ASSERT_THROW_MESSAGE("a provider should not accept an unknown policy",
+                mobject::Provider(engine, 3, "{ \"admission\" : { \"policy\" : \"lifo\" } }"),
+                mobject::Exception);
+
+        admin.destroySequencer(addr, 2, edf_id);
+    }
+
+    void testTenants() {
+        mobject::Admin admin(engine);
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+        // a provider on which the "analytics" tenant may run one operation
+        // per 100ms and must present a token
+        mobject::Provider tenant_provider(engine, 2,
+            "{ \"admission\" : { \"policy\" : \"wfq\", \"tenants\" : {"
+            "  \"analytics\" : { \"weight\" : 2, \"ops_per_sec\" : 10, \"burst_sec\" : 0.1, \"token\" : \"secret\" } } } }");
+
+        auto tenant_id = admin.createSequencer(addr, 2, sequencer_type, sequencer_config);
+        auto my_sequencer = client.makeSequencerHandle(addr, 2, tenant_id, false);
+
+        std::string record = "record;";
+        client.setTenant("analytics", "wrong");
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "requests with an invalid tenant token should be rejected.",
+                my_sequencer.append("log", record.data(), record.size()),
+                mobject::Exception);
+
+        // the quota lets an operation run as long as the bucket is not
+        // empty, so the second append puts it in debt and the third one
+        // exceeds it; the client sends it again once the quota has been
+        // refilled, at least 100ms after the first one
+        client.setTenant("analytics", "secret");
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < 3; i++)
+            CPPUNIT_ASSERT_NO_THROW(my_sequencer.append("log", record.data(), record.size()));
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+        CPPUNIT_ASSERT(elapsed.count() >= 90);
+
+        // unknown tenants are accounted to "default"
+        client.setTenant("unknown");
+        CPPUNIT_ASSERT_NO_THROW(my_sequencer.append("log", record.data(), record.size()));
+
+        auto stats = nlohmann::json::parse(admin.getStatistics(addr, 2));
+        auto& tenants = stats["admission"]["tenants"];
+        CPPUNIT_ASSERT_EQUAL(3, tenants["analytics"]["admitted"].get<int>());
+        CPPUNIT_ASSERT(tenants["analytics"]["throttled"].get<int>() >= 1);
+        CPPUNIT_ASSERT_EQUAL(1, tenants["default"]["admitted"].get<int>());
+
+        client.setTenant("");
+        admin.destroySequencer(addr, 2, tenant_id);
+
+        // a provider that runs one request at a time, and whose data lane
+        // only starts once both tenants have appends waiting in its pool:
+        // the "heavy" tenant, of weight 3, gets 3 out of 4 of the slots
+        // until its appends run out
+        auto pool = thallium::pool::create(thallium::pool::access::mpmc);
+        std::vector<thallium::managed<thallium::xstream>> xstreams;
+        {
+            mobject::Provider shared_provider(engine, 3,
+                "{ \"lanes\" : { \"admin\" : { \"xstreams\" : 1 }, \"control\" : { \"xstreams\" : 1 } },"
+                "  \"admission\" : { \"max_in_flight\" : 1, \"policy\" : \"wfq\", \"max_queue_ms\" : 10000,"
+                "                    \"tenants\" : { \"heavy\" : { \"weight\" : 3 }, \"light\" : { \"weight\" : 1 } } } }",
+                *pool);
+            auto shared_id = admin.createSequencer(addr, 3, sequencer_type, sequencer_config);
+            mobject::Client heavy_client(engine);
+            mobject::Client light_client(engine);
+            heavy_client.setTenant("heavy");
+            light_client.setTenant("light");
+            auto heavy = heavy_client.makeSequencerHandle(addr, 3, shared_id);
+            auto light = light_client.makeSequencerHandle(addr, 3, shared_id);
+
+            // both tenants append records of the same size, alternately
+            const size_t num_records = 16;
+            std::vector<uint64_t> offsets(num_records);
+            std::vector<mobject::AsyncRequest> requests(num_records);
+            for(size_t i = 0; i < num_records; i++) {
+                auto& handle = i % 2 ? heavy : light;
+                handle.append("log", record.data(), record.size(), &offsets[i], &requests[i]);
+            }
+            while(pool->total_size() < num_records)
+                thallium::thread::sleep(engine, 1);
+            xstreams.push_back(thallium::xstream::create(
+                thallium::scheduler::predef::basic_wait, *pool));
+            for(auto& request : requests)
+                CPPUNIT_ASSERT_NO_THROW(request.wait());
+
+            // the first append (of "light") ran as soon as it arrived; of the
+            // next 8, which were admitted from the queue, "heavy" got 6
+            // (7 when rounding makes some of its appends tie with "light")
+            size_t heavy_served = 0;
+            for(size_t i = 1; i < num_records; i += 2) {
+                uint64_t position = offsets[i] / record.size();
+                if(position >= 1 && position <= 8) heavy_served += 1;
+            }
+            CPPUNIT_ASSERT(heavy_served >= 6 && heavy_served <= 7);
+
+            admin.destroySequencer(addr, 3, shared_id);
+        }
+    }
+
+    void testPosted() {
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+        // a small window, so that posting also waits for the provider
+        client.setPostedWindow(4);
+        auto my_sequencer = client.makeSequencerHandle(addr, 0, sequencer_id);
+        auto posted = my_sequencer.withPosting();
+
+        // posted appends are applied in the order they were posted and
+        // are all applied once flush returns, and the caller's buffer
+        // can be reused as soon as they return
+        const size_t num_records = 32;
+        std::string expected;
+        std::string record;
+        for(size_t i = 0; i < num_records; i++) {
+            record = "record-" + std::to_string(100 + i) + ";";
+            CPPUNIT_ASSERT_NO_THROW(posted.append("log", record.data(), record.size()));
+            expected += record;
+            record.assign(record.size(), '#');
+        }
+        std::string data = "posted";
+        CPPUNIT_ASSERT_NO_THROW(posted.write("other", 0, data.data(), data.size()));
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "flush should not throw when the posted operations succeeded.",
+                my_sequencer.flush());
+
+        std::string buffer(expected.size(), '\0');
+        size_t bytes_read = 0;
+        my_sequencer.read("log", 0, &buffer[0], buffer.size(), &bytes_read);
+        CPPUNIT_ASSERT_EQUAL(expected.size(), bytes_read);
+        CPPUNIT_ASSERT_EQUAL(expected, buffer);
+        buffer.assign(data.size(), '\0');
+        my_sequencer.read("other", 0, &buffer[0], buffer.size(), &bytes_read);
+        CPPUNIT_ASSERT_EQUAL(data, buffer);
+
+        uint64_t offset;
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "posted appends should not return an offset.",
+                posted.append("log", data.data(), data.size(), &offset),
+                mobject::Exception);
+
+        // errors of posted operations are reported by flush
+        auto bad_sequencer = client.makeSequencerHandle(
+                addr, 0, mobject::UUID::generate(), false).withPosting();
+        CPPUNIT_ASSERT_NO_THROW(bad_sequencer.write("other", 0, data.data(), data.size()));
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "flush should report the errors of posted operations.",
+                bad_sequencer.flush(),
+                mobject::Exception);
+
+        // a provider that forgets the streams unused for 50ms loses
+        // nothing, since a stream is not used again once flushed
+        mobject::Admin admin(engine);
+        mobject::Provider forgetful_provider(engine, 2,
+            "{ \"posted\" : { \"turn_timeout_ms\" : 1000, \"idle_timeout_ms\" : 50 } }");
+        auto forgetful_id = admin.createSequencer(addr, 2, sequencer_type, sequencer_config);
+        auto forgetful = client.makeSequencerHandle(addr, 2, forgetful_id).withPosting();
+        for(int i = 0; i < 3; i++) {
+            CPPUNIT_ASSERT_NO_THROW(forgetful.append("log", data.data(), data.size()));
+            CPPUNIT_ASSERT_NO_THROW(forgetful.append("log", data.data(), data.size()));
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "flush should not report operations of forgotten streams.",
+                    forgetful.flush());
+            thallium::thread::sleep(engine, 100);
+        }
+        buffer.assign(6 * data.size(), '\0');
+        forgetful.read("log", 0, &buffer[0], buffer.size(), &bytes_read);
+        CPPUNIT_ASSERT_EQUAL(buffer.size(), bytes_read);
+        admin.destroySequencer(addr, 2, forgetful_id);
+    }
+
 };
 CPPUNIT_TEST_SUITE_REGISTRATION( SequencerTest );
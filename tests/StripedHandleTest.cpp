@@ -0,0 +1,140 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <mobject/Client.hpp>
+#include <mobject/Admin.hpp>
+#include <mobject/StripedHandle.hpp>
+
+extern thallium::engine engine;
+extern std::string sequencer_type;
+
+class StripedHandleTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( StripedHandleTest );
+    CPPUNIT_TEST( testMakeStripedHandle );
+    CPPUNIT_TEST( testWriteRead );
+    CPPUNIT_TEST( testHoles );
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr const char* sequencer_config = "{ \"path\" : \"mydb\" }";
+    std::vector<mobject::UUID> sequencer_ids;
+
+    public:
+
+    void setUp() {
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        for(int i = 0; i < 3; i++)
+            sequencer_ids.push_back(admin.createSequencer(addr, 0, sequencer_type, sequencer_config));
+    }
+
+    void tearDown() {
+        mobject::Admin admin(engine);
+        std::string addr = engine.self();
+        for(auto& id : sequencer_ids)
+            admin.destroySequencer(addr, 0, id);
+        sequencer_ids.clear();
+    }
+
+    std::vector<mobject::SequencerHandle> makeSequencerHandles() {
+        mobject::Client client(engine);
+        std::string addr = engine.self();
+        std::vector<mobject::SequencerHandle> handles;
+        for(auto& id : sequencer_ids)
+            handles.push_back(client.makeSequencerHandle(addr, 0, id));
+        return handles;
+    }
+
+    void testMakeStripedHandle() {
+        auto handles = makeSequencerHandles();
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "StripedHandle constructor should not throw with a valid configuration.",
+                mobject::StripedHandle(handles, "{ \"stripe_unit\" : 16 }"));
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "StripedHandle constructor should throw if stripe_width is too large.",
+                mobject::StripedHandle(handles, "{ \"stripe_width\" : 4 }"),
+                mobject::Exception);
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "StripedHandle constructor should throw without sequencers.",
+                mobject::StripedHandle({}, "{}"),
+                mobject::Exception);
+    }
+
+    void testWriteRead() {
+        auto handles = makeSequencerHandles();
+        // small stripe unit and max_in_flight to exercise splitting and windowing
+        mobject::StripedHandle striped(handles,
+            "{ \"stripe_unit\" : 16, \"stripe_width\" : 3, \"max_in_flight\" : 2 }");
+
+        std::string data;
+        for(int i = 0; i < 20; i++) data += "chunk" + std::to_string(i) + ";";
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "striped.write() should not throw.",
+                striped.write("checkpoint", 5, data.data(), data.size()));
+
+        std::string buffer(data.size() + 100, 'x');
+        size_t bytes_read = 0;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "striped.read() should not throw.",
+                striped.read("checkpoint", 5, &buffer[0], buffer.size(), &bytes_read));
+        CPPUNIT_ASSERT_EQUAL(data.size(), bytes_read);
+        buffer.resize(bytes_read);
+        CPPUNIT_ASSERT_EQUAL(data, buffer);
+
+        // every sequencer holds part of the object
+        for(auto& h : handles) {
+            char c;
+            size_t n = 0;
+            h.read("checkpoint", 0, &c, 1, &n);
+            CPPUNIT_ASSERT_EQUAL((size_t)1, n);
+        }
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "striped.remove() should not throw.",
+                striped.remove("checkpoint"));
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "striped.read() should throw on a removed object.",
+                striped.read("checkpoint", 0, &buffer[0], buffer.size()),
+                mobject::Exception);
+    }
+
+    void testHoles() {
+        auto handles = makeSequencerHandles();
+        mobject::StripedHandle striped(handles, "{ \"stripe_unit\" : 8 }");
+
+        striped.write("sparse", 0, "AB", 2);
+        striped.write("sparse", 40, "CD", 2);
+
+        std::string buffer(64, 'x');
+        size_t bytes_read = 0;
+        striped.read("sparse", 0, &buffer[0], buffer.size(), &bytes_read);
+        CPPUNIT_ASSERT_EQUAL((size_t)42, bytes_read);
+        CPPUNIT_ASSERT_EQUAL(std::string("AB") + std::string(38, '\0') + "CD",
+                             buffer.substr(0, bytes_read));
+
+        // the second stripe unit is a hole on a sequencer that was never
+        // written to, and the object extends past it
+        buffer.assign(8, 'x');
+        striped.read("sparse", 8, &buffer[0], buffer.size(), &bytes_read);
+        CPPUNIT_ASSERT_EQUAL((size_t)8, bytes_read);
+        CPPUNIT_ASSERT_EQUAL(std::string(8, '\0'), buffer);
+
+        buffer.assign(64, 'x');
+        striped.read("sparse", 36, &buffer[0], buffer.size(), &bytes_read);
+        CPPUNIT_ASSERT_EQUAL((size_t)6, bytes_read);
+        CPPUNIT_ASSERT_EQUAL(std::string(4, '\0') + "CD", buffer.substr(0, bytes_read));
+
+        striped.remove("sparse");
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "striped.read() should throw on a removed object.",
+                striped.read("sparse", 8, &buffer[0], 8),
+                mobject::Exception);
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( StripedHandleTest );